@@ -0,0 +1,19 @@
+#pragma once
+
+/**
+* lazy versions of check and require_find
+* the error message is only built if the check fails, so nothing is formatted or allocated on the success path
+* e.g. check_or( is_cpu_contract(c), [&]{ return c.to_string() + " is not a cpu rental contract"; } );
+*/
+
+template<typename MessageBuilder>
+inline void check_or(const bool& condition, MessageBuilder&& build_message){
+  if( !condition ) eosio::check( false, build_message() );
+}
+
+template<typename Table, typename MessageBuilder>
+inline auto require_find_or(const Table& table, const uint64_t& primary_key, MessageBuilder&& build_message){
+  auto itr = table.find( primary_key );
+  if( itr == table.end() ) eosio::check( false, build_message() );
+  return itr;
+}
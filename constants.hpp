@@ -1,5 +1,8 @@
 #pragma once
 
+//Read only action versions
+static constexpr uint8_t DASHBOARD_VERSION = 2;
+
 //Numeric Limits
 static constexpr int64_t MAX_ASSET_AMOUNT = 4611686018427387903;
 static constexpr uint64_t MAX_ASSET_AMOUNT_U64 = 4611686018427387903;
@@ -27,12 +30,38 @@ static const eosio::asset ZERO_WAX = eosio::asset(0, WAX_SYMBOL);
 //Other
 
 static constexpr uint64_t ONE_HUNDRED_PERCENT_1E6 = 100000000;
+static constexpr int64_t ONE_SWAX_AMOUNT = 100000000; /* 1 sWAX/lsWAX/WAX at 8 decimals */
+static constexpr uint64_t INSTAREDEEM_FEE_1E6 = 5000; /* 0.05% */
 static constexpr uint64_t LP_FARM_DURATION_SECONDS = 604800; /* 1 week */
 static constexpr uint64_t INITIAL_EPOCH_START_TIMESTAMP = 1710460800; /* 3/15/2024 00:00:00 GMT */
 static constexpr uint64_t MAXIMUM_WAX_TO_RENT = 10000000; /* 10 Million WAX */
 static constexpr uint64_t MINIMUM_PRODUCERS_TO_VOTE_FOR = 16;
 static constexpr uint64_t MINIMUM_WAX_TO_RENT = 10; /* 10 WAX */
 
+//Reward routes, applied to rewards during sync_user
+static constexpr uint8_t REWARD_ROUTE_CLAIMABLE_WAX = 0;
+static constexpr uint8_t REWARD_ROUTE_COMPOUND_SWAX = 1;
+static constexpr uint8_t REWARD_ROUTE_CONVERT_LSWAX = 2;
+
+//State snapshot rings, used until setsnaptiers is called
+static constexpr std::array<snapshot_tier, 3> DEFAULT_SNAPSHOT_TIERS = {{
+	{ 60 * 30, 336 },		/* 30 minutes, 1 week */
+	{ 60 * 60 * 4, 540 },	/* 4 hours, 90 days */
+	{ 60 * 60 * 24, 730 }	/* 1 day, 2 years */
+}};
+static constexpr uint64_t MAX_SNAPSHOT_TIERS = 5;
+static constexpr uint64_t MAX_SNAPSHOT_TIER_CAPACITY = 2000;
+
+//lsWAX rate history rings, written once per distribution
+static constexpr std::array<snapshot_tier, 2> RATE_HISTORY_TIERS = {{
+	{ 60 * 60 * 24, 400 },		/* 1 day, ~13 months */
+	{ 60 * 60 * 24 * 7, 520 }	/* 1 week, 10 years */
+}};
+static constexpr uint64_t SECONDS_PER_YEAR = 60 * 60 * 24 * 365;
+
+//Distribution snapshots per snappages row
+static constexpr uint64_t SNAPSHOT_PAGE_SIZE = 64;
+
 //System Contract
 static constexpr uint32_t SECONDS_PER_DAY = 24 * 3600;
 static constexpr uint32_t REFUND_DELAY_SEC = 3 * SECONDS_PER_DAY;
@@ -1,17 +1,94 @@
 #pragma once
 
+/**
+* accrue_rewards
+* releases the portion of rewards_remaining that has streamed since last_update_time
+* and adds it to the reward_per_swax_1e12 accumulator
+* if there is no sWAX earning, nothing is released and the remainder carries over
+*/
+
+void fusion::accrue_rewards(rewards& rw, const int64_t& swax_earning){
+  const uint64_t accrue_until = std::min( now(), rw.period_finish );
+
+  if( accrue_until <= rw.last_update_time ) return;
+
+  if( rw.rewards_remaining.amount > 0 && swax_earning > 0 ){
+    int64_t streamed_amount = internal_get_streamed_rewards( rw.rewards_remaining.amount, accrue_until - rw.last_update_time, rw.period_finish - rw.last_update_time );
+
+    if( streamed_amount > 0 ){
+      rw.reward_per_swax_1e12 += internal_get_reward_per_swax( streamed_amount, swax_earning );
+      rw.rewards_remaining.amount = safeSubInt64( rw.rewards_remaining.amount, streamed_amount );
+    }
+  }
+
+  rw.last_update_time = accrue_until;
+  return;
+}
+
 void fusion::create_alcor_farm(const uint64_t& poolId, const eosio::symbol& token_symbol, const eosio::name& token_contract){
+  INSTRUMENT_COUNT(inline_actions);
   action(permission_level{get_self(), "active"_n}, ALCOR_CONTRACT,"newincentive"_n,
       std::tuple{ get_self(), poolId, eosio::extended_asset(ZERO_LSWAX, TOKEN_CONTRACT), (uint32_t) LP_FARM_DURATION_SECONDS}
     ).send();
   return;
 }
 
+/**
+* credit_route_payout
+* adds converted lsWAX to the user's routepayouts row, the contract pays for the row
+* since this runs during syncs the user may not have signed
+*/
+
+void fusion::credit_route_payout(const eosio::name& user, const int64_t& lswax_amount){
+  auto itr = route_payouts_t.find(user.value);
+
+  if( itr == route_payouts_t.end() ){
+    route_payouts_t.emplace(_self, [&](auto &_r){
+      _r.wallet = user;
+      _r.lswax_owed = eosio::asset(lswax_amount, LSWAX_SYMBOL);
+    });
+  } else {
+    route_payouts_t.modify(itr, same_payer, [&](auto &_r){
+      _r.lswax_owed.amount = safeAddInt64(_r.lswax_owed.amount, lswax_amount);
+    });
+  }
+
+  settlements st = get_settlements();
+  st.route_lswax_pending->amount = safeAddInt64( st.route_lswax_pending->amount, lswax_amount );
+  settlements_s.set(st, _self);
+}
+
+/**
+* credit_settlements
+* records allocations in the settlements ledger so they can be sent in a single 
+* transfer/issue when settle_allocations is called
+* incentives stay WAX until then, so no lsWAX is counted in state before it is issued
+*/
+
+void fusion::credit_settlements(const int64_t& pol_wax_amount, const int64_t& incentives_wax_amount){
+  settlements st = get_settlements();
+
+  st.pol_wax_pending.amount = safeAddInt64( st.pol_wax_pending.amount, pol_wax_amount );
+  st.incentives_wax_pending->amount = safeAddInt64( st.incentives_wax_pending->amount, incentives_wax_amount );
+
+  settlements_s.set(st, _self);
+
+  //pending pol allocations are still owed
+  if( pol_wax_amount > 0 ){
+    state3 s3 = state_s_3.get();
+    s3.total_wax_owed.amount = safeAddInt64( s3.total_wax_owed.amount, pol_wax_amount );
+    state_s_3.set(s3, _self);
+  }
+
+  return;
+}
+
 void fusion::credit_total_claimable_wax(const eosio::asset& amount_to_credit){
   if(amount_to_credit.amount > 0 && amount_to_credit.amount <= MAX_ASSET_AMOUNT_U64){
     state3 s3 = state_s_3.get();
 
     s3.total_claimable_wax.amount = safeAddInt64( s3.total_claimable_wax.amount, amount_to_credit.amount );
+    s3.total_wax_owed.amount = safeAddInt64( s3.total_wax_owed.amount, amount_to_credit.amount );
 
     state_s_3.set(s3, _self);
   }
@@ -23,6 +100,7 @@ void fusion::debit_total_claimable_wax(const eosio::asset& amount_to_debit){
     state3 s3 = state_s_3.get();
 
     s3.total_claimable_wax.amount = safeSubInt64( s3.total_claimable_wax.amount, amount_to_debit.amount );
+    s3.total_wax_owed.amount = safeSubInt64( s3.total_wax_owed.amount, amount_to_debit.amount );
 
     state_s_3.set(s3, _self);
   }
@@ -39,7 +117,7 @@ void fusion::debit_user_redemptions_if_necessary(const name& user, const asset&
   eosio::asset total_amount_awaiting_redemption = eosio::asset( 0, WAX_SYMBOL );
   uint64_t first_epoch_to_check = s.last_epoch_start_time - c.seconds_between_epochs;
 
-  std::vector<uint64_t> epochs_to_check = { //reversed since we want to debit the farthest epochs if needed
+  std::array<uint64_t, 3> epochs_to_check = { //reversed since we want to debit the farthest epochs if needed
     first_epoch_to_check + ( c.seconds_between_epochs * 2 ),
     first_epoch_to_check + c.seconds_between_epochs,
     first_epoch_to_check
@@ -126,7 +204,123 @@ uint64_t fusion::days_to_seconds(const uint64_t& days){
   return (uint64_t) SECONDS_PER_DAY * days;
 }
 
-uint64_t fusion::get_seconds_to_rent_cpu( state s, config3 c, const uint64_t& epoch_id_to_rent_from ){
+/**
+* get_accrued_rewards
+* the rewards singleton as it would be after accruing up to now(), without saving it
+*/
+
+rewards fusion::get_accrued_rewards(){
+  rewards rw = get_rewards();
+  state s = states.get();
+
+  accrue_rewards( rw, s.swax_currently_earning.amount );
+  return rw;
+}
+
+/**
+* get_live_epochs
+* the 3 epochs that redemption requests can currently be placed in, and how much each can still cover
+* same epochs that reqredeem checks
+*/
+
+std::vector<epoch_capacity> fusion::get_live_epochs(const state& s, const config3& c){
+  std::vector<epoch_capacity> live_epochs {};
+
+  const uint64_t first_epoch = s.last_epoch_start_time - c.seconds_between_epochs;
+
+  for(uint64_t i = 0; i < 3; i++){
+    auto epoch_itr = epochs_t.find( first_epoch + ( c.seconds_between_epochs * i ) );
+    if( epoch_itr == epochs_t.end() ) continue;
+
+    epoch_capacity e{};
+    e.epoch_id = epoch_itr->start_time;
+    e.redemption_period_start_time = epoch_itr->redemption_period_start_time;
+    e.redemption_period_end_time = epoch_itr->redemption_period_end_time;
+    e.wax_bucket = epoch_itr->wax_bucket;
+    e.wax_to_refund = epoch_itr->wax_to_refund;
+    e.available_for_redemption = ZERO_WAX;
+
+    if( epoch_itr->redemption_period_start_time > now() && epoch_itr->wax_to_refund < epoch_itr->wax_bucket ){
+      e.available_for_redemption.amount = safeSubInt64(epoch_itr->wax_bucket.amount, epoch_itr->wax_to_refund.amount);
+    }
+
+    live_epochs.push_back(e);
+  }
+
+  return live_epochs;
+}
+
+/**
+* get_lswax_rate_1e12
+* amount of sWAX backing 1 lsWAX, scaled by 1e12
+*/
+
+uint64_t fusion::get_lswax_rate_1e12(const state& s){
+  if( s.liquified_swax.amount == 0 ) return (uint64_t) SCALE_FACTOR_1E12;
+
+  uint128_t result_128 = safe_math::muldiv( (uint128_t) s.swax_currently_backing_lswax.amount, SCALE_FACTOR_1E12, (uint128_t) s.liquified_swax.amount );
+  return safe_math::to_uint64( result_128 );
+}
+
+/**
+* get_pending_rewards
+* WAX a staker has earned since their last sync, rw should already be accrued
+* doesn't modify any tables, so it's safe to use from read only actions
+*/
+
+int64_t fusion::get_pending_rewards(const stakers& staker, const rewards& rw){
+  /* if they have no staked sWAX, they get 0 */
+  if(staker.swax_balance.amount == 0) return 0;
+
+  int64_t wax_owed_to_user = 0; 
+
+  //anything from before streaming started is paid out from the snapshots table
+  if(staker.last_update < rw.streaming_start_time){
+    uint64_t paid_through;
+    wax_owed_to_user = get_snapshot_rewards(staker.swax_balance.amount, staker.last_update, rw.streaming_start_time, paid_through);
+  }
+
+  //rows that have not synced since streaming started have an implicit reward_per_swax_paid of 0
+  const uint128_t reward_per_swax_delta = rw.reward_per_swax_1e12 - staker.reward_per_swax_paid_1e12.value_or();
+  int64_t streamed_allocation = internal_get_earned_rewards(staker.swax_balance.amount, reward_per_swax_delta);
+
+  return safeAddInt64(wax_owed_to_user, streamed_allocation);
+}
+
+/**
+* get_rewards
+* the rewards singleton, or what initrewards would create if it hasn't been called yet
+* the first sync_rewards after an upgrade saves it, so nothing has to wait for initrewards
+*/
+
+rewards fusion::get_rewards(){
+  if( rewards_s.exists() ) return rewards_s.get();
+
+  rewards rw{};
+  rw.streaming_start_time = states.get().next_distribution;
+  rw.last_update_time = now();
+  rw.period_finish = now();
+  rw.rewards_remaining = ZERO_WAX;
+  rw.reward_per_swax_1e12 = 0;
+  return rw;
+}
+
+/**
+* get_settlements
+* the settlements singleton with the extensions filled in, they are empty on the row
+* initsettle wrote before sWAX supply and incentives were tracked there
+*/
+
+settlements fusion::get_settlements(){
+  settlements st = settlements_s.get();
+  if( !st.swax_pending_issue.has_value() ) st.swax_pending_issue = ZERO_SWAX;
+  if( !st.swax_pending_retire.has_value() ) st.swax_pending_retire = ZERO_SWAX;
+  if( !st.incentives_wax_pending.has_value() ) st.incentives_wax_pending = ZERO_WAX;
+  if( !st.route_lswax_pending.has_value() ) st.route_lswax_pending = ZERO_LSWAX;
+  return st;
+}
+
+uint64_t fusion::get_seconds_to_rent_cpu( const state& s, const config3& c, const uint64_t& epoch_id_to_rent_from ){
       uint64_t eleven_days = 60 * 60 * 24 * 11;
       uint64_t seconds_into_current_epoch = now() - s.last_epoch_start_time;
 
@@ -198,14 +392,162 @@ uint64_t fusion::get_seconds_to_rent_cpu( state s, config3 c, const uint64_t& ep
       return seconds_to_rent;
 }
 
+/**
+* get_snapshot
+* finds the distribution snapshot at timestamp in snappages or the snapshots table
+* returns an empty snapshot (with timestamp 0) if there isn't one
+*/
+
+snapshots fusion::get_snapshot(const uint64_t& timestamp){
+  config3 c = config_s_3.get();
+
+  snapshots snap{};
+  snap.timestamp = 0;
+
+  const uint64_t period = timestamp / c.seconds_between_distributions;
+  auto page_itr = snap_pages_t.find( period / SNAPSHOT_PAGE_SIZE );
+
+  if( page_itr != snap_pages_t.end() && page_itr->phase_seconds == timestamp % c.seconds_between_distributions ){
+    const uint64_t slot = period % SNAPSHOT_PAGE_SIZE;
+
+    snap.timestamp = timestamp;
+    snap.swax_earning_bucket = asset(page_itr->swax_earning_bucket[slot], WAX_SYMBOL);
+    snap.lswax_autocompounding_bucket = asset(page_itr->lswax_autocompounding_bucket[slot], WAX_SYMBOL);
+    snap.pol_bucket = asset(page_itr->pol_bucket[slot], WAX_SYMBOL);
+    snap.ecosystem_bucket = asset(page_itr->ecosystem_bucket[slot], WAX_SYMBOL);
+    snap.total_distributed = asset(page_itr->total_distributed[slot], WAX_SYMBOL);
+    snap.total_swax_earning = asset(page_itr->total_swax_earning[slot], SWAX_SYMBOL);
+    return snap;
+  }
+
+  auto snap_itr = snaps_t.find( timestamp );
+  if( snap_itr != snaps_t.end() ) return *snap_itr;
+
+  return snap;
+}
+
+/**
+* get_snapshot_rewards
+* pays out the snapshots that were created before reward streaming started
+* only users who haven't synced since then will ever need to loop through these
+* migratesnaps moves the oldest rows first, so any unmigrated snapshots rows sit
+* between older and newer snappages, and are read in that order
+* paid_through is set to the last timestamp that was fully paid, which is before
+* snapshots_end if max_snapshots_to_process was reached
+*/
+
+int64_t fusion::get_snapshot_rewards(const int64_t& swax_balance, const uint64_t& last_update, const uint64_t& snapshots_end, uint64_t& paid_through){
+  const uint64_t lower_bound_timestamp = last_update + 1;
+
+  paid_through = last_update;
+  if(lower_bound_timestamp >= snapshots_end) return 0;
+
+  config3 c = config_s_3.get();
+
+  int count = 0;
+  int64_t wax_owed_to_user = 0; 
+
+  //returns false once max_snapshots_to_process has been reached
+  auto add_snapshot = [&](const uint64_t& timestamp, const int64_t& swax_earning_bucket, const int64_t& total_swax_earning){
+    //only calculate if there was sWAX earning
+    if(swax_earning_bucket > 0 && total_swax_earning > 0){
+      int64_t wax_allocation = internal_get_wax_owed_to_user(swax_balance, total_swax_earning, swax_earning_bucket);
+      wax_owed_to_user = safeAddInt64(wax_owed_to_user, wax_allocation);
+    }
+
+    INSTRUMENT_COUNT(snapshots_iterated);
+    paid_through = timestamp;
+    count ++;
+    return count < c.max_snapshots_to_process;
+  };
+
+  //pages from start up to (but not including) end
+  auto add_pages = [&](const uint64_t& start, const uint64_t& end){
+    const uint64_t first_period = start / c.seconds_between_distributions;
+
+    for(auto page_itr = snap_pages_t.lower_bound( first_period / SNAPSHOT_PAGE_SIZE ); page_itr != snap_pages_t.end(); page_itr++){
+      for(uint64_t i = 0; i < SNAPSHOT_PAGE_SIZE; i++){
+        const uint64_t timestamp = ( page_itr->page * SNAPSHOT_PAGE_SIZE + i ) * c.seconds_between_distributions + page_itr->phase_seconds;
+
+        if(timestamp < start) continue;
+        if(timestamp >= end) return true;
+
+        //empty slots are periods that had no distribution
+        if(page_itr->swax_earning_bucket[i] == 0) continue;
+        if( !add_snapshot(timestamp, page_itr->swax_earning_bucket[i], page_itr->total_swax_earning[i]) ) return false;
+      }
+    }
+
+    return true;
+  };
+
+  if(snaps_t.begin() == snaps_t.end()){
+    if( !add_pages(lower_bound_timestamp, snapshots_end) ) return wax_owed_to_user;
+
+    paid_through = snapshots_end - 1;
+    return wax_owed_to_user;
+  }
+
+  const uint64_t first_row_timestamp = snaps_t.begin()->timestamp;
+  auto last_row_itr = snaps_t.end();
+  last_row_itr --;
+  const uint64_t last_row_timestamp = last_row_itr->timestamp;
+
+  if( !add_pages(lower_bound_timestamp, std::min(snapshots_end, first_row_timestamp)) ) return wax_owed_to_user;
+
+  for(auto it = snaps_t.lower_bound( lower_bound_timestamp ); it != snaps_t.end() && it->timestamp < snapshots_end; it++){
+    if( !add_snapshot(it->timestamp, it->swax_earning_bucket.amount, it->total_swax_earning.amount) ) return wax_owed_to_user;
+  }
+
+  if( !add_pages(std::max(lower_bound_timestamp, last_row_timestamp + 1), snapshots_end) ) return wax_owed_to_user;
+
+  paid_through = snapshots_end - 1;
+  return wax_owed_to_user;
+}
+
+std::vector<snapshot_tier> fusion::get_snapshot_tiers(){
+  if( !snaptiers_s.exists() ) return std::vector<snapshot_tier>( DEFAULT_SNAPSHOT_TIERS.begin(), DEFAULT_SNAPSHOT_TIERS.end() );
+  return snaptiers_s.get().tiers;
+}
+
+/**
+* get_staker_payer
+* rows written before reward_per_swax_paid_1e12/reward_route existed grow when they are saved,
+* since binary extensions are always written. the contract pays for that (and takes over the row)
+* because the staker can't be billed during a notification or an action they didn't sign
+*/
+
+eosio::name fusion::get_staker_payer(const stakers& staker){
+  return staker.reward_route.has_value() ? same_payer : _self;
+}
+
+/**
+* get_wax_balance
+* returns 0 if the account has no WAX row
+*/
+
+int64_t fusion::get_wax_balance(const eosio::name& account){
+  accounts account_t = accounts(WAX_CONTRACT, account.value);
+  auto it = account_t.find(WAX_SYMBOL.code().raw());
+  return it == account_t.end() ? 0 : it->balance.amount;
+}
+
+prunestate fusion::get_prune_state(){
+  if( prune_s.exists() ) return prune_s.get();
+
+  prunestate p{};
+  p.pass_min_last_update = now();
+  return p;
+}
 
-std::vector<std::string> fusion::get_words(std::string memo){
-  std::string delim = "|";
-  std::vector<std::string> words{};
+memo_words fusion::get_words(std::string_view memo){
+  //only words followed by a | are kept, e.g. |rent_cpu|bob| -> "", "rent_cpu", "bob"
+  memo_words words{};
+  size_t start = 0;
   size_t pos = 0;
-  while ((pos = memo.find(delim)) != std::string::npos) {
-    words.push_back(memo.substr(0, pos));
-    memo.erase(0, pos + delim.length());
+  while ( words.count < memo_words::MAX_WORDS && (pos = memo.find('|', start)) != std::string_view::npos ) {
+    words.words[words.count++] = memo.substr(start, pos - start);
+    start = pos + 1;
   }
   return words;
 }
@@ -241,12 +583,22 @@ bool fusion::is_cpu_contract(const eosio::name& contract){
 }
 
 void fusion::issue_lswax(const int64_t& amount, const eosio::name& receiver){
+  INSTRUMENT_COUNT(inline_actions);
+  INVARIANT_DELTA(lswax_supply, amount);
   action(permission_level{get_self(), "active"_n}, TOKEN_CONTRACT,"issue"_n,std::tuple{ get_self(), receiver, eosio::asset(amount, LSWAX_SYMBOL), std::string("issuing lsWAX to liquify")}).send();
   return;
 }
 
+/**
+* issue_swax
+* sWAX only ever exists in this contract's balance, so new supply is recorded in the
+* settlements ledger and issued in bulk by settle_allocations
+*/
+
 void fusion::issue_swax(const int64_t& amount){
-  action(permission_level{get_self(), "active"_n}, TOKEN_CONTRACT,"issue"_n,std::tuple{ get_self(), get_self(), eosio::asset(amount, SWAX_SYMBOL), std::string("issuing sWAX for staking")}).send();
+  settlements st = get_settlements();
+  st.swax_pending_issue->amount = safeAddInt64( st.swax_pending_issue->amount, amount );
+  settlements_s.set(st, _self);
   return;
 }
 
@@ -255,27 +607,210 @@ bool fusion::memo_is_expected(const std::string& memo){
     return true;
   }
 
-  std::string memo_copy = memo;
-  std::vector<std::string> words = get_words(memo_copy);
+  const memo_words words = get_words(memo);
 
-  if( words[1] == "rent_cpu" || words[1] == "unliquify_exact" ){
+  if( words[1] == "rent_cpu" || words[1] == "unliquify_exact" || words[1] == "stake_liquify" || words[1] == "instant_redeem" ){
       return true;
   }  
 
   return false;
 }
 
+/**
+* memo_to_uint64
+* strict replacement for strtoull on memo input
+* only decimal digits are accepted, no sign, spaces, hex/octal prefixes or trailing text
+*/
+
+uint64_t fusion::memo_to_uint64(std::string_view word, const char* field){
+  check_or( !word.empty(), [&]{ return std::string(field) + " in memo is not a valid number"; } );
+
+  uint64_t result = 0;
+
+  for(const char& ch : word){
+    check_or( ch >= '0' && ch <= '9', [&]{ return std::string(field) + " in memo is not a valid number"; } );
+    const uint64_t digit = (uint64_t) ( ch - '0' );
+    check_or( result <= ( UINT64_MAX - digit ) / 10, [&]{ return std::string(field) + " in memo is out of range"; } );
+    result = result * 10 + digit;
+  }
+
+  return result;
+}
+
 uint64_t fusion::now(){
   return current_time_point().sec_since_epoch();
 }
 
+/**
+* state_wax_owed
+* the portion of total_wax_owed that is held in the state singleton
+* the rest is state3.total_claimable_wax and settlements.pol_wax_pending
+*/
+
+int64_t fusion::state_wax_owed(const state& s){
+  int64_t wax_owed = s.wax_available_for_rentals.amount;
+  wax_owed = safeAddInt64( wax_owed, s.revenue_awaiting_distribution.amount );
+  wax_owed = safeAddInt64( wax_owed, s.wax_for_redemption.amount );
+  wax_owed = safeAddInt64( wax_owed, s.user_funds_bucket.amount );
+  return wax_owed;
+}
+
+/**
+* record_wax_received / record_wax_sent
+* keep state3.contract_wax_balance and state2.total_value_locked up to date
+* as WAX enters and leaves the contract, without needing a full sync_tvl
+* movements between this contract, the cpu contracts and pol.fusion don't change TVL
+*/
+
+void fusion::record_wax_received(const int64_t& amount, const bool& changes_tvl){
+  state3 s3 = state_s_3.get();
+  s3.contract_wax_balance.amount = safeAddInt64( s3.contract_wax_balance.amount, amount );
+  state_s_3.set(s3, _self);
+
+  if( changes_tvl ){
+    state2 s2 = state_s_2.get();
+    s2.total_value_locked.amount = safeAddInt64( s2.total_value_locked.amount, amount );
+    state_s_2.set(s2, _self);
+  }
+
+  return;
+}
+
+void fusion::record_wax_sent(const eosio::name& receiver, const int64_t& amount){
+  state3 s3 = state_s_3.get();
+  s3.contract_wax_balance.amount = safeSubInt64( s3.contract_wax_balance.amount, amount );
+  state_s_3.set(s3, _self);
+
+  if( receiver != POL_CONTRACT && !is_cpu_contract(receiver) ){
+    state2 s2 = state_s_2.get();
+    s2.total_value_locked.amount = safeSubInt64( s2.total_value_locked.amount, amount );
+    state_s_2.set(s2, _self);
+  }
+
+  return;
+}
+
 void fusion::retire_lswax(const int64_t& amount){
+  INSTRUMENT_COUNT(inline_actions);
+  INVARIANT_DELTA(lswax_supply, -amount);
   action(permission_level{get_self(), "active"_n}, TOKEN_CONTRACT,"retire"_n,std::tuple{ get_self(), eosio::asset(amount, LSWAX_SYMBOL), std::string("retiring lsWAX to unliquify")}).send();
   return;
 }
 
 void fusion::retire_swax(const int64_t& amount){
-  action(permission_level{get_self(), "active"_n}, TOKEN_CONTRACT,"retire"_n,std::tuple{ get_self(), eosio::asset(amount, SWAX_SYMBOL), std::string("retiring sWAX for redemption")}).send();
+  settlements st = get_settlements();
+  st.swax_pending_retire->amount = safeAddInt64( st.swax_pending_retire->amount, amount );
+  settlements_s.set(st, _self);
+  return;
+}
+
+/**
+* save_state
+* writes the state singleton and moves state3.total_wax_owed by however much
+* the buckets in state that make up total_wax_owed changed
+* state is only read back on the first save of an action, after that the last saved amount is used
+*/
+
+void fusion::save_state(const state& s){
+  const int64_t wax_owed = state_wax_owed(s);
+  if( !saved_state_wax_owed.has_value() ) saved_state_wax_owed = state_wax_owed( states.get() );
+
+  const int64_t wax_owed_delta = wax_owed - *saved_state_wax_owed;
+
+  states.set(s, _self);
+  saved_state_wax_owed = wax_owed;
+
+  if( wax_owed_delta != 0 ){
+    state3 s3 = state_s_3.get();
+    s3.total_wax_owed.amount = safeAddInt64( s3.total_wax_owed.amount, wax_owed_delta );
+    check( s3.total_wax_owed.amount >= 0, "total_wax_owed would be negative" );
+    state_s_3.set(s3, _self);
+  }
+
+  return;
+}
+
+/**
+* settle_allocations
+* sends everything that has built up in the settlements ledger
+* lsWAX has to be issued before createfarms can send it to alcor, so it settles too
+*/
+
+void fusion::settle_allocations(){
+  settlements st = get_settlements();
+
+  if( st.pol_wax_pending.amount > 0 ){
+    transfer_tokens( POL_CONTRACT, st.pol_wax_pending, WAX_CONTRACT, std::string("pol allocation from waxfusion distribution") );
+
+    state3 s3 = state_s_3.get();
+    s3.total_wax_owed.amount = safeSubInt64( s3.total_wax_owed.amount, st.pol_wax_pending.amount );
+    state_s_3.set(s3, _self);
+
+    st.pol_wax_pending = ZERO_WAX;
+  }
+
+  //incentives get lsWAX at the current rate, backed by sWAX issued for them
+  if( st.incentives_wax_pending->amount > 0 ){
+    const int64_t incentives_wax = st.incentives_wax_pending->amount;
+    state s = states.get();
+    state2 s2 = state_s_2.get();
+
+    int64_t converted_lsWAX_i64 = internal_liquify( incentives_wax, s );
+
+    st.swax_pending_issue->amount = safeAddInt64( st.swax_pending_issue->amount, incentives_wax );
+    st.lswax_pending_issue.amount = safeAddInt64( st.lswax_pending_issue.amount, converted_lsWAX_i64 );
+    st.incentives_wax_pending = ZERO_WAX;
+
+    s.swax_currently_backing_lswax.amount = safeAddInt64( s.swax_currently_backing_lswax.amount, incentives_wax );
+    s.liquified_swax.amount = safeAddInt64( s.liquified_swax.amount, converted_lsWAX_i64 );
+    s2.incentives_bucket.amount = safeAddInt64( s2.incentives_bucket.amount, converted_lsWAX_i64 );
+
+    save_state(s);
+    state_s_2.set(s2, _self);
+  }
+
+  if( st.lswax_pending_issue.amount > 0 ){
+    issue_lswax( st.lswax_pending_issue.amount, _self );
+    st.lswax_pending_issue = ZERO_LSWAX;
+  }
+
+  //only the net change in sWAX supply needs to reach token.fusion
+  if( *st.swax_pending_issue > *st.swax_pending_retire ){
+    int64_t swax_to_issue = safeSubInt64( st.swax_pending_issue->amount, st.swax_pending_retire->amount );
+    INSTRUMENT_COUNT(inline_actions);
+    INVARIANT_DELTA(swax_supply, swax_to_issue);
+    action(permission_level{get_self(), "active"_n}, TOKEN_CONTRACT,"issue"_n,std::tuple{ get_self(), get_self(), eosio::asset(swax_to_issue, SWAX_SYMBOL), std::string("issuing sWAX for staking")}).send();
+  } else if( *st.swax_pending_retire > *st.swax_pending_issue ){
+    int64_t swax_to_retire = safeSubInt64( st.swax_pending_retire->amount, st.swax_pending_issue->amount );
+    INSTRUMENT_COUNT(inline_actions);
+    INVARIANT_DELTA(swax_supply, -swax_to_retire);
+    action(permission_level{get_self(), "active"_n}, TOKEN_CONTRACT,"retire"_n,std::tuple{ get_self(), eosio::asset(swax_to_retire, SWAX_SYMBOL), std::string("retiring sWAX for redemption")}).send();
+  }
+
+  st.swax_pending_issue = ZERO_SWAX;
+  st.swax_pending_retire = ZERO_SWAX;
+
+  st.next_settlement = now() + st.seconds_between_settlements;
+  settlements_s.set(st, _self);
+  return;
+}
+
+/**
+* stream_rewards
+* starts a new reward period that releases amount_to_stream, along with
+* anything left over from the previous period, over seconds_between_distributions
+* sync_rewards must be called before this
+*/
+
+void fusion::stream_rewards(const int64_t& amount_to_stream){
+  config3 c = config_s_3.get();
+  rewards rw = get_rewards();
+
+  rw.rewards_remaining.amount = safeAddInt64( rw.rewards_remaining.amount, amount_to_stream );
+  rw.last_update_time = now();
+  rw.period_finish = now() + c.seconds_between_distributions;
+
+  rewards_s.set(rw, _self);
   return;
 }
 
@@ -312,7 +847,7 @@ void fusion::sync_epoch(){
 
     s.last_epoch_start_time = next_epoch_start_time;
     s.current_cpu_contract = next_cpu_contract;
-    states.set(s, _self);
+    save_state(s);
 
     auto epoch_itr = epochs_t.find(next_epoch_start_time);
 
@@ -341,9 +876,10 @@ void fusion::sync_epoch(){
 
 /**
 * sync_tvl
-* updates the total value locked in the state2 singleton
-* total_value_locked does not necessarily reflect the current state of the chain,
-* but sync_tvl can be called often to periodically sync to the chain state
+* full recalculation of total_value_locked in state2 and total_wax_owed/contract_wax_balance in state3
+* those are kept as running totals by record_wax_received/record_wax_sent, so this is only needed
+* as a periodic audit. any difference from the running totals is recorded in the audit singleton
+* before the running totals are reset to the recalculated values
 */ 
 
 void fusion::sync_tvl(){
@@ -351,26 +887,18 @@ void fusion::sync_tvl(){
   state s = states.get();
   state2 s2 = state_s_2.get();
   state3 s3 = state_s_3.get();
+  settlements st = get_settlements();
 
   eosio::asset total_value_locked = ZERO_WAX;
   eosio::asset contract_wax_balance = ZERO_WAX;
   eosio::asset total_wax_owed = ZERO_WAX;
 
   //wax balance of this contract
-  accounts account_t = accounts(WAX_CONTRACT, _self.value);
-  const uint64_t raw_token_symbol = WAX_SYMBOL.code().raw();
-  auto it = account_t.find(raw_token_symbol);
-  if(it != account_t.end()){
-    total_value_locked.amount = safeAddInt64( total_value_locked.amount, it->balance.amount );
-    contract_wax_balance = it->balance;
-  }
+  contract_wax_balance.amount = get_wax_balance(_self);
+  total_value_locked.amount = safeAddInt64( total_value_locked.amount, contract_wax_balance.amount );
 
   //wax balance of pol.fusion
-  accounts account_t_2 = accounts(WAX_CONTRACT, POL_CONTRACT.value);
-  auto it_2 = account_t_2.find(raw_token_symbol);
-  if(it_2 != account_t_2.end()){
-    total_value_locked.amount = safeAddInt64( total_value_locked.amount, it_2->balance.amount );
-  }  
+  total_value_locked.amount = safeAddInt64( total_value_locked.amount, get_wax_balance(POL_CONTRACT) );
 
   //total amount in both columns from pol_state_s_2
   pol_contract::state2 ps2 = pol_state_s_2.get();
@@ -380,7 +908,7 @@ void fusion::sync_tvl(){
   //total wax_bucket from the current 3 epochs
   uint64_t epoch_to_request_from = s.last_epoch_start_time - c.seconds_between_epochs;
 
-  std::vector<uint64_t> epochs_to_check = {
+  std::array<uint64_t, 3> epochs_to_check = {
     epoch_to_request_from,
     epoch_to_request_from + c.seconds_between_epochs,
     epoch_to_request_from + ( c.seconds_between_epochs * 2 )
@@ -394,91 +922,116 @@ void fusion::sync_tvl(){
     } 
   }   
 
+  audit a = audit_s.get_or_default(audit{});
+  a.tvl_drift = s2.total_value_locked.amount - total_value_locked.amount;
+
   s2.total_value_locked = total_value_locked;
   state_s_2.set(s2, _self);
 
-  total_wax_owed.amount = safeAddInt64( total_wax_owed.amount, s.wax_available_for_rentals.amount );
-  total_wax_owed.amount = safeAddInt64( total_wax_owed.amount, s.revenue_awaiting_distribution.amount );
-  total_wax_owed.amount = safeAddInt64( total_wax_owed.amount, s.wax_for_redemption.amount );
-  total_wax_owed.amount = safeAddInt64( total_wax_owed.amount, s.user_funds_bucket.amount );
+  total_wax_owed.amount = state_wax_owed(s);
   total_wax_owed.amount = safeAddInt64( total_wax_owed.amount, s3.total_claimable_wax.amount );
-  s3.total_wax_owed = total_wax_owed;
-  s3.contract_wax_balance = contract_wax_balance;
+  total_wax_owed.amount = safeAddInt64( total_wax_owed.amount, st.pol_wax_pending.amount );
 
-  uint64_t last_key = 0;
-  auto snap_it = state_snaps_t.end();
-
-  if(state_snaps_t.begin() != state_snaps_t.end()){
-      snap_it --;
-      last_key = snap_it->timestamp;
-  }  
+  a.wax_owed_drift = s3.total_wax_owed.amount - total_wax_owed.amount;
+  a.wax_balance_drift = s3.contract_wax_balance.amount - contract_wax_balance.amount;
+  a.last_audit = now();
+  audit_s.set(a, _self);
 
-  if( last_key + ( 60 * 30 ) < now() ){ /* if 30 mins have passed, create a snapshot of state */
-    state_snaps_t.emplace(_self, [&](auto &_snap){
-      _snap.timestamp = now();
-      _snap.total_wax_owed = total_wax_owed;
-      _snap.contract_wax_balance = contract_wax_balance;
-    });
-  }
+  s3.total_wax_owed = total_wax_owed;
+  s3.contract_wax_balance = contract_wax_balance;
 
   s3.last_update = now();
   state_s_3.set(s3, _self);
 
-}
+  write_state_ring(s2, s3);
 
-void fusion::sync_user(const eosio::name& user){
-  auto staker = staker_t.require_find(user.value, "you need to use the stake action first");
+}
 
-  const uint64_t lower_bound_timestamp = staker->last_update + 1;
+/**
+* sync_rewards
+* brings the reward accumulator up to date
+* needs to happen before anything modifies state.swax_currently_earning
+*/
 
-  //is their last_update < last_payout ?
-  auto low_itr = snaps_t.lower_bound( lower_bound_timestamp );
+rewards fusion::sync_rewards(){
+  rewards rw = get_accrued_rewards();
 
-  if(low_itr == snaps_t.end()) return;
+  rewards_s.set(rw, _self);
+  return rw;
+}
 
-  config3 c = config_s_3.get();
-  state s = states.get();
+void fusion::sync_user(const eosio::name& user){
+  auto staker = staker_t.require_find(user.value, "you need to use the stake action first");
 
-  int count = 0;
-  int64_t wax_owed_to_user = 0; 
+  rewards rw = sync_rewards();
 
-  /* if they have no staked sWAX, they get 0 */
-  if(staker->swax_balance.amount > 0){
+  int64_t wax_owed_to_user = get_pending_rewards(*staker, rw);
 
-    for(auto it = low_itr; it != snaps_t.end(); it++){
-      //only calculate if there was sWAX earning
-      //redundant safety check to make sure the snapshot timestamp is eligible
-      if(it->swax_earning_bucket.amount > 0 && it->timestamp >= lower_bound_timestamp){
-        //calculate the % of snapshot owned by this user and add it to their owed_to
+  //rewards are routed according to the user's preference, default is claimable WAX
+  uint8_t reward_route = staker->reward_route.value_or( REWARD_ROUTE_CLAIMABLE_WAX );
 
-        int64_t wax_allocation = internal_get_wax_owed_to_user(staker->swax_balance.amount, it->total_swax_earning.amount, it->swax_earning_bucket.amount);
-        wax_owed_to_user = safeAddInt64(wax_owed_to_user, wax_allocation);
-      }
+  //dust that would convert to 0 lsWAX can't be issued, so it stays claimable instead
+  int64_t converted_lsWAX_i64 = 0;
 
-      count ++;
-      if(count >= c.max_snapshots_to_process) break;
-    }
+  if( reward_route == REWARD_ROUTE_CONVERT_LSWAX && wax_owed_to_user > 0 ){
+    converted_lsWAX_i64 = internal_liquify(wax_owed_to_user, states.get());
+    if( converted_lsWAX_i64 == 0 ) reward_route = REWARD_ROUTE_CLAIMABLE_WAX;
   }
 
   asset claimable_wax = staker->claimable_wax;
-  claimable_wax.amount = safeAddInt64(claimable_wax.amount, wax_owed_to_user);
+  asset swax_balance = staker->swax_balance;
+
+  if( reward_route == REWARD_ROUTE_CLAIMABLE_WAX ){
+    claimable_wax.amount = safeAddInt64(claimable_wax.amount, wax_owed_to_user);
+  } else if( reward_route == REWARD_ROUTE_COMPOUND_SWAX ){
+    swax_balance.amount = safeAddInt64(swax_balance.amount, wax_owed_to_user);
+  }
 
   //credit their balance, update last_update to now()
-  staker_t.modify(staker, same_payer, [&](auto &_s){
+  staker_t.modify(staker, get_staker_payer(*staker), [&](auto &_s){
+    _s.swax_balance = swax_balance;
     _s.claimable_wax = claimable_wax;
     _s.last_update = now();
+    _s.reward_per_swax_paid_1e12 = rw.reward_per_swax_1e12;
   });
 
-  credit_total_claimable_wax( eosio::asset(wax_owed_to_user, WAX_SYMBOL) );
+  if(wax_owed_to_user == 0) return;
 
   //debit the user bucket in state
+  state s = states.get();
   s.user_funds_bucket.amount = safeSubInt64(s.user_funds_bucket.amount, wax_owed_to_user);
-  states.set(s, _self);
+
+  if( reward_route == REWARD_ROUTE_CLAIMABLE_WAX ){
+    credit_total_claimable_wax( eosio::asset(wax_owed_to_user, WAX_SYMBOL) );
+
+  } else if( reward_route == REWARD_ROUTE_COMPOUND_SWAX ){
+    //same as claimswax
+    issue_swax(wax_owed_to_user);
+    s.swax_currently_earning.amount = safeAddInt64(s.swax_currently_earning.amount, wax_owed_to_user);
+    s.wax_available_for_rentals.amount = safeAddInt64(s.wax_available_for_rentals.amount, wax_owed_to_user);
+
+  } else if( reward_route == REWARD_ROUTE_CONVERT_LSWAX ){
+    //same as claimaslswax, at the current rate. the lsWAX is issued later by payroutes
+    issue_swax(wax_owed_to_user);
+    credit_route_payout(user, converted_lsWAX_i64);
+
+    s.liquified_swax.amount = safeAddInt64(s.liquified_swax.amount, converted_lsWAX_i64);
+    s.swax_currently_backing_lswax.amount = safeAddInt64(s.swax_currently_backing_lswax.amount, wax_owed_to_user);
+    s.wax_available_for_rentals.amount = safeAddInt64(s.wax_available_for_rentals.amount, wax_owed_to_user);
+  }
+
+  save_state(s);
 
   return;
 }
 
 void fusion::transfer_tokens(const name& user, const asset& amount_to_send, const name& contract, const std::string& memo){
+  if( contract == WAX_CONTRACT ){
+    record_wax_sent( user, amount_to_send.amount );
+    INVARIANT_DELTA(wax_sent, amount_to_send.amount);
+  }
+
+  INSTRUMENT_COUNT(inline_actions);
   action(permission_level{get_self(), "active"_n}, contract,"transfer"_n,std::tuple{ get_self(), user, amount_to_send, memo}).send();
   return;
 }
@@ -513,20 +1066,139 @@ void fusion::validate_token(const eosio::symbol& symbol, const eosio::name& cont
   check(false, "invalid token received");
 }
 
+/**
+* write_rate_history
+* records the lsWAX rate in each RATE_HISTORY_TIERS ring whose window doesn't have one yet
+*/
+
+void fusion::write_rate_history(const state& s){
+  const uint64_t rate_1e12 = get_lswax_rate_1e12(s);
+
+  for(const snapshot_tier& tier : RATE_HISTORY_TIERS){
+    const uint64_t window = now() / tier.resolution_seconds;
+    const uint64_t slot = window % tier.capacity;
+
+    rate_ring_table ring_t = rate_ring_table( _self, tier.resolution_seconds );
+    auto ring_itr = ring_t.find( slot );
+
+    if( ring_itr == ring_t.end() ){
+      ring_t.emplace(_self, [&](auto &_r){
+        _r.slot = slot;
+        _r.timestamp = now();
+        _r.swax_per_lswax_1e12 = rate_1e12;
+        _r.total_revenue_distributed = s.total_revenue_distributed;
+      });
+    } else if( ring_itr->timestamp / tier.resolution_seconds != window ){
+      ring_t.modify(ring_itr, same_payer, [&](auto &_r){
+        _r.timestamp = now();
+        _r.swax_per_lswax_1e12 = rate_1e12;
+        _r.total_revenue_distributed = s.total_revenue_distributed;
+      });
+    }
+  }
+
+  return;
+}
+
+/**
+* write_snapshot_page
+* stores a distribution snapshot in its slot in snappages
+*/
+
+void fusion::write_snapshot_page(const snapshots& snap){
+  config3 c = config_s_3.get();
+
+  const uint64_t period = snap.timestamp / c.seconds_between_distributions;
+  const uint64_t page = period / SNAPSHOT_PAGE_SIZE;
+  const uint64_t slot = period % SNAPSHOT_PAGE_SIZE;
+  const uint64_t phase_seconds = snap.timestamp % c.seconds_between_distributions;
+
+  auto set_slot = [&](auto &_page){
+    _page.swax_earning_bucket[slot] = snap.swax_earning_bucket.amount;
+    _page.lswax_autocompounding_bucket[slot] = snap.lswax_autocompounding_bucket.amount;
+    _page.pol_bucket[slot] = snap.pol_bucket.amount;
+    _page.ecosystem_bucket[slot] = snap.ecosystem_bucket.amount;
+    _page.total_distributed[slot] = snap.total_distributed.amount;
+    _page.total_swax_earning[slot] = snap.total_swax_earning.amount;
+  };
+
+  auto page_itr = snap_pages_t.find( page );
+
+  if( page_itr == snap_pages_t.end() ){
+    snap_pages_t.emplace(_self, [&](auto &_page){
+      _page.page = page;
+      _page.phase_seconds = phase_seconds;
+      _page.swax_earning_bucket = std::vector<int64_t>(SNAPSHOT_PAGE_SIZE, 0);
+      _page.lswax_autocompounding_bucket = std::vector<int64_t>(SNAPSHOT_PAGE_SIZE, 0);
+      _page.pol_bucket = std::vector<int64_t>(SNAPSHOT_PAGE_SIZE, 0);
+      _page.ecosystem_bucket = std::vector<int64_t>(SNAPSHOT_PAGE_SIZE, 0);
+      _page.total_distributed = std::vector<int64_t>(SNAPSHOT_PAGE_SIZE, 0);
+      _page.total_swax_earning = std::vector<int64_t>(SNAPSHOT_PAGE_SIZE, 0);
+      set_slot(_page);
+    });
+  } else {
+    check( page_itr->phase_seconds == phase_seconds, "snapshot timestamp is not aligned with its page" );
+    snap_pages_t.modify(page_itr, same_payer, set_slot);
+  }
+}
+
+/**
+* write_state_ring
+* records a snapshot of state in each ring whose resolution window doesn't have one yet
+* e.g. the daily ring only keeps the first snapshot of each day
+* written by synctvl and every distribution, so the rings fill even if synctvl isn't called
+*/
+
+void fusion::write_state_ring(const state2& s2, const state3& s3){
+  for(const snapshot_tier& tier : get_snapshot_tiers()){
+    const uint64_t window = now() / tier.resolution_seconds;
+    const uint64_t slot = window % tier.capacity;
+
+    state_ring_table ring_t = state_ring_table( _self, tier.resolution_seconds );
+    auto ring_itr = ring_t.find( slot );
+
+    if( ring_itr == ring_t.end() ){
+      ring_t.emplace(_self, [&](auto &_snap){
+        _snap.slot = slot;
+        _snap.timestamp = now();
+        _snap.total_wax_owed = s3.total_wax_owed;
+        _snap.contract_wax_balance = s3.contract_wax_balance;
+        _snap.total_value_locked = s2.total_value_locked;
+      });
+    } else if( ring_itr->timestamp / tier.resolution_seconds != window ){
+      ring_t.modify(ring_itr, same_payer, [&](auto &_snap){
+        _snap.timestamp = now();
+        _snap.total_wax_owed = s3.total_wax_owed;
+        _snap.contract_wax_balance = s3.contract_wax_balance;
+        _snap.total_value_locked = s2.total_value_locked;
+      });
+    }
+  }
+
+  return;
+}
+
 void fusion::zero_distribution(){
   config3 c = config_s_3.get();
   state s = states.get();
 
-  snaps_t.emplace(get_self(), [&](auto &_snap){
-    _snap.timestamp = s.next_distribution;
-    _snap.swax_earning_bucket = ZERO_WAX;
-    _snap.lswax_autocompounding_bucket = ZERO_WAX;
-    _snap.pol_bucket = ZERO_WAX;
-    _snap.ecosystem_bucket = ZERO_WAX;
-    _snap.total_distributed = ZERO_WAX; 
-    _snap.total_swax_earning = ZERO_SWAX; 
-  });  
+  snapshots snap{};
+  snap.timestamp = s.next_distribution;
+  snap.swax_earning_bucket = ZERO_WAX;
+  snap.lswax_autocompounding_bucket = ZERO_WAX;
+  snap.pol_bucket = ZERO_WAX;
+  snap.ecosystem_bucket = ZERO_WAX;
+  snap.total_distributed = ZERO_WAX; 
+  snap.total_swax_earning = ZERO_SWAX; 
+  write_snapshot_page(snap);
+
+  //restart the stream so anything left over from the previous period keeps flowing
+  stream_rewards(0);
+
+  write_rate_history(s);
 
   s.next_distribution += c.seconds_between_distributions;
-  states.set(s, _self);    
+  save_state(s);    
+
+  write_state_ring( state_s_2.get(), state_s_3.get() );
 }
\ No newline at end of file
@@ -3,9 +3,12 @@
 #include "integer_functions.cpp"
 #include "safe.cpp"
 #include "on_notify.cpp"
+#include "instrumentation.cpp"
+#include "invariants.cpp"
 
 
 ACTION fusion::addadmin(const eosio::name& admin_to_add){
+	INSTRUMENT_ACTION("addadmin"_n);
 	require_auth(_self);
 	check( is_account(admin_to_add), "admin_to_add is not a wax account" );
 
@@ -20,6 +23,7 @@ ACTION fusion::addadmin(const eosio::name& admin_to_add){
 }
 
 ACTION fusion::addcpucntrct(const eosio::name& contract_to_add){
+	INSTRUMENT_ACTION("addcpucntrct"_n);
 	require_auth(_self);
 	check( is_account(contract_to_add), "contract_to_add is not a wax account" );
 
@@ -35,12 +39,15 @@ ACTION fusion::addcpucntrct(const eosio::name& contract_to_add){
 
 ACTION fusion::claimgbmvote(const eosio::name& cpu_contract)
 {
-	check( is_cpu_contract(cpu_contract), ( cpu_contract.to_string() + " is not a cpu rental contract").c_str() );
+	INSTRUMENT_ACTION("claimgbmvote"_n);
+	check_or( is_cpu_contract(cpu_contract), [&]{ return cpu_contract.to_string() + " is not a cpu rental contract"; } );
+	INSTRUMENT_COUNT(inline_actions);
 	action(permission_level{get_self(), "active"_n}, cpu_contract,"claimgbmvote"_n,std::tuple{}).send();
 }
 
 ACTION fusion::claimrefunds()
 {
+	INSTRUMENT_ACTION("claimrefunds"_n);
 	//anyone can call this
 
 	config3 c = config_s_3.get();
@@ -53,6 +60,7 @@ ACTION fusion::claimrefunds()
 		auto refund_itr = refunds_t.find( ctrct.value );
 
 		if( refund_itr != refunds_t.end() && refund_itr->request_time + seconds(REFUND_DELAY_SEC) <= current_time_point() ){
+			INSTRUMENT_COUNT(inline_actions);
 			action(permission_level{get_self(), "active"_n}, ctrct,"claimrefund"_n,std::tuple{}).send();
 			refundsToClaim = true;
 		}
@@ -63,6 +71,7 @@ ACTION fusion::claimrefunds()
 }
 
 ACTION fusion::claimaslswax(const eosio::name& user, const eosio::asset& expected_output, const uint64_t& max_slippage_1e6){
+	INSTRUMENT_ACTION("claimaslswax"_n);
 
 	require_auth(user);
 	sync_epoch();
@@ -89,7 +98,7 @@ ACTION fusion::claimaslswax(const eosio::name& user, const eosio::asset& expecte
 		uint64_t minimum_output_percentage = ONE_HUNDRED_PERCENT_1E6 - max_slippage_1e6;
 		int64_t minimum_output = calculate_asset_share( expected_output.amount, minimum_output_percentage );
 
-	    check( converted_lsWAX_i64 >= (int64_t) minimum_output, "output would be " + asset(converted_lsWAX_i64, LSWAX_SYMBOL).to_string() + " but expected " + asset(minimum_output, LSWAX_SYMBOL).to_string() );		
+	    check_or( converted_lsWAX_i64 >= (int64_t) minimum_output, [&]{ return "output would be " + asset(converted_lsWAX_i64, LSWAX_SYMBOL).to_string() + " but expected " + asset(minimum_output, LSWAX_SYMBOL).to_string(); } );		
 
 		issue_lswax(converted_lsWAX_i64, user);
 
@@ -101,7 +110,7 @@ ACTION fusion::claimaslswax(const eosio::name& user, const eosio::asset& expecte
 		s.swax_currently_backing_lswax.amount = safeAddInt64(s.swax_currently_backing_lswax.amount, claimable_wax_amount);
 	    s.wax_available_for_rentals.amount = safeAddInt64(s.wax_available_for_rentals.amount, claimable_wax_amount);
 
-	    states.set(s, _self);		
+	    save_state(s);		
 
 		return;
 	}
@@ -110,6 +119,7 @@ ACTION fusion::claimaslswax(const eosio::name& user, const eosio::asset& expecte
 }
 
 ACTION fusion::claimrewards(const eosio::name& user){
+	INSTRUMENT_ACTION("claimrewards"_n);
 	require_auth(user);
 	sync_epoch();
 	sync_user(user);
@@ -135,6 +145,7 @@ ACTION fusion::claimrewards(const eosio::name& user){
 */
 
 ACTION fusion::claimswax(const eosio::name& user){
+	INSTRUMENT_ACTION("claimswax"_n);
 	require_auth(user);
 	sync_epoch();
 	sync_user(user);
@@ -157,7 +168,7 @@ ACTION fusion::claimswax(const eosio::name& user){
 	    s.swax_currently_earning.amount = safeAddInt64(s.swax_currently_earning.amount, swax_amount_to_claim);
 	    s.wax_available_for_rentals.amount = safeAddInt64(s.wax_available_for_rentals.amount, swax_amount_to_claim);
 
-	    states.set(s, _self);		
+	    save_state(s);		
 
 		return;
 	}
@@ -171,6 +182,7 @@ ACTION fusion::claimswax(const eosio::name& user){
 */  
 
 ACTION fusion::clearexpired(const eosio::name& user){
+	INSTRUMENT_ACTION("clearexpired"_n);
 	require_auth(user);
 	sync_epoch();
 	sync_user(user);
@@ -192,6 +204,46 @@ ACTION fusion::clearexpired(const eosio::name& user){
 
 }
 
+/**
+* clearsnaps
+* removes state snapshots that are no longer part of a configured ring
+* resolution_seconds 0 clears the legacy statesnaps table
+*/
+
+ACTION fusion::clearsnaps(const uint64_t& resolution_seconds, const int& limit){
+	INSTRUMENT_ACTION("clearsnaps"_n);
+	require_auth( _self );
+
+	int rows_limit = limit == 0 ? 500 : limit;
+	int count = 0;
+
+	if( resolution_seconds == 0 ){
+		auto itr = state_snaps_t.begin();
+		while (itr != state_snaps_t.end()) {
+			if (count == rows_limit) return;
+			itr = state_snaps_t.erase( itr );
+			count ++;
+		}
+		return;
+	}
+
+	//slots >= capacity are left over from a ring that was shrunk or removed
+	uint64_t capacity = 0;
+
+	for(const snapshot_tier& tier : get_snapshot_tiers()){
+		if( tier.resolution_seconds == resolution_seconds ) capacity = tier.capacity;
+	}
+
+	state_ring_table ring_t = state_ring_table( _self, resolution_seconds );
+
+	auto itr = ring_t.lower_bound( capacity );
+	while (itr != ring_t.end()) {
+		if (count == rows_limit) return;
+		itr = ring_t.erase( itr );
+		count ++;
+	}
+}
+
 /**
 * createfarms
 * can be called by anyone
@@ -199,7 +251,9 @@ ACTION fusion::clearexpired(const eosio::name& user){
 */
 
 ACTION fusion::createfarms(){
+	INSTRUMENT_ACTION("createfarms"_n);
 	sync_epoch();
+	settle_allocations();
 	state2 s2 = state_s_2.get();
 
 	check( s2.last_incentive_distribution + LP_FARM_DURATION_SECONDS < now(), "hasn't been 1 week since last farms were created");
@@ -225,7 +279,7 @@ ACTION fusion::createfarms(){
 		create_alcor_farm(lp_itr->poolId, lp_itr->symbol_to_incentivize, lp_itr->contract_to_incentivize);
 
 		auto alcor_itr = incentives_t.find(next_key);
-		check( alcor_itr->poolId == lp_itr->poolId, ("poolId for " + lp_itr->symbol_to_incentivize.code().to_string() + " doesn't match").c_str() );
+		check_or( alcor_itr->poolId == lp_itr->poolId, [&]{ return "poolId for " + lp_itr->symbol_to_incentivize.code().to_string() + " doesn't match"; } );
 
 		transfer_tokens( ALCOR_CONTRACT, asset(lswax_allocation_i64, LSWAX_SYMBOL), TOKEN_CONTRACT, memo );
 
@@ -246,11 +300,12 @@ ACTION fusion::createfarms(){
 */ 
 
 ACTION fusion::distribute(){
+	INSTRUMENT_ACTION("distribute"_n);
 	sync_epoch();
+	sync_rewards();
 
 	config3 c = config_s_3.get();
 	state s = states.get();
-	state2 s2 = state_s_2.get();
 
 	//make sure its been long enough since the last distribution
 	if( s.next_distribution > now() ){
@@ -288,30 +343,22 @@ ACTION fusion::distribute(){
 	//user share goes to s.user_funds_bucket
 	s.user_funds_bucket.amount = safeAddInt64(s.user_funds_bucket.amount, swax_earning_alloc_i64);
 
-	//pol share goes to POL_CONTRACT
-	transfer_tokens( POL_CONTRACT, asset(pol_alloc_i64, WAX_SYMBOL), WAX_CONTRACT, std::string("pol allocation from waxfusion distribution") );
-
-	//incentives lsWAX should be issued at the new rate instead of autocompounding it immediately after minting it
-	int64_t converted_lsWAX_i64 = internal_liquify( eco_alloc_i64, s );
-
-	issue_lswax(converted_lsWAX_i64, _self);
-
-	//make sure ecosystems lswax gets added to incentives_bucket
-	s2.incentives_bucket.amount = safeAddInt64( s2.incentives_bucket.amount, converted_lsWAX_i64 );	
-
-	s.swax_currently_backing_lswax.amount = safeAddInt64( s.swax_currently_backing_lswax.amount, eco_alloc_i64 );
-	s.liquified_swax.amount = safeAddInt64(s.liquified_swax.amount, converted_lsWAX_i64);	
+	//pol share is sent and the ecosystem share is liquified into incentives_bucket during the next settlement
+	credit_settlements( pol_alloc_i64, eco_alloc_i64 );
 
 	//create a snapshot
-	snaps_t.emplace(get_self(), [&](auto &_snap){
-		_snap.timestamp = s.next_distribution;
-		_snap.swax_earning_bucket = asset(swax_earning_alloc_i64, WAX_SYMBOL);
-		_snap.lswax_autocompounding_bucket = asset(swax_autocompounding_alloc_i64, WAX_SYMBOL);
-		_snap.pol_bucket = asset(pol_alloc_i64, WAX_SYMBOL);
-		_snap.ecosystem_bucket = asset(eco_alloc_i64, WAX_SYMBOL);
-		_snap.total_distributed = asset(amount_to_distribute, WAX_SYMBOL);	
-		_snap.total_swax_earning = s.swax_currently_earning;
-	});
+	snapshots snap{};
+	snap.timestamp = s.next_distribution;
+	snap.swax_earning_bucket = asset(swax_earning_alloc_i64, WAX_SYMBOL);
+	snap.lswax_autocompounding_bucket = asset(swax_autocompounding_alloc_i64, WAX_SYMBOL);
+	snap.pol_bucket = asset(pol_alloc_i64, WAX_SYMBOL);
+	snap.ecosystem_bucket = asset(eco_alloc_i64, WAX_SYMBOL);
+	snap.total_distributed = asset(amount_to_distribute, WAX_SYMBOL);	
+	snap.total_swax_earning = s.swax_currently_earning;
+	write_snapshot_page(snap);
+
+	//the sWAX earning share is streamed to stakers over the next distribution interval
+	stream_rewards(swax_earning_alloc_i64);
 
 	//update total_revenue_distributed in state
 	s.total_revenue_distributed.amount = safeAddInt64(s.total_revenue_distributed.amount, amount_to_distribute);
@@ -321,15 +368,196 @@ ACTION fusion::distribute(){
 
     s.wax_available_for_rentals.amount = safeAddInt64(s.wax_available_for_rentals.amount, swax_amount_to_issue);
 
-    states.set(s, _self);
-    state_s_2.set(s2, _self);
+    save_state(s);
+
+    write_rate_history(s);
+    write_state_ring( state_s_2.get(), state_s_3.get() );
 
 	return;	
 
 }
 
+/**
+* getapr
+* read only, annualizes the lsWAX rate growth between now and window_seconds ago
+* uses the finest ratering tier that still covers the window
+*/
+
+apr_quote fusion::getapr(const uint64_t& window_seconds){
+	check( window_seconds > 0 && window_seconds < now(), "invalid window" );
+
+	const uint64_t from_time = now() - window_seconds;
+
+	apr_quote q{};
+	q.to_time = now();
+	q.to_swax_per_lswax_1e12 = get_lswax_rate_1e12( states.get() );
+
+	for(const snapshot_tier& tier : RATE_HISTORY_TIERS){
+		if( window_seconds > tier.resolution_seconds * tier.capacity ) continue;
+
+		rate_ring_table ring_t = rate_ring_table( _self, tier.resolution_seconds );
+		auto ring_itr = ring_t.find( ( from_time / tier.resolution_seconds ) % tier.capacity );
+
+		//the slot may have been overwritten by a later window, or never written
+		if( ring_itr == ring_t.end() || ring_itr->timestamp / tier.resolution_seconds != from_time / tier.resolution_seconds ) continue;
+
+		q.from_time = ring_itr->timestamp;
+		q.from_swax_per_lswax_1e12 = ring_itr->swax_per_lswax_1e12;
+		break;
+	}
+
+	check( q.from_time > 0, "there is no rate history for this window" );
+
+	if( q.to_time <= q.from_time || q.to_swax_per_lswax_1e12 <= q.from_swax_per_lswax_1e12 ) return q;
+
+	//formula is ( ( to_rate - from_rate ) * 100% * SECONDS_PER_YEAR ) / ( from_rate * elapsed )
+	//the rates are at most a few multiples of 1e12, so this fits comfortably in uint128_t
+	const uint128_t growth_128 = (uint128_t) ( q.to_swax_per_lswax_1e12 - q.from_swax_per_lswax_1e12 ) * (uint128_t) ONE_HUNDRED_PERCENT_1E6 * (uint128_t) SECONDS_PER_YEAR;
+	q.apr_1e6 = safe_math::to_uint64( growth_128 / ( (uint128_t) q.from_swax_per_lswax_1e12 * (uint128_t) ( q.to_time - q.from_time ) ) );
+
+	return q;
+}
+
+/**
+* getdashboard
+* read only, returns all protocol wide figures from a single point in time
+* state is returned as stored, no epoch/reward syncing is written
+* sWAX/lsWAX figures come from state, the token.fusion supplies lag them by whatever is pending in settlements
+*/
+
+dashboard fusion::getdashboard(){
+	state s = states.get();
+	state2 s2 = state_s_2.get();
+	state3 s3 = state_s_3.get();
+	config3 c = config_s_3.get();
+	rewards rw = get_accrued_rewards();
+
+	dashboard d{};
+	d.version = DASHBOARD_VERSION;
+	d.timestamp = now();
+
+	d.swax_currently_earning = s.swax_currently_earning;
+	d.swax_currently_backing_lswax = s.swax_currently_backing_lswax;
+	d.liquified_swax = s.liquified_swax;
+	d.one_lswax_to_swax = s.liquified_swax.amount == 0 ? asset( ONE_SWAX_AMOUNT, SWAX_SYMBOL ) : asset( internal_unliquify( ONE_SWAX_AMOUNT, s ), SWAX_SYMBOL );
+
+	d.revenue_awaiting_distribution = s.revenue_awaiting_distribution;
+	d.user_funds_bucket = s.user_funds_bucket;
+	d.total_revenue_distributed = s.total_revenue_distributed;
+	d.rewards_remaining = rw.rewards_remaining;
+	d.rewards_period_finish = rw.period_finish;
+	d.next_distribution = s.next_distribution;
+
+	snapshots last_snap = get_snapshot( s.next_distribution - c.seconds_between_distributions );
+	d.last_distribution_time = last_snap.timestamp;
+	d.last_distribution_amount = last_snap.timestamp == 0 ? ZERO_WAX : last_snap.total_distributed;
+	d.incentives_bucket = s2.incentives_bucket;
+
+	d.total_value_locked = s2.total_value_locked;
+	d.total_claimable_wax = s3.total_claimable_wax;
+	d.total_wax_owed = s3.total_wax_owed;
+	d.contract_wax_balance = s3.contract_wax_balance;
+
+	d.live_epochs = get_live_epochs(s, c);
+	d.wax_in_live_epochs = ZERO_WAX;
+
+	for(const epoch_capacity& e : d.live_epochs){
+		d.wax_in_live_epochs.amount = safeAddInt64(d.wax_in_live_epochs.amount, e.wax_bucket.amount);
+	}
+
+	d.wax_available_for_rentals = s.wax_available_for_rentals;
+
+	const int64_t rental_pool_size = safeAddInt64(d.wax_in_live_epochs.amount, s.wax_available_for_rentals.amount);
+	d.rental_utilization_1e6 = rental_pool_size == 0 ? 0 : 
+		safe_math::to_uint64( safe_math::muldiv( (uint128_t) d.wax_in_live_epochs.amount, (uint128_t) ONE_HUNDRED_PERCENT_1E6, (uint128_t) rental_pool_size ) );
+
+	d.cost_to_rent_1_wax = s.cost_to_rent_1_wax;
+	d.current_cpu_contract = s.current_cpu_contract;
+	d.next_stakeall_time = s.next_stakeall_time;
+
+	d.wax_for_redemption = s.wax_for_redemption;
+	d.redemption_period_start = s.redemption_period_start;
+	d.redemption_period_end = s.redemption_period_end;
+
+	d.minimum_stake_amount = c.minimum_stake_amount;
+	d.minimum_unliquify_amount = c.minimum_unliquify_amount;
+	d.user_share_1e6 = c.user_share_1e6;
+	d.pol_share_1e6 = c.pol_share_1e6;
+	d.ecosystem_share_1e6 = c.ecosystem_share_1e6;
+
+	if( top21_s.exists() ) d.top21_producers = top21_s.get().block_producers;
+
+	settlements st = get_settlements();
+	d.pol_wax_pending = st.pol_wax_pending;
+	d.lswax_pending_issue = st.lswax_pending_issue;
+	d.incentives_wax_pending = *st.incentives_wax_pending;
+	d.route_lswax_pending = *st.route_lswax_pending;
+	d.swax_pending_issue = *st.swax_pending_issue;
+	d.swax_pending_retire = *st.swax_pending_retire;
+	d.next_settlement = st.next_settlement;
+
+	return d;
+}
+
+/**
+* getposition
+* read only, returns a staker's balances as they would be if they synced right now
+* along with any redemption requests they have open
+*/
+
+staker_position fusion::getposition(const eosio::name& user){
+	auto staker = staker_t.require_find(user.value, "this user has no staker row");
+
+	rewards rw = get_accrued_rewards();
+
+	staker_position p{};
+	p.wallet = user;
+	p.swax_balance = staker->swax_balance;
+	p.claimable_wax = staker->claimable_wax;
+	p.pending_rewards = asset( get_pending_rewards(*staker, rw), WAX_SYMBOL );
+	p.reward_route = staker->reward_route.value_or( REWARD_ROUTE_CLAIMABLE_WAX );
+
+	if( p.reward_route == REWARD_ROUTE_CLAIMABLE_WAX ){
+		p.claimable_wax.amount = safeAddInt64(p.claimable_wax.amount, p.pending_rewards.amount);
+	} else if( p.reward_route == REWARD_ROUTE_COMPOUND_SWAX ){
+		p.swax_balance.amount = safeAddInt64(p.swax_balance.amount, p.pending_rewards.amount);
+	}
+
+	requests_tbl requests_t = requests_tbl(get_self(), user.value);
+
+	for(auto itr = requests_t.begin(); itr != requests_t.end(); itr++){
+		p.redemption_requests.push_back( { itr->epoch_id, itr->wax_amount_requested } );
+	}
+
+	auto payout_itr = route_payouts_t.find(user.value);
+	p.lswax_awaiting_payout = payout_itr == route_payouts_t.end() ? ZERO_LSWAX : payout_itr->lswax_owed;
+
+	return p;
+}
+
+/**
+* getrates
+* read only, returns the current sWAX <> lsWAX exchange rates
+* rates use the sWAX/lsWAX amounts in state, not the token.fusion supplies, which only
+* catch up at the next settlement (see getdashboard for what is pending)
+*/
+
+exchange_rates fusion::getrates(){
+	state s = states.get();
+
+	exchange_rates r{};
+	r.swax_currently_backing_lswax = s.swax_currently_backing_lswax;
+	r.liquified_swax = s.liquified_swax;
+	r.one_swax_to_lswax = asset( internal_liquify( ONE_SWAX_AMOUNT, s ), LSWAX_SYMBOL );
+
+	//nothing has been liquified yet, so unliquifying would be 1:1
+	r.one_lswax_to_swax = s.liquified_swax.amount == 0 ? asset( ONE_SWAX_AMOUNT, SWAX_SYMBOL ) : asset( internal_unliquify( ONE_SWAX_AMOUNT, s ), SWAX_SYMBOL );
+
+	return r;
+}
 
 ACTION fusion::initconfig(){
+	INSTRUMENT_ACTION("initconfig"_n);
 	require_auth(get_self());
 
 	eosio::check(!states.exists(), "State already exists");
@@ -371,6 +599,7 @@ ACTION fusion::initconfig(){
 
 
 ACTION fusion::initconfig3(){
+	INSTRUMENT_ACTION("initconfig3"_n);
 	require_auth( _self );
 
 	eosio::check(!config_s_3.exists(), "Config3 already exists");
@@ -404,7 +633,42 @@ ACTION fusion::initconfig3(){
 	
 }
 
+/**
+* initrewards
+* switches sWAX earning rewards from daily snapshots over to streaming
+* snapshots that already exist (or are pending for the current distribution period) are still paid out to users who haven't synced yet
+*/
+
+ACTION fusion::initrewards(){
+	INSTRUMENT_ACTION("initrewards"_n);
+	require_auth(get_self());
+
+	eosio::check(!rewards_s.exists(), "Rewards already exists");
+
+	rewards_s.set(get_rewards(), _self);
+}
+
+ACTION fusion::initsettle(){
+	INSTRUMENT_ACTION("initsettle"_n);
+	require_auth(get_self());
+
+	eosio::check(!settlements_s.exists(), "Settlements already exists");
+
+	settlements st{};
+	st.pol_wax_pending = ZERO_WAX;
+	st.lswax_pending_issue = ZERO_LSWAX;
+	st.seconds_between_settlements = LP_FARM_DURATION_SECONDS;
+	st.next_settlement = now() + LP_FARM_DURATION_SECONDS;
+	st.swax_pending_issue = ZERO_SWAX;
+	st.swax_pending_retire = ZERO_SWAX;
+	st.incentives_wax_pending = ZERO_WAX;
+	st.route_lswax_pending = ZERO_LSWAX;
+
+	settlements_s.set(st, _self);
+}
+
 ACTION fusion::initstate2(){
+	INSTRUMENT_ACTION("initstate2"_n);
 	require_auth(get_self());
 
 	eosio::check(!state_s_2.exists(), "State2 already exists");
@@ -418,6 +682,7 @@ ACTION fusion::initstate2(){
 }
 
 ACTION fusion::initstate3(){
+	INSTRUMENT_ACTION("initstate3"_n);
 	require_auth(get_self());
 
 	eosio::check(!state_s_3.exists(), "State3 already exists");
@@ -449,6 +714,7 @@ ACTION fusion::initstate3(){
 }
 
 ACTION fusion::inittop21(){
+	INSTRUMENT_ACTION("inittop21"_n);
 	require_auth(get_self());
 
 	eosio::check(!top21_s.exists(), "top21 already exists");
@@ -481,7 +747,7 @@ ACTION fusion::inittop21(){
 
 	std::vector<eosio::name> producers_to_vote_for {};
 
-	for(auto t : top_producers){
+	for(const auto& t : top_producers){
 		producers_to_vote_for.push_back(t.first.producer_name);
 	}
 
@@ -505,6 +771,7 @@ ACTION fusion::inittop21(){
  *  while also helping to maintain the LSWAX peg on the open market
  */
 ACTION fusion::instaredeem(const eosio::name& user, const eosio::asset& swax_to_redeem){
+	INSTRUMENT_ACTION("instaredeem"_n);
 	require_auth(user);
 	sync_user(user);
 	sync_epoch();
@@ -534,9 +801,8 @@ ACTION fusion::instaredeem(const eosio::name& user, const eosio::asset& swax_to_
 
 	//calculate the 0.05% fee
 	//calculate the remainder for the user
-	uint64_t procotol_fee_1e6 = 5000; 
-	uint64_t user_percentage_1e6 = 100000000 - procotol_fee_1e6;
-	int64_t protocol_share = calculate_asset_share( swax_to_redeem.amount, procotol_fee_1e6 );
+	uint64_t user_percentage_1e6 = ONE_HUNDRED_PERCENT_1E6 - INSTAREDEEM_FEE_1E6;
+	int64_t protocol_share = calculate_asset_share( swax_to_redeem.amount, INSTAREDEEM_FEE_1E6 );
 	int64_t user_share = calculate_asset_share( swax_to_redeem.amount, user_percentage_1e6 );
 
 	check( safeAddInt64( protocol_share, user_share ) <= swax_to_redeem.amount, "error calculating protocol fee" );
@@ -551,7 +817,7 @@ ACTION fusion::instaredeem(const eosio::name& user, const eosio::asset& swax_to_
 	retire_swax(swax_to_redeem.amount);
 
 	//set the state
-	states.set(s, _self);
+	save_state(s);
 
     debit_user_redemptions_if_necessary(user, new_sWAX_balance);
 
@@ -559,6 +825,7 @@ ACTION fusion::instaredeem(const eosio::name& user, const eosio::asset& swax_to_
 
 
 ACTION fusion::liquify(const eosio::name& user, const eosio::asset& quantity){
+	INSTRUMENT_ACTION("liquify"_n);
 	require_auth(user);
     check(quantity.amount > 0, "Invalid quantity.");
     check(quantity.amount < MAX_ASSET_AMOUNT, "quantity too large");
@@ -600,7 +867,7 @@ ACTION fusion::liquify(const eosio::name& user, const eosio::asset& quantity){
 	s.liquified_swax.amount = safeAddInt64(s.liquified_swax.amount, converted_lsWAX_i64);
 
 	//apply the changes to state table
-	states.set(s, _self);
+	save_state(s);
 
 	debit_user_redemptions_if_necessary(user, new_sWAX_balance);
 
@@ -610,6 +877,7 @@ ACTION fusion::liquify(const eosio::name& user, const eosio::asset& quantity){
 ACTION fusion::liquifyexact(const eosio::name& user, const eosio::asset& quantity, 
 	const eosio::asset& expected_output, const uint64_t& max_slippage_1e6)
 {
+	INSTRUMENT_ACTION("liquifyexact"_n);
 
 	require_auth(user);
     check(quantity.amount > 0, "Invalid quantity.");
@@ -648,7 +916,7 @@ ACTION fusion::liquifyexact(const eosio::name& user, const eosio::asset& quantit
 	uint64_t minimum_output_percentage = ONE_HUNDRED_PERCENT_1E6 - max_slippage_1e6;
 	int64_t minimum_output = calculate_asset_share( expected_output.amount, minimum_output_percentage );
 
-	check( converted_lsWAX_i64 >= minimum_output, "output would be " + asset(converted_lsWAX_i64, LSWAX_SYMBOL).to_string() + " but expected " + asset(minimum_output, LSWAX_SYMBOL).to_string() );
+	check_or( converted_lsWAX_i64 >= minimum_output, [&]{ return "output would be " + asset(converted_lsWAX_i64, LSWAX_SYMBOL).to_string() + " but expected " + asset(minimum_output, LSWAX_SYMBOL).to_string(); } );
 
 	//subtract swax amount from swax_currently_earning
 	s.swax_currently_earning.amount = safeSubInt64(s.swax_currently_earning.amount, quantity.amount);
@@ -663,19 +931,259 @@ ACTION fusion::liquifyexact(const eosio::name& user, const eosio::asset& quantit
 	s.liquified_swax.amount = safeAddInt64(s.liquified_swax.amount, converted_lsWAX_i64);
 
 	//apply the changes to state table
-	states.set(s, _self);
+	save_state(s);
 
 	debit_user_redemptions_if_necessary(user, new_sWAX_balance);
 
 	return;
 }
 
+/**
+* migratesnaps
+* moves the oldest snapshots rows into snappages
+* anyone can call this, rows are read from whichever table they're in until migration is finished
+*/
+
+ACTION fusion::migratesnaps(const int& limit){
+	INSTRUMENT_ACTION("migratesnaps"_n);
+	check( limit > 0 && limit <= 500, "limit must be between 1 and 500" );
+
+	auto itr = snaps_t.begin();
+	check( itr != snaps_t.end(), "there are no snapshots left to migrate" );
+
+	int count = 0;
+	while (itr != snaps_t.end() && count < limit) {
+		write_snapshot_page( *itr );
+		itr = snaps_t.erase( itr );
+		count ++;
+	}
+}
+
+/**
+* payroutes
+* issues the lsWAX that sync_user converted for stakers on the convert route
+* anyone can call this, each staker gets one issue for everything converted since their last payout
+*/
+
+ACTION fusion::payroutes(const int& limit){
+	INSTRUMENT_ACTION("payroutes"_n);
+	check( limit > 0 && limit <= 50, "limit must be between 1 and 50" );
+
+	auto itr = route_payouts_t.begin();
+	check( itr != route_payouts_t.end(), "there are no route payouts to send" );
+
+	settlements st = get_settlements();
+
+	int count = 0;
+	while (itr != route_payouts_t.end() && count < limit) {
+		issue_lswax( itr->lswax_owed.amount, itr->wallet );
+		st.route_lswax_pending->amount = safeSubInt64( st.route_lswax_pending->amount, itr->lswax_owed.amount );
+		itr = route_payouts_t.erase( itr );
+		count ++;
+	}
+
+	settlements_s.set(st, _self);
+}
+
+/**
+* prunesnaps
+* erases snapshots that every staker has already been paid for
+* only snapshots at or before the watermark from scanstakers are removed
+*/
+
+ACTION fusion::prunesnaps(const int& limit){
+	INSTRUMENT_ACTION("prunesnaps"_n);
+	check( limit > 0 && limit <= 500, "limit must be between 1 and 500" );
+	check( prune_s.exists() && prune_s.get().watermark > 0, "scanstakers has not completed a pass yet" );
+
+	const uint64_t watermark = prune_s.get().watermark;
+	config3 c = config_s_3.get();
+
+	int count = 0;
+
+	auto snap_itr = snaps_t.begin();
+	while (snap_itr != snaps_t.end() && snap_itr->timestamp <= watermark && count < limit) {
+		snap_itr = snaps_t.erase( snap_itr );
+		count ++;
+	}
+
+	//a page can only be erased once its last slot is at or before the watermark
+	auto page_itr = snap_pages_t.begin();
+	while (page_itr != snap_pages_t.end() && count < limit) {
+		const uint64_t last_timestamp = ( ( page_itr->page + 1 ) * SNAPSHOT_PAGE_SIZE - 1 ) * c.seconds_between_distributions + page_itr->phase_seconds;
+		if( last_timestamp > watermark ) break;
+
+		page_itr = snap_pages_t.erase( page_itr );
+		count ++;
+	}
+
+	check( count > 0, "there are no snapshots to prune" );
+}
+
+/**
+* quoteclaim
+* read only, lsWAX that claimaslswax would issue for this user's claimable WAX (including pending rewards)
+*/
+
+conversion_quote fusion::quoteclaim(const eosio::name& user){
+	auto staker = staker_t.require_find(user.value, "you don't have anything staked here");
+
+	int64_t claimable_wax_amount = staker->claimable_wax.amount;
+
+	if( staker->reward_route.value_or( REWARD_ROUTE_CLAIMABLE_WAX ) == REWARD_ROUTE_CLAIMABLE_WAX ){
+		claimable_wax_amount = safeAddInt64( claimable_wax_amount, get_pending_rewards(*staker, get_accrued_rewards()) );
+	}
+
+	check( claimable_wax_amount > 0, "you have nothing to claim" );
+
+	conversion_quote q{};
+	q.input = asset( claimable_wax_amount, WAX_SYMBOL );
+	q.output = asset( internal_liquify( claimable_wax_amount, states.get() ), LSWAX_SYMBOL );
+	q.fee = ZERO_WAX;
+
+	return q;
+}
+
+/**
+* quoteinsta
+* read only, WAX received for instantly redeeming sWAX (instaredeem) or lsWAX (|instant_redeem| memo)
+* fee is the INSTAREDEEM_FEE_1E6 share that goes to revenue
+*/
+
+conversion_quote fusion::quoteinsta(const eosio::asset& quantity){
+	check( quantity.amount > 0, "Must redeem a positive quantity" );
+	check( quantity.amount < MAX_ASSET_AMOUNT, "quantity too large" );
+	check( quantity.symbol == SWAX_SYMBOL || quantity.symbol == LSWAX_SYMBOL, "only SWAX or LSWAX can be redeemed" );
+
+	state s = states.get();
+	int64_t swax_to_redeem = quantity.amount;
+
+	if( quantity.symbol == LSWAX_SYMBOL ){
+		config3 c = config_s_3.get();
+		check( quantity >= c.minimum_unliquify_amount, "minimum unliquify amount not met" );
+		swax_to_redeem = internal_unliquify( quantity.amount, s );
+	}
+
+	check( s.wax_available_for_rentals.amount >= swax_to_redeem, "not enough instaredeem funds available" );
+
+	conversion_quote q{};
+	q.input = quantity;
+	q.output = asset( calculate_asset_share( swax_to_redeem, ONE_HUNDRED_PERCENT_1E6 - INSTAREDEEM_FEE_1E6 ), WAX_SYMBOL );
+	q.fee = asset( calculate_asset_share( swax_to_redeem, INSTAREDEEM_FEE_1E6 ), WAX_SYMBOL );
+
+	return q;
+}
+
+/**
+* quoteliquify
+* read only, lsWAX received for liquifying sWAX (liquify, liquifyexact, |stake_liquify|)
+*/
+
+conversion_quote fusion::quoteliquify(const eosio::asset& quantity){
+	check( quantity.amount > 0, "Invalid quantity." );
+	check( quantity.amount < MAX_ASSET_AMOUNT, "quantity too large" );
+	check( quantity.symbol == SWAX_SYMBOL || quantity.symbol == WAX_SYMBOL, "only SWAX or WAX can be liquified" );
+
+	conversion_quote q{};
+	q.input = quantity;
+	q.output = asset( internal_liquify( quantity.amount, states.get() ), LSWAX_SYMBOL );
+	q.fee = ZERO_WAX;
+
+	return q;
+}
+
+/**
+* quoteredeem
+* read only, shows where reqredeem would place a request of this size
+* mirrors reqredeem against the stored state, so it assumes the epoch has already been synced
+*/
+
+redeem_quote fusion::quoteredeem(const eosio::name& user, const eosio::asset& swax_to_redeem){
+	auto staker = staker_t.require_find(user.value, "you are not staking any sWAX");
+
+	check( swax_to_redeem.amount > 0, "Must redeem a positive quantity" );
+	check( swax_to_redeem.amount < MAX_ASSET_AMOUNT, "quantity too large" );
+
+	state s = states.get();
+	config3 c = config_s_3.get();
+	requests_tbl requests_t = requests_tbl(get_self(), user.value);
+
+	redeem_quote q{};
+	q.swax_to_redeem = swax_to_redeem;
+	q.paid_from_current_window = ZERO_WAX;
+	q.paid_from_rental_pool = ZERO_WAX;
+
+	int64_t remaining_amount_to_fill = swax_to_redeem.amount;
+
+	//an existing request in the open redemption window is paid out first
+	const uint64_t epoch_to_claim_from = s.last_epoch_start_time - c.seconds_between_epochs;
+
+	if( now() < s.last_epoch_start_time + c.redemption_period_length_seconds && epochs_t.find( epoch_to_claim_from ) != epochs_t.end() ){
+		auto req_itr = requests_t.find( epoch_to_claim_from );
+
+		if( req_itr != requests_t.end() ){
+			q.paid_from_current_window = req_itr->wax_amount_requested;
+
+			if( req_itr->wax_amount_requested.amount >= remaining_amount_to_fill ) return q;
+			remaining_amount_to_fill = safeSubInt64( remaining_amount_to_fill, req_itr->wax_amount_requested.amount );
+		}
+	}
+
+	check( staker->swax_balance.amount - q.paid_from_current_window.amount >= remaining_amount_to_fill, "you are trying to redeem more than you have" );
+
+	for(const epoch_capacity& e : get_live_epochs(s, c)){
+		if( e.redemption_period_start_time <= now() ) continue;
+
+		//previous requests in this epoch are replaced, so their amount is available again
+		int64_t amount_available = e.available_for_redemption.amount;
+		auto req_itr = requests_t.find( e.epoch_id );
+
+		if( req_itr != requests_t.end() && e.epoch_id != epoch_to_claim_from ){
+			amount_available = safeAddInt64( amount_available, req_itr->wax_amount_requested.amount );
+		}
+
+		if( amount_available <= 0 ) continue;
+
+		const int64_t amount_requested = std::min( amount_available, remaining_amount_to_fill );
+		q.epoch_requests.push_back( { e.epoch_id, asset( amount_requested, WAX_SYMBOL ) } );
+		remaining_amount_to_fill = safeSubInt64( remaining_amount_to_fill, amount_requested );
+
+		if( remaining_amount_to_fill == 0 ) return q;
+	}
+
+	check( s.wax_available_for_rentals.amount >= remaining_amount_to_fill, "Request amount is greater than amount in epochs and rental pool" );
+	q.paid_from_rental_pool = asset( remaining_amount_to_fill, WAX_SYMBOL );
+
+	return q;
+}
+
+/**
+* quoteunliq
+* read only, sWAX received for unliquifying lsWAX (|unliquify| and |unliquify_exact| memos)
+*/
+
+conversion_quote fusion::quoteunliq(const eosio::asset& quantity){
+	check( quantity.symbol == LSWAX_SYMBOL, "only LSWAX can be unliquified" );
+	check( quantity.amount < MAX_ASSET_AMOUNT, "quantity too large" );
+
+	config3 c = config_s_3.get();
+	check( quantity >= c.minimum_unliquify_amount, "minimum unliquify amount not met" );
+
+	conversion_quote q{};
+	q.input = quantity;
+	q.output = asset( internal_unliquify( quantity.amount, states.get() ), SWAX_SYMBOL );
+	q.fee = ZERO_WAX;
+
+	return q;
+}
+
 /**
 * reallocate
 * used for taking any funds that were requested to be redeemed, but werent redeemed in time
 */ 
 
 ACTION fusion::reallocate(){
+	INSTRUMENT_ACTION("reallocate"_n);
 	sync_epoch();
 
 	state s = states.get();
@@ -690,10 +1198,11 @@ ACTION fusion::reallocate(){
 	s.wax_available_for_rentals.amount = safeAddInt64(s.wax_available_for_rentals.amount, s.wax_for_redemption.amount);
 	s.wax_for_redemption = ZERO_WAX;
 
-	states.set(s, _self);
+	save_state(s);
 }
 
 ACTION fusion::redeem(const eosio::name& user){
+	INSTRUMENT_ACTION("redeem"_n);
 	require_auth(user);
 	sync_user(user);
 	sync_epoch();
@@ -707,9 +1216,7 @@ ACTION fusion::redeem(const eosio::name& user){
 
 	uint64_t epoch_to_claim_from = s.last_epoch_start_time - c.seconds_between_epochs;
  
-	check( now() < redemption_end_time, 
-		( "next redemption does not start until " + std::to_string(s.last_epoch_start_time + c.seconds_between_epochs) ).c_str() 
-	);
+	check_or( now() < redemption_end_time, [&]{ return "next redemption does not start until " + std::to_string(s.last_epoch_start_time + c.seconds_between_epochs); } );
 
 	//find if the user has a request for this period
 	requests_tbl requests_t = requests_tbl(get_self(), user.value);
@@ -744,12 +1251,15 @@ ACTION fusion::redeem(const eosio::name& user){
 	//transfer wax to the user
 	transfer_tokens( user, req_itr->wax_amount_requested, WAX_CONTRACT, std::string("your sWAX redemption from waxfusion.io - liquid staking protocol") );
 
+	save_state(s);
+
 	//erase the request
 	req_itr = requests_t.erase(req_itr);
 }
 
 
 ACTION fusion::removeadmin(const eosio::name& admin_to_remove){
+	INSTRUMENT_ACTION("removeadmin"_n);
 	require_auth(_self);
 
 	config3 c = config_s_3.get();
@@ -773,6 +1283,7 @@ ACTION fusion::removeadmin(const eosio::name& admin_to_remove){
 */ 
 
 ACTION fusion::reqredeem(const eosio::name& user, const eosio::asset& swax_to_redeem, const bool& accept_replacing_prev_requests){
+	INSTRUMENT_ACTION("reqredeem"_n);
 	require_auth(user);
 	sync_user(user);
 	sync_epoch();
@@ -851,6 +1362,10 @@ ACTION fusion::reqredeem(const eosio::name& user, const eosio::asset& swax_to_re
 					_s.swax_balance.amount = safeSubInt64( _s.swax_balance.amount, req_itr->wax_amount_requested.amount );
 				});
 
+				//same as redeem, the paid out sWAX stops earning and is retired
+				s.swax_currently_earning.amount = safeSubInt64( s.swax_currently_earning.amount, req_itr->wax_amount_requested.amount );
+				retire_swax( req_itr->wax_amount_requested.amount );
+
 				req_itr = requests_t.erase( req_itr );
 
 			}
@@ -859,7 +1374,7 @@ ACTION fusion::reqredeem(const eosio::name& user, const eosio::asset& swax_to_re
 	}
 
 	if( request_can_be_filled ){
-		states.set(s, _self);
+		save_state(s);
 		return;
 	}
 
@@ -868,7 +1383,7 @@ ACTION fusion::reqredeem(const eosio::name& user, const eosio::asset& swax_to_re
 
 	uint64_t epoch_to_request_from = s.last_epoch_start_time - c.seconds_between_epochs;
 
-	std::vector<uint64_t> epochs_to_check = {
+	std::array<uint64_t, 3> epochs_to_check = {
 		epoch_to_request_from,
 		epoch_to_request_from + c.seconds_between_epochs,
 		epoch_to_request_from + ( c.seconds_between_epochs * 2 )
@@ -994,14 +1509,18 @@ ACTION fusion::reqredeem(const eosio::name& user, const eosio::asset& swax_to_re
 			_s.swax_balance.amount = safeSubInt64( _s.swax_balance.amount, remaining_amount_to_fill.amount );
 		});
 
+		s.swax_currently_earning.amount = safeSubInt64( s.swax_currently_earning.amount, remaining_amount_to_fill.amount );
+		retire_swax( remaining_amount_to_fill.amount );
+
 		transfer_tokens( user, asset( remaining_amount_to_fill.amount, WAX_SYMBOL ), WAX_CONTRACT, std::string("your redemption from waxfusion.io - liquid staking protocol") );
 	}
 
-	states.set(s, _self);
+	save_state(s);
 
 }
 
 ACTION fusion::rmvcpucntrct(const eosio::name& contract_to_remove){
+	INSTRUMENT_ACTION("rmvcpucntrct"_n);
 	require_auth(_self);
 
 	config3 c = config_s_3.get();
@@ -1017,13 +1536,52 @@ ACTION fusion::rmvcpucntrct(const eosio::name& contract_to_remove){
 }
 
 ACTION fusion::rmvincentive(const uint64_t& poolId){
+	INSTRUMENT_ACTION("rmvincentive"_n);
 	require_auth( _self );
 
 	auto lp_itr = lpfarms_t.require_find( poolId, "this poolId doesn't exist in the lpfarms table" );
 	lp_itr = lpfarms_t.erase( lp_itr );
 }
 
+/**
+* scanstakers
+* continues the current pass over the stakers table, tracking the oldest last_update
+* stakers without sWAX are skipped, since they are always synced before their balance changes
+* when the pass reaches the end of the table, its minimum becomes the new watermark
+*/
+
+ACTION fusion::scanstakers(const int& limit){
+	INSTRUMENT_ACTION("scanstakers"_n);
+	check( limit > 0 && limit <= 500, "limit must be between 1 and 500" );
+
+	prunestate p = get_prune_state();
+
+	int count = 0;
+	auto itr = staker_t.lower_bound( p.next_staker );
+
+	while (itr != staker_t.end() && count < limit) {
+		if( itr->swax_balance.amount > 0 ){
+			p.pass_min_last_update = std::min( p.pass_min_last_update, itr->last_update );
+		}
+
+		itr ++;
+		count ++;
+	}
+
+	if( itr == staker_t.end() ){
+		p.watermark = p.pass_min_last_update;
+		p.last_pass_completed = now();
+		p.next_staker = 0;
+		p.pass_min_last_update = now();
+	} else {
+		p.next_staker = itr->wallet.value;
+	}
+
+	prune_s.set(p, _self);
+}
+
 ACTION fusion::setfallback(const eosio::name& caller, const eosio::name& receiver){
+	INSTRUMENT_ACTION("setfallback"_n);
 	require_auth(caller);
 	check( is_an_admin(caller), "this action requires auth from one of the admin_wallets in the config table" );
 	check( is_account(receiver), "cpu receiver is not a wax account" );
@@ -1034,6 +1592,7 @@ ACTION fusion::setfallback(const eosio::name& caller, const eosio::name& receive
 }
 
 ACTION fusion::setincentive(const uint64_t& poolId, const eosio::symbol& symbol_to_incentivize, const eosio::name& contract_to_incentivize, const uint64_t& percent_share_1e6){
+	INSTRUMENT_ACTION("setincentive"_n);
 	require_auth( _self );
 	check(percent_share_1e6 > 0, "percent_share_1e6 must be positive");
 
@@ -1086,6 +1645,7 @@ ACTION fusion::setincentive(const uint64_t& poolId, const eosio::symbol& symbol_
 */
 
 ACTION fusion::setpolshare(const uint64_t& pol_share_1e6){
+	INSTRUMENT_ACTION("setpolshare"_n);
 	require_auth( _self );
 	check( pol_share_1e6 >= 5 * SCALE_FACTOR_1E6 && pol_share_1e6 <= 10 * SCALE_FACTOR_1E6, "acceptable range is 5-10%" );
 
@@ -1095,6 +1655,7 @@ ACTION fusion::setpolshare(const uint64_t& pol_share_1e6){
 }
 
 ACTION fusion::setrentprice(const eosio::name& caller, const eosio::asset& cost_to_rent_1_wax){
+	INSTRUMENT_ACTION("setrentprice"_n);
 	require_auth(caller);
 	check( is_an_admin(caller), "this action requires auth from one of the admin_wallets in the config table" );
 	check( cost_to_rent_1_wax.amount > 0, "cost must be positive" );
@@ -1102,11 +1663,85 @@ ACTION fusion::setrentprice(const eosio::name& caller, const eosio::asset& cost_
 
 	state s = states.get();
 	s.cost_to_rent_1_wax = cost_to_rent_1_wax;
-	states.set(s, _self);
+	save_state(s);
 
+	INSTRUMENT_COUNT(inline_actions);
 	action(permission_level{get_self(), "active"_n}, POL_CONTRACT,"setrentprice"_n,std::tuple{ cost_to_rent_1_wax }).send();
 }
 
+/**
+* setroute
+* lets a staker choose what happens to their rewards each time they are synced
+* 0 = claimable WAX, 1 = compound into sWAX, 2 = convert to lsWAX
+* anything that is already claimable stays claimable
+*/
+
+ACTION fusion::setroute(const eosio::name& user, const uint8_t& reward_route){
+	INSTRUMENT_ACTION("setroute"_n);
+	require_auth(user);
+	check( reward_route <= REWARD_ROUTE_CONVERT_LSWAX, "invalid reward route" );
+
+	//rewards up until now are settled using the previous route
+	sync_user(user);
+
+	auto staker = staker_t.require_find(user.value, "you need to use the stake action first");
+
+	staker_t.modify(staker, same_payer, [&](auto &_s){
+		_s.reward_route = reward_route;
+	});
+}
+
+/**
+* setsnaptiers
+* configures the resolution and capacity of each state snapshot ring
+*/
+
+ACTION fusion::setsnaptiers(const std::vector<snapshot_tier>& tiers){
+	INSTRUMENT_ACTION("setsnaptiers"_n);
+	require_auth( _self );
+	check_or( tiers.size() > 0 && tiers.size() <= MAX_SNAPSHOT_TIERS, [&]{ return "must have between 1 and " + std::to_string( MAX_SNAPSHOT_TIERS ) + " tiers"; } );
+
+	std::vector<uint64_t> resolutions {};
+
+	for(const snapshot_tier& tier : tiers){
+		check( tier.resolution_seconds >= 60, "resolution must be at least 60 seconds" );
+		check_or( tier.capacity > 0 && tier.capacity <= MAX_SNAPSHOT_TIER_CAPACITY, [&]{ return "capacity must be between 1 and " + std::to_string( MAX_SNAPSHOT_TIER_CAPACITY ); } );
+		check( std::find( resolutions.begin(), resolutions.end(), tier.resolution_seconds ) == resolutions.end(), "duplicate resolution" );
+		resolutions.push_back( tier.resolution_seconds );
+	}
+
+	snaptiers st{};
+	st.tiers = tiers;
+	snaptiers_s.set(st, _self);
+}
+
+ACTION fusion::setsettleint(const uint64_t& seconds_between_settlements){
+	INSTRUMENT_ACTION("setsettleint"_n);
+	require_auth( _self );
+	check( seconds_between_settlements > 0 && seconds_between_settlements <= LP_FARM_DURATION_SECONDS, "settlement interval must be between 1 second and 1 week" );
+
+	settlements st = get_settlements();
+	st.seconds_between_settlements = seconds_between_settlements;
+	st.next_settlement = std::min( st.next_settlement, now() + seconds_between_settlements );
+	settlements_s.set(st, _self);
+}
+
+/**
+* settle
+* anyone can call this once per settlement interval
+* sends the pol allocations, issues the incentives lsWAX and reconciles the sWAX supply
+* with everything that built up since the last settlement
+*/
+
+ACTION fusion::settle(){
+	INSTRUMENT_ACTION("settle"_n);
+	settlements st = get_settlements();
+
+	check_or( now() >= st.next_settlement, [&]{ return "next settlement is not until " + std::to_string(st.next_settlement); } );
+
+	settle_allocations();
+}
+
 /**
 * stake
 * this just opens a row if necessary so we can react to transfers etc
@@ -1114,6 +1749,7 @@ ACTION fusion::setrentprice(const eosio::name& caller, const eosio::asset& cost_
 */
   
 ACTION fusion::stake(const eosio::name& user){
+	INSTRUMENT_ACTION("stake"_n);
 	require_auth(user);
 
 	auto staker = staker_t.find(user.value);
@@ -1128,6 +1764,8 @@ ACTION fusion::stake(const eosio::name& user){
 		_s.swax_balance = ZERO_SWAX;
 		_s.claimable_wax = ZERO_WAX;
 		_s.last_update = now();
+		_s.reward_per_swax_paid_1e12 = get_rewards().reward_per_swax_1e12;
+		_s.reward_route = REWARD_ROUTE_CLAIMABLE_WAX;
 	});
 }
 
@@ -1137,6 +1775,7 @@ ACTION fusion::stake(const eosio::name& user){
 */ 
 
 ACTION fusion::stakeallcpu(){
+	INSTRUMENT_ACTION("stakeallcpu"_n);
 	sync_epoch();
 
 	//get the last epoch start time
@@ -1144,7 +1783,7 @@ ACTION fusion::stakeallcpu(){
 	config3 c = config_s_3.get();
 
 	//if now > epoch start time + 48h, it means redemption is over
-	check( now() >= s.next_stakeall_time, ( "next stakeall time is not until " + std::to_string(s.next_stakeall_time) ).c_str() );
+	check_or( now() >= s.next_stakeall_time, [&]{ return "next stakeall time is not until " + std::to_string(s.next_stakeall_time); } );
 
 	if(s.wax_available_for_rentals.amount > 0){
 
@@ -1208,7 +1847,61 @@ ACTION fusion::stakeallcpu(){
 
 	//update the next_stakeall_time
 	s.next_stakeall_time += c.seconds_between_stakeall;
-	states.set(s, _self);
+	save_state(s);
+}
+
+/**
+* sweepstakers
+* anyone can call this to settle the legacy snapshot rewards of stakers who haven't synced since streaming started
+* rewards go to claimable_wax, rows that predate the reward extensions are paid for by the contract
+* stakers with a different reward route are left for their next sync
+*/
+
+ACTION fusion::sweepstakers(const int& limit){
+	INSTRUMENT_ACTION("sweepstakers"_n);
+	check( limit > 0 && limit <= 50, "limit must be between 1 and 50" );
+
+	const uint64_t streaming_start_time = get_rewards().streaming_start_time;
+	prunestate p = get_prune_state();
+
+	int count = 0;
+	int64_t total_swept = 0;
+	auto itr = staker_t.lower_bound( p.next_sweep );
+
+	while (itr != staker_t.end() && count < limit) {
+		const bool is_dormant = itr->swax_balance.amount > 0 && itr->last_update < streaming_start_time;
+		const bool routes_to_claimable = itr->reward_route.value_or( REWARD_ROUTE_CLAIMABLE_WAX ) == REWARD_ROUTE_CLAIMABLE_WAX;
+
+		if( is_dormant && routes_to_claimable ){
+			uint64_t paid_through;
+			int64_t wax_owed_to_user = get_snapshot_rewards(itr->swax_balance.amount, itr->last_update, streaming_start_time, paid_through);
+
+			//once every snapshot is paid the row moves up to streaming_start_time, so it isn't dormant anymore
+			const uint64_t last_update = paid_through + 1 >= streaming_start_time ? streaming_start_time : paid_through;
+
+			if( wax_owed_to_user > 0 || last_update != itr->last_update ){
+				staker_t.modify(itr, get_staker_payer(*itr), [&](auto &_s){
+					_s.claimable_wax.amount = safeAddInt64(_s.claimable_wax.amount, wax_owed_to_user);
+					_s.last_update = last_update;
+				});
+			}
+
+			total_swept = safeAddInt64(total_swept, wax_owed_to_user);
+		}
+
+		itr ++;
+		count ++;
+	}
+
+	p.next_sweep = itr == staker_t.end() ? 0 : itr->wallet.value;
+	prune_s.set(p, _self);
+
+	if( total_swept == 0 ) return;
+
+	state s = states.get();
+	s.user_funds_bucket.amount = safeSubInt64(s.user_funds_bucket.amount, total_swept);
+	credit_total_claimable_wax( eosio::asset(total_swept, WAX_SYMBOL) );
+	save_state(s);
 }
 
 /**
@@ -1219,8 +1912,9 @@ ACTION fusion::stakeallcpu(){
 */ 
 
 ACTION fusion::sync(const eosio::name& caller){
+	INSTRUMENT_ACTION("sync"_n);
 	require_auth( caller );
-	check( is_an_admin( caller ), ( caller.to_string() + " is not an admin" ).c_str() );
+	check_or( is_an_admin( caller ), [&]{ return caller.to_string() + " is not an admin"; } );
 	sync_epoch();
 }
 
@@ -1230,13 +1924,15 @@ ACTION fusion::sync(const eosio::name& caller){
 */ 
 
 ACTION fusion::synctvl(const eosio::name& caller){
+	INSTRUMENT_ACTION("synctvl"_n);
 	require_auth( caller );
-	check( is_an_admin( caller ), ( caller.to_string() + " is not an admin" ).c_str() );
+	check_or( is_an_admin( caller ), [&]{ return caller.to_string() + " is not an admin"; } );
 	sync_tvl();
 }
 
 
 ACTION fusion::unstakecpu(const uint64_t& epoch_id, const int& limit){
+	INSTRUMENT_ACTION("unstakecpu"_n);
 	//anyone can call this
 
 	sync_epoch();
@@ -1251,9 +1947,9 @@ ACTION fusion::unstakecpu(const uint64_t& epoch_id, const int& limit){
 	uint64_t epoch_to_check = epoch_id == 0 ? s.last_epoch_start_time - c.seconds_between_epochs : epoch_id;
 
 	//if the unstake time is <= now, look up its cpu contract is delband table
-	auto epoch_itr = epochs_t.require_find( epoch_to_check, ("could not find epoch " + std::to_string( epoch_to_check ) ).c_str() );
+	auto epoch_itr = require_find_or( epochs_t, epoch_to_check, [&]{ return "could not find epoch " + std::to_string( epoch_to_check ); } );
 
-	check( epoch_itr->time_to_unstake <= now(), ("can not unstake until another " + std::to_string( epoch_itr-> time_to_unstake - now() ) + " seconds has passed").c_str() );
+	check_or( epoch_itr->time_to_unstake <= now(), [&]{ return "can not unstake until another " + std::to_string( epoch_itr-> time_to_unstake - now() ) + " seconds has passed"; } );
 
 	del_bandwidth_table del_tbl( SYSTEM_CONTRACT, epoch_itr->cpu_wallet.value );
 
@@ -1263,6 +1959,7 @@ ACTION fusion::unstakecpu(const uint64_t& epoch_id, const int& limit){
 
 	int rows_limit = limit == 0 ? 500 : limit;
 
+	INSTRUMENT_COUNT(inline_actions);
 	action(permission_level{get_self(), "active"_n}, epoch_itr->cpu_wallet,"unstakebatch"_n,std::tuple{ rows_limit }).send();
 
 	renters_table renters_t = renters_table( _self, epoch_to_check );
@@ -1282,6 +1979,7 @@ ACTION fusion::unstakecpu(const uint64_t& epoch_id, const int& limit){
 }
 
 ACTION fusion::updatetop21(){
+	INSTRUMENT_ACTION("updatetop21"_n);
 	top21 t = top21_s.get();
 
 	check( t.last_update + (60 * 60 * 24) <= now(), "hasn't been 24h since last top21 update" );
@@ -1314,7 +2012,7 @@ ACTION fusion::updatetop21(){
 
 	std::vector<eosio::name> producers_to_vote_for {};
 
-	for(auto t : top_producers){
+	for(const auto& t : top_producers){
 		producers_to_vote_for.push_back(t.first.producer_name);
 	}
 
@@ -10,15 +10,22 @@
 #include <eosio/system.hpp>
 #include <eosio/symbol.hpp>
 #include <string>
+#include <string_view>
+#include <array>
 #include <eosio/crypto.hpp>
 #include <eosio/transaction.hpp>
 #include <eosio/singleton.hpp>
 #include <eosio/binary_extension.hpp>
 #include <eosio/producer_schedule.hpp>
 #include<map>
+#include <optional>
 #include "structs.hpp"
 #include "constants.hpp"
+#include "safe_math.hpp"
 #include "tables.hpp"
+#include "invariants.hpp"
+#include "instrumentation.hpp"
+#include "checks.hpp"
 
 using namespace eosio;
 
@@ -28,14 +35,39 @@ CONTRACT fusion : public contract {
 
 		fusion(name receiver, name code, datastream<const char *> ds):
 		contract(receiver, code, ds),
+		audit_s(receiver, receiver.value),
 		config_s_3(receiver, receiver.value),
 		pol_state_s_2(POL_CONTRACT, POL_CONTRACT.value),
+		prune_s(receiver, receiver.value),
+		rewards_s(receiver, receiver.value),
+		settlements_s(receiver, receiver.value),
+		snaptiers_s(receiver, receiver.value),
 		states(receiver, receiver.value),
 		state_s_2(receiver, receiver.value),
 		state_s_3(receiver, receiver.value),
 		top21_s(receiver, receiver.value)
 		{}		
 
+#if INSTRUMENT || INVARIANTS
+		~fusion() noexcept(false) {
+#if INVARIANTS
+			check_invariants();
+#endif
+#if INSTRUMENT
+			flush_instrumentation();
+#endif
+		}
+#endif
+
+#if HOST_TESTS
+		//the host fuzz targets call the math helpers directly
+		friend struct host_math;
+#endif
+
+#if INSTRUMENT
+		[[eosio::action, eosio::read_only]] actionstats getstats(const eosio::name& action_name);
+#endif
+
 		//Main Actions
 		ACTION addadmin(const eosio::name& admin_to_add);
 		ACTION addcpucntrct(const eosio::name& contract_to_add);
@@ -44,11 +76,18 @@ CONTRACT fusion : public contract {
 		ACTION claimrefunds();
 		ACTION claimrewards(const eosio::name& user);
 		ACTION claimswax(const eosio::name& user);
+		ACTION clearsnaps(const uint64_t& resolution_seconds, const int& limit);
 		ACTION clearexpired(const eosio::name& user);
 		ACTION createfarms();
 		ACTION distribute();
+		[[eosio::action, eosio::read_only]] apr_quote getapr(const uint64_t& window_seconds);
+		[[eosio::action, eosio::read_only]] dashboard getdashboard();
+		[[eosio::action, eosio::read_only]] staker_position getposition(const eosio::name& user);
+		[[eosio::action, eosio::read_only]] exchange_rates getrates();
 		ACTION initconfig();
 		ACTION initconfig3();
+		ACTION initrewards();
+		ACTION initsettle();
 		ACTION initstate2();
 		ACTION initstate3();
 		ACTION inittop21();
@@ -56,18 +95,32 @@ CONTRACT fusion : public contract {
 		ACTION liquify(const eosio::name& user, const eosio::asset& quantity);
 		ACTION liquifyexact(const eosio::name& user, const eosio::asset& quantity, 
 			const eosio::asset& expected_output, const uint64_t& max_slippage_1e6);
+		ACTION migratesnaps(const int& limit);
+		ACTION payroutes(const int& limit);
+		ACTION prunesnaps(const int& limit);
+		[[eosio::action, eosio::read_only]] conversion_quote quoteclaim(const eosio::name& user);
+		[[eosio::action, eosio::read_only]] conversion_quote quoteinsta(const eosio::asset& quantity);
+		[[eosio::action, eosio::read_only]] conversion_quote quoteliquify(const eosio::asset& quantity);
+		[[eosio::action, eosio::read_only]] redeem_quote quoteredeem(const eosio::name& user, const eosio::asset& swax_to_redeem);
+		[[eosio::action, eosio::read_only]] conversion_quote quoteunliq(const eosio::asset& quantity);
 		ACTION reallocate();
 		ACTION redeem(const eosio::name& user);
 		ACTION removeadmin(const eosio::name& admin_to_remove);
 		ACTION reqredeem(const eosio::name& user, const eosio::asset& swax_to_redeem, const bool& accept_replacing_prev_requests);
 		ACTION rmvcpucntrct(const eosio::name& contract_to_remove);
 		ACTION rmvincentive(const uint64_t& poolId);
+		ACTION scanstakers(const int& limit);
 		ACTION setfallback(const eosio::name& caller, const eosio::name& receiver);
 		ACTION setincentive(const uint64_t& poolId, const eosio::symbol& symbol_to_incentivize, const eosio::name& contract_to_incentivize, const uint64_t& percent_share_1e6);
 		ACTION setpolshare(const uint64_t& pol_share_1e6);
 		ACTION setrentprice(const eosio::name& caller, const eosio::asset& cost_to_rent_1_wax);
+		ACTION setroute(const eosio::name& user, const uint8_t& reward_route);
+		ACTION setsnaptiers(const std::vector<snapshot_tier>& tiers);
+		ACTION setsettleint(const uint64_t& seconds_between_settlements);
+		ACTION settle();
 		ACTION stake(const eosio::name& user);
 		ACTION stakeallcpu();
+		ACTION sweepstakers(const int& limit);
 		ACTION sync(const eosio::name& caller);
 		ACTION synctvl(const eosio::name& caller);
 		ACTION unstakecpu(const uint64_t& epoch_id, const int& limit);
@@ -80,48 +133,90 @@ CONTRACT fusion : public contract {
 	private:
 
 		//Singletons
-		config_singleton_3 config_s_3;
-		pol_contract::state_singleton_2 pol_state_s_2;
-		state_singleton states;
-		state_singleton_2 state_s_2;
-		state_singleton_3 state_s_3;
-		top21_singleton top21_s;
+		instrumented<audit_singleton> audit_s;
+		instrumented<config_singleton_3> config_s_3;
+		instrumented<pol_contract::state_singleton_2> pol_state_s_2;
+		instrumented<prunestate_singleton> prune_s;
+		instrumented<rewards_singleton> rewards_s;
+		instrumented<settlements_singleton> settlements_s;
+		instrumented<snaptiers_singleton> snaptiers_s;
+		instrumented<state_singleton> states;
+		instrumented<state_singleton_2> state_s_2;
+		instrumented<state_singleton_3> state_s_3;
+		instrumented<top21_singleton> top21_s;
 
 		//Multi Index Tables
-		alcor_contract::incentives_table incentives_t = alcor_contract::incentives_table(ALCOR_CONTRACT, ALCOR_CONTRACT.value);
-		alcor_contract::pools_table pools_t = alcor_contract::pools_table(ALCOR_CONTRACT, ALCOR_CONTRACT.value);
-		debug_table debug_t = debug_table(get_self(), get_self().value);
-		epochs_table epochs_t = epochs_table(get_self(), get_self().value);
-		lpfarms_table lpfarms_t = lpfarms_table(get_self(), get_self().value);
-		snaps_table snaps_t = snaps_table(get_self(), get_self().value);
-		producers_table _producers = producers_table(SYSTEM_CONTRACT, SYSTEM_CONTRACT.value);
-		staker_table staker_t = staker_table(get_self(), get_self().value);
-		state_snaps_table state_snaps_t = state_snaps_table(get_self(), get_self().value);
+		instrumented<alcor_contract::incentives_table> incentives_t = instrumented<alcor_contract::incentives_table>(ALCOR_CONTRACT, ALCOR_CONTRACT.value);
+		instrumented<alcor_contract::pools_table> pools_t = instrumented<alcor_contract::pools_table>(ALCOR_CONTRACT, ALCOR_CONTRACT.value);
+		instrumented<debug_table> debug_t = instrumented<debug_table>(get_self(), get_self().value);
+		instrumented<epochs_table> epochs_t = instrumented<epochs_table>(get_self(), get_self().value);
+		instrumented<lpfarms_table> lpfarms_t = instrumented<lpfarms_table>(get_self(), get_self().value);
+		instrumented<snap_pages_table> snap_pages_t = instrumented<snap_pages_table>(get_self(), get_self().value);
+		instrumented<snaps_table> snaps_t = instrumented<snaps_table>(get_self(), get_self().value);
+		instrumented<producers_table> _producers = instrumented<producers_table>(SYSTEM_CONTRACT, SYSTEM_CONTRACT.value);
+		instrumented<route_payouts_table> route_payouts_t = instrumented<route_payouts_table>(get_self(), get_self().value);
+		instrumented<staker_table> staker_t = instrumented<staker_table>(get_self(), get_self().value);
+		instrumented<state_snaps_table> state_snaps_t = instrumented<state_snaps_table>(get_self(), get_self().value);
+
+		//state_wax_owed of the last state written by save_state during this action
+		std::optional<int64_t> saved_state_wax_owed;
 
 
 		//Functions
+		void accrue_rewards(rewards& rw, const int64_t& swax_earning);
+#if INVARIANTS
+		void check_invariants();
+#endif
 		int64_t calculate_asset_share(const int64_t& quantity, const uint64_t& percentage);
 		void create_alcor_farm(const uint64_t& poolId, const eosio::symbol& token_symbol, const eosio::name& token_contract);
+		void credit_route_payout(const eosio::name& user, const int64_t& lswax_amount);
+		void credit_settlements(const int64_t& pol_wax_amount, const int64_t& incentives_wax_amount);
 		void credit_total_claimable_wax(const eosio::asset& amount_to_credit);
 		uint64_t days_to_seconds(const uint64_t& days);
 		void debit_total_claimable_wax(const eosio::asset& amount_to_debit);
+#if INSTRUMENT
+		void flush_instrumentation();
+#endif
 		void debit_user_redemptions_if_necessary(const name& user, const asset& swax_balance);
 		std::string cpu_stake_memo(const eosio::name& cpu_receiver, const uint64_t& epoch_timestamp);
-		uint64_t get_seconds_to_rent_cpu(state s, config3 c, const uint64_t& epoch_id_to_rent_from);
-		std::vector<std::string> get_words(std::string memo);
+		rewards get_accrued_rewards();
+		std::vector<epoch_capacity> get_live_epochs(const state& s, const config3& c);
+		uint64_t get_lswax_rate_1e12(const state& s);
+		int64_t get_pending_rewards(const stakers& staker, const rewards& rw);
+		prunestate get_prune_state();
+		rewards get_rewards();
+		settlements get_settlements();
+		uint64_t get_seconds_to_rent_cpu(const state& s, const config3& c, const uint64_t& epoch_id_to_rent_from);
+		memo_words get_words(std::string_view memo);
+		snapshots get_snapshot(const uint64_t& timestamp);
+		int64_t get_snapshot_rewards(const int64_t& swax_balance, const uint64_t& last_update, const uint64_t& snapshots_end, uint64_t& paid_through);
+		std::vector<snapshot_tier> get_snapshot_tiers();
+		eosio::name get_staker_payer(const stakers& staker);
+		int64_t get_wax_balance(const eosio::name& account);
+		int64_t internal_get_earned_rewards(const int64_t& user_stake, const uint128_t& reward_per_swax_delta);
+		uint128_t internal_get_reward_per_swax(const int64_t& reward_amount, const int64_t& total_stake);
+		int64_t internal_get_streamed_rewards(const int64_t& rewards_remaining, const uint64_t& elapsed, const uint64_t& duration);
 		int64_t internal_get_swax_allocations( const int64_t& amount, const int64_t& swax_divisor, const int64_t& swax_supply );
 		int64_t internal_get_wax_owed_to_user(const int64_t& user_stake, const int64_t& total_stake, const int64_t& reward_pool);
-		int64_t internal_liquify(const int64_t& quantity, state s);
-		int64_t internal_unliquify(const int64_t& quantity, state s);
+		int64_t internal_liquify(const int64_t& quantity, const state& s);
+		int64_t internal_unliquify(const int64_t& quantity, const state& s);
 		bool is_an_admin(const eosio::name& user);
 		bool is_cpu_contract(const eosio::name& contract);
 		void issue_lswax(const int64_t& amount, const eosio::name& receiver);
 		void issue_swax(const int64_t& amount);
 		bool memo_is_expected(const std::string& memo);
+		uint64_t memo_to_uint64(std::string_view word, const char* field);
 		uint64_t now();
+		int64_t state_wax_owed(const state& s);
+		void record_wax_received(const int64_t& amount, const bool& changes_tvl);
+		void record_wax_sent(const eosio::name& receiver, const int64_t& amount);
 		void retire_lswax(const int64_t& amount);
 		void retire_swax(const int64_t& amount);
+		void save_state(const state& s);
+		void settle_allocations();
+		void stream_rewards(const int64_t& amount_to_stream);
 		void sync_epoch();
+		rewards sync_rewards();
 		void sync_tvl();
 		void sync_user(const eosio::name& user);
 		void transfer_tokens(const name& user, const asset& amount_to_send, const name& contract, const std::string& memo);
@@ -129,6 +224,9 @@ CONTRACT fusion : public contract {
 			const int64_t& eco_alloc_i64, const int64_t& swax_autocompounding_alloc_i64,
       		const int64_t& swax_earning_alloc_i64, const int64_t& amount_to_distribute_i64);
 		void validate_token(const eosio::symbol& symbol, const eosio::name& contract);
+		void write_rate_history(const state& s);
+		void write_snapshot_page(const snapshots& snap);
+		void write_state_ring(const state2& s2, const state3& s3);
 		void zero_distribution();
 
 		//Safemath
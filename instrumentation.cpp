@@ -0,0 +1,55 @@
+#pragma once
+
+#if INSTRUMENT
+
+/**
+* flush_instrumentation
+* adds this action's counts to its row in actionstats
+* read only actions never set an action name, so they don't write anything
+*/
+
+void fusion::flush_instrumentation(){
+  const action_counts& counts = instrument_counts();
+  if( current_action().value == 0 ) return;
+
+  action_stats_table stats_t = action_stats_table( _self, _self.value );
+  auto stats_itr = stats_t.find( current_action().value );
+
+  auto add_counts = [&](auto &_s){
+    _s.invocations ++;
+    _s.db_reads += counts.db_reads;
+    _s.db_writes += counts.db_writes;
+    _s.inline_actions += counts.inline_actions;
+    _s.rows_emplaced += counts.rows_emplaced;
+    _s.rows_erased += counts.rows_erased;
+    _s.snapshots_iterated += counts.snapshots_iterated;
+  };
+
+  if( stats_itr == stats_t.end() ){
+    stats_t.emplace(_self, [&](auto &_s){
+      _s.action = current_action();
+      _s.invocations = 0;
+      _s.db_reads = 0;
+      _s.db_writes = 0;
+      _s.inline_actions = 0;
+      _s.rows_emplaced = 0;
+      _s.rows_erased = 0;
+      _s.snapshots_iterated = 0;
+      add_counts(_s);
+    });
+  } else {
+    stats_t.modify(stats_itr, same_payer, add_counts);
+  }
+}
+
+/**
+* getstats
+* read only, returns the accumulated counts for an action
+*/
+
+actionstats fusion::getstats(const eosio::name& action_name){
+  action_stats_table stats_t = action_stats_table( _self, _self.value );
+  return stats_t.get( action_name.value, "there are no stats for this action" );
+}
+
+#endif
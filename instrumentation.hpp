@@ -0,0 +1,119 @@
+#pragma once
+
+/**
+* per action instrumentation, only compiled when INSTRUMENT is true
+* e.g. eosio-cpp -DINSTRUMENT=true ...
+* with it off, the macros are empty and instrumented<T> is just T, so nothing here reaches the wasm
+*
+* counts are kept in memory for the duration of the action and added to the actionstats
+* table when the contract is destroyed (after the action has succeeded)
+* reads are lookups (find, get, lower_bound etc), iterating with ++ is not counted
+* only tables declared as contract members are counted, tables constructed locally with a scope are not
+*/
+
+#ifndef INSTRUMENT
+#define INSTRUMENT false
+#endif
+
+//the action name is also used by INVARIANTS to report which action failed
+#if INSTRUMENT || INVARIANTS
+
+inline eosio::name& current_action(){
+  static eosio::name action;
+  return action;
+}
+
+#define INSTRUMENT_ACTION(action_name) current_action() = action_name
+
+#else
+
+#define INSTRUMENT_ACTION(action_name)
+
+#endif
+
+#if INSTRUMENT
+
+struct action_counts {
+  uint64_t      db_reads = 0;
+  uint64_t      db_writes = 0;
+  uint64_t      inline_actions = 0;
+  uint64_t      rows_emplaced = 0;
+  uint64_t      rows_erased = 0;
+  uint64_t      snapshots_iterated = 0;
+};
+
+inline action_counts& instrument_counts(){
+  static action_counts counts;
+  return counts;
+}
+
+#define INSTRUMENT_COUNT(counter) instrument_counts().counter ++
+
+template<typename Table>
+class counted_table : public Table {
+  public:
+    using Table::Table;
+
+    template<typename... Args> auto begin(Args&&... args) const { INSTRUMENT_COUNT(db_reads); return Table::begin(std::forward<Args>(args)...); }
+    template<typename... Args> auto find(Args&&... args) const { INSTRUMENT_COUNT(db_reads); return Table::find(std::forward<Args>(args)...); }
+    template<typename... Args> auto get(Args&&... args) const -> decltype(auto) { INSTRUMENT_COUNT(db_reads); return Table::get(std::forward<Args>(args)...); }
+    template<typename... Args> auto lower_bound(Args&&... args) const { INSTRUMENT_COUNT(db_reads); return Table::lower_bound(std::forward<Args>(args)...); }
+    template<typename... Args> auto require_find(Args&&... args) const { INSTRUMENT_COUNT(db_reads); return Table::require_find(std::forward<Args>(args)...); }
+    template<typename... Args> auto upper_bound(Args&&... args) const { INSTRUMENT_COUNT(db_reads); return Table::upper_bound(std::forward<Args>(args)...); }
+
+    template<typename Lambda> auto emplace(eosio::name payer, Lambda&& constructor){
+      INSTRUMENT_COUNT(db_writes);
+      INSTRUMENT_COUNT(rows_emplaced);
+      return Table::emplace(payer, std::forward<Lambda>(constructor));
+    }
+
+    template<typename Target> auto erase(const Target& target){
+      INSTRUMENT_COUNT(db_writes);
+      INSTRUMENT_COUNT(rows_erased);
+      return Table::erase(target);
+    }
+
+    template<typename Target, typename Lambda> void modify(const Target& target, eosio::name payer, Lambda&& updater){
+      INSTRUMENT_COUNT(db_writes);
+      Table::modify(target, payer, std::forward<Lambda>(updater));
+    }
+};
+
+template<typename Singleton>
+class counted_singleton : public Singleton {
+  public:
+    using Singleton::Singleton;
+
+    bool exists(){ INSTRUMENT_COUNT(db_reads); return Singleton::exists(); }
+    auto get(){ INSTRUMENT_COUNT(db_reads); return Singleton::get(); }
+    template<typename T> auto get_or_default(const T& def){ INSTRUMENT_COUNT(db_reads); return Singleton::get_or_default(def); }
+    template<typename T> void set(const T& value, eosio::name payer){ INSTRUMENT_COUNT(db_writes); Singleton::set(value, payer); }
+    void remove(){ INSTRUMENT_COUNT(db_writes); Singleton::remove(); }
+};
+
+template<typename T> struct instrumented_type { using type = counted_table<T>; };
+template<eosio::name::raw SingletonName, typename T> struct instrumented_type<eosio::singleton<SingletonName, T>> { using type = counted_singleton<eosio::singleton<SingletonName, T>>; };
+template<typename T> using instrumented = typename instrumented_type<T>::type;
+
+struct [[eosio::table, eosio::contract(CONTRACT_NAME)]] actionstats {
+  eosio::name       action;
+  uint64_t          invocations;
+  uint64_t          db_reads;
+  uint64_t          db_writes;
+  uint64_t          inline_actions;
+  uint64_t          rows_emplaced;
+  uint64_t          rows_erased;
+  uint64_t          snapshots_iterated;
+
+  uint64_t primary_key() const { return action.value; }
+};
+using action_stats_table = eosio::multi_index<"actionstats"_n, actionstats
+>;
+
+#else
+
+#define INSTRUMENT_COUNT(counter)
+
+template<typename T> using instrumented = T;
+
+#endif
@@ -12,9 +12,52 @@ int64_t fusion::calculate_asset_share(const int64_t& quantity, const uint64_t& p
 	//formula is ( quantity * percentage ) / ( 100 * SCALE_FACTOR_1E6 )
 	if(quantity == 0) return 0;
 
-	uint128_t result_128 = safeMulUInt128( (uint128_t) quantity, (uint128_t) percentage ) / safeMulUInt128( (uint128_t) 100, SCALE_FACTOR_1E6 );
+	uint128_t result_128 = safe_math::muldiv_by<ONE_HUNDRED_PERCENT_1E6>( (uint128_t) quantity, (uint128_t) percentage );
 
-  	return (int64_t) result_128;	
+  	return safe_math::to_int64( result_128 );	
+}
+
+/** internal_get_earned_rewards
+ *  used when syncing a user to find out how much WAX they earned
+ *  since their reward_per_swax_paid_1e12 was last updated
+ */
+
+int64_t fusion::internal_get_earned_rewards(const int64_t& user_stake, const uint128_t& reward_per_swax_delta){
+	//formula is ( user_stake * reward_per_swax_delta ) / SCALE_FACTOR_1E12
+	if( user_stake == 0 || reward_per_swax_delta == 0 ) return 0;
+
+	//reward_per_swax_delta can exceed MAX_ASSET_AMOUNT when very little sWAX is earning, so safe_math::mul can't be used here
+	check( reward_per_swax_delta <= MAX_U128_VALUE / (uint128_t) user_stake, "earned rewards calculation would result in overflow" );
+
+	uint128_t result_128 = ( (uint128_t) user_stake * reward_per_swax_delta ) / SCALE_FACTOR_1E12;
+	check( result_128 <= (uint128_t) MAX_ASSET_AMOUNT_U64, "earned rewards are outside of the acceptable range" );
+
+	return (int64_t) result_128;
+}
+
+/** internal_get_reward_per_swax
+ *  converts an amount of streamed WAX into the amount earned by each sWAX
+ *  that was earning at the time, scaled by 1e12
+ */
+
+uint128_t fusion::internal_get_reward_per_swax(const int64_t& reward_amount, const int64_t& total_stake){
+	//reward_amount and total_stake should have already been verified to be > 0
+	//formula is ( reward_amount * SCALE_FACTOR_1E12 ) / total_stake
+
+	return safe_math::muldiv( (uint128_t) reward_amount, SCALE_FACTOR_1E12, (uint128_t) total_stake );
+}
+
+/** internal_get_streamed_rewards
+ *  rewards are released linearly, so the amount released is proportional 
+ *  to how much of the remaining period has elapsed
+ */
+
+int64_t fusion::internal_get_streamed_rewards(const int64_t& rewards_remaining, const uint64_t& elapsed, const uint64_t& duration){
+	if( elapsed >= duration ) return rewards_remaining;
+
+	//formula is ( rewards_remaining * elapsed ) / duration
+	uint128_t result_128 = safe_math::muldiv( (uint128_t) rewards_remaining, (uint128_t) elapsed, (uint128_t) duration );
+	return safe_math::to_int64( result_128 );
 }
 
 /** internal_get_swax_allocations
@@ -29,16 +72,16 @@ int64_t fusion::internal_get_swax_allocations( const int64_t& amount, const int6
 
 	//formula is ( amount *  swax_divisor ) / swax_supply
 
-	uint128_t result_128 = safeMulUInt128( (uint128_t) amount, (uint128_t) swax_divisor ) / (uint128_t) swax_supply;
-	return (int64_t) result_128;	
+	uint128_t result_128 = safe_math::muldiv( (uint128_t) amount, (uint128_t) swax_divisor, (uint128_t) swax_supply );
+	return safe_math::to_int64( result_128 );	
 }
 
 int64_t fusion::internal_get_wax_owed_to_user(const int64_t& user_stake, const int64_t& total_stake, const int64_t& reward_pool){
 	//user_stake, total_stake and reward_pool should have already been verified to be > 0
 	//formula is ( user_stake * reward_pool ) / total_stake
 
-	uint128_t result_128 = safeMulUInt128( (uint128_t) user_stake, (uint128_t) reward_pool ) / (uint128_t) total_stake;
-	return (int64_t) result_128;
+	uint128_t result_128 = safe_math::muldiv( (uint128_t) user_stake, (uint128_t) reward_pool, (uint128_t) total_stake );
+	return safe_math::to_int64( result_128 );
 }
 
 /** internal_liquify
@@ -46,7 +89,7 @@ int64_t fusion::internal_get_wax_owed_to_user(const int64_t& user_stake, const i
  *  then calculates the lswax output amount and returns it
  */
 
-int64_t fusion::internal_liquify(const int64_t& quantity, state s){
+int64_t fusion::internal_liquify(const int64_t& quantity, const state& s){
 	//contract should have already validated quantity before calling this
 
     /** need to account for initial period where the values are still 0
@@ -59,14 +102,14 @@ int64_t fusion::internal_liquify(const int64_t& quantity, state s){
      ){
       return quantity;
     } else {
-      	uint128_t result_128 = safeMulUInt128( (uint128_t) s.liquified_swax.amount, (uint128_t) quantity ) / (uint128_t) s.swax_currently_backing_lswax.amount;
-      	return (int64_t) result_128;
+      	uint128_t result_128 = safe_math::muldiv( (uint128_t) s.liquified_swax.amount, (uint128_t) quantity, (uint128_t) s.swax_currently_backing_lswax.amount );
+      	return safe_math::to_int64( result_128 );
     }		
 }
 
-int64_t fusion::internal_unliquify(const int64_t& quantity, state s){
+int64_t fusion::internal_unliquify(const int64_t& quantity, const state& s){
 	//contract should have already validated quantity before calling this
 	
-  	uint128_t result_128 = safeMulUInt128( (uint128_t) s.swax_currently_backing_lswax.amount, (uint128_t) quantity ) / (uint128_t) s.liquified_swax.amount;
-  	return (int64_t) result_128;	
+  	uint128_t result_128 = safe_math::muldiv( (uint128_t) s.swax_currently_backing_lswax.amount, (uint128_t) quantity, (uint128_t) s.liquified_swax.amount );
+  	return safe_math::to_int64( result_128 );	
 }
\ No newline at end of file
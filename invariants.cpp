@@ -0,0 +1,99 @@
+#pragma once
+
+#if INVARIANTS
+
+/**
+* check_invariants
+* recomputes the accounting invariants at the end of an action
+* tables are constructed locally so INSTRUMENT doesn't count these reads
+* nothing is checked until the state singletons have been initialized
+*/
+
+void fusion::check_invariants(){
+  if( invariant_deltas().skip ) return;
+
+  state_singleton states_local(_self, _self.value);
+  state_singleton_2 state_2_local(_self, _self.value);
+  state_singleton_3 state_3_local(_self, _self.value);
+  settlements_singleton settlements_local(_self, _self.value);
+  config_singleton_3 config_local(_self, _self.value);
+
+  if( !states_local.exists() || !state_2_local.exists() || !state_3_local.exists() || !settlements_local.exists() || !config_local.exists() ) return;
+
+  const state s = states_local.get();
+  const state2 s2 = state_2_local.get();
+  const state3 s3 = state_3_local.get();
+  settlements st = settlements_local.get();
+  if( !st.swax_pending_issue.has_value() ) st.swax_pending_issue = ZERO_SWAX;
+  if( !st.swax_pending_retire.has_value() ) st.swax_pending_retire = ZERO_SWAX;
+  if( !st.incentives_wax_pending.has_value() ) st.incentives_wax_pending = ZERO_WAX;
+  if( !st.route_lswax_pending.has_value() ) st.route_lswax_pending = ZERO_LSWAX;
+  const inline_deltas& deltas = invariant_deltas();
+  auto violation = [&](const std::string& detail){ return "invariant violated after " + current_action().to_string() + ": " + detail; };
+
+  //no bucket can go negative
+  for( const eosio::asset& bucket : { s.swax_currently_earning, s.swax_currently_backing_lswax, s.liquified_swax, s.revenue_awaiting_distribution,
+      s.user_funds_bucket, s.wax_for_redemption, s.wax_available_for_rentals, s2.incentives_bucket, s3.total_claimable_wax,
+      st.pol_wax_pending, st.lswax_pending_issue, *st.swax_pending_issue, *st.swax_pending_retire, *st.incentives_wax_pending, *st.route_lswax_pending } ){
+    check_or( bucket.amount >= 0, [&]{ return violation( "bucket is negative (" + bucket.to_string() + ")" ); } );
+  }
+
+  //sWAX supply, including what is waiting in settlements and what was issued/retired inline during this action
+  //distribute also issues sWAX for the earning share, which stakers receive as claimable WAX and
+  //which claimswax/compounding issue again, so the supply can only be checked as an upper bound
+  stat_table swax_stats_t = stat_table( TOKEN_CONTRACT, SWAX_SYMBOL.code().raw() );
+  auto swax_itr = swax_stats_t.find( SWAX_SYMBOL.code().raw() );
+
+  if( swax_itr != swax_stats_t.end() ){
+    const int64_t swax_supply = swax_itr->supply.amount + deltas.swax_supply + st.swax_pending_issue->amount - st.swax_pending_retire->amount;
+    const int64_t swax_tracked = s.swax_currently_earning.amount + s.swax_currently_backing_lswax.amount;
+    check_or( swax_tracked <= swax_supply, [&]{ return violation( "sWAX earning + backing lsWAX is " + std::to_string(swax_tracked) + " but supply is only " + std::to_string(swax_supply) ); } );
+  }
+
+  //lsWAX supply
+  stat_table lswax_stats_t = stat_table( TOKEN_CONTRACT, LSWAX_SYMBOL.code().raw() );
+  auto lswax_itr = lswax_stats_t.find( LSWAX_SYMBOL.code().raw() );
+
+  if( lswax_itr != lswax_stats_t.end() ){
+    const int64_t lswax_supply = lswax_itr->supply.amount + deltas.lswax_supply + st.lswax_pending_issue.amount + st.route_lswax_pending->amount;
+    check_or( s.liquified_swax.amount == lswax_supply, [&]{ return violation( "liquified sWAX is " + std::to_string(s.liquified_swax.amount) + " but lsWAX supply is " + std::to_string(lswax_supply) ); } );
+  }
+
+  //WAX an epoch's cpu contract hasn't sent back yet. sync_tvl only counts the 3 epochs around
+  //last_epoch_start_time, which misses an epoch between the start of its redemption period and its return
+  epochs_table epochs_local(_self, _self.value);
+  int64_t wax_in_epochs = 0;
+
+  for( auto epoch_itr = epochs_local.begin(); epoch_itr != epochs_local.end(); ++epoch_itr ){
+    check_or( epoch_itr->wax_to_refund.amount <= epoch_itr->wax_bucket.amount, [&]{ return violation( "epoch " + std::to_string(epoch_itr->start_time) + " owes more refunds than its wax bucket" ); } );
+
+    if( epoch_itr->total_cpu_funds_returned < epoch_itr->wax_bucket ){
+      wax_in_epochs = safeAddInt64( wax_in_epochs, safeSubInt64( epoch_itr->wax_bucket.amount, epoch_itr->total_cpu_funds_returned.amount ) );
+    }
+  }
+
+  //everything owed has to be covered by the wax this contract holds (minus what is being sent inline),
+  //plus what is staked in the cpu contracts and what pol.fusion holds, i.e. what sync_tvl calls tvl
+  //owed is every sWAX at 1 WAX plus the WAX that isn't staked yet. total_wax_owed can't be used here:
+  //the rental pool also gets the earning share at distribute, while user_funds_bucket still holds it,
+  //and wax_for_redemption is still counted as earning sWAX until redeem retires it
+  pol_contract::state_singleton_2 pol_state_local(POL_CONTRACT, POL_CONTRACT.value);
+  const pol_contract::state2 ps2 = pol_state_local.get_or_default(pol_contract::state2{ZERO_WAX, ZERO_WAX});
+
+  int64_t total_wax_owed = safeAddInt64( s.swax_currently_earning.amount, s.swax_currently_backing_lswax.amount );
+  total_wax_owed = safeAddInt64( total_wax_owed, s.revenue_awaiting_distribution.amount );
+  total_wax_owed = safeAddInt64( total_wax_owed, s.user_funds_bucket.amount );
+  total_wax_owed = safeAddInt64( total_wax_owed, s3.total_claimable_wax.amount );
+  total_wax_owed = safeAddInt64( total_wax_owed, st.pol_wax_pending.amount );
+  total_wax_owed = safeAddInt64( total_wax_owed, st.incentives_wax_pending->amount );
+
+  int64_t wax_covered = get_wax_balance(_self) - deltas.wax_sent;
+  wax_covered = safeAddInt64( wax_covered, wax_in_epochs );
+  wax_covered = safeAddInt64( wax_covered, get_wax_balance(POL_CONTRACT) );
+  wax_covered = safeAddInt64( wax_covered, ps2.wax_allocated_to_rentals.amount );
+  wax_covered = safeAddInt64( wax_covered, ps2.pending_refunds.amount );
+
+  check_or( total_wax_owed <= wax_covered, [&]{ return violation( "wax owed is " + std::to_string(total_wax_owed) + " but only " + std::to_string(wax_covered) + " is covered" ); } );
+}
+
+#endif
@@ -0,0 +1,55 @@
+#pragma once
+
+/**
+* invariant checks, only compiled when INVARIANTS is true
+* e.g. eosio-cpp -DINVARIANTS=true ...
+* meant for test deployments and local replays, not mainnet
+*
+* check_invariants runs when the contract is destroyed (after every action and notification)
+* and fails the transaction naming the action that broke an invariant
+*
+* issue/retire/transfer are inline actions that only run after this action, so the
+* token balances read at the end of an action don't include them yet. the amounts sent
+* inline during the action are tracked here and applied before comparing
+*
+* those inline transfers notify this contract again (from == _self) while the rest of the
+* sequence is still queued, with none of the deltas of the action that sent them.
+* nothing changes during those notifications, so they are skipped with INVARIANT_SKIP
+*/
+
+#ifndef INVARIANTS
+#define INVARIANTS false
+#endif
+
+#if INVARIANTS
+
+struct inline_deltas {
+  int64_t   lswax_supply = 0;
+  int64_t   swax_supply = 0;
+  int64_t   wax_sent = 0;
+  bool      skip = false;
+};
+
+inline inline_deltas& invariant_deltas(){
+  static inline_deltas deltas;
+  return deltas;
+}
+
+#define INVARIANT_DELTA(field, amount) invariant_deltas().field += (amount)
+#define INVARIANT_SKIP() invariant_deltas().skip = true
+
+struct [[eosio::table]] currency_stats {
+  eosio::asset    supply;
+  eosio::asset    max_supply;
+  eosio::name     issuer;
+
+  uint64_t primary_key()const { return supply.symbol.code().raw(); }
+};
+typedef eosio::multi_index< "stat"_n, currency_stats > stat_table;
+
+#else
+
+#define INVARIANT_DELTA(field, amount)
+#define INVARIANT_SKIP()
+
+#endif
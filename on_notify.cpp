@@ -1,15 +1,23 @@
 #pragma once
 
 void fusion::receive_token_transfer(name from, name to, eosio::asset quantity, std::string memo){
+	INSTRUMENT_ACTION("transfer"_n);
 	const name tkcontract = get_first_receiver();
 
     check( quantity.amount > 0, "Must send a positive quantity" );
     check( quantity.amount < MAX_ASSET_AMOUNT, "quantity too large" );
 
     if( from == get_self() || to != get_self() ){
+    	INVARIANT_SKIP();
     	return;
     }
 
+    //principal coming back from pol.fusion or a cpu contract was already part of the TVL
+    if( tkcontract == WAX_CONTRACT && quantity.symbol == WAX_SYMBOL ){
+    	const bool changes_tvl = from != POL_CONTRACT && memo != "cpu rental return";
+    	record_wax_received( quantity.amount, changes_tvl );
+    }
+
     //accept random tokens but dont execute any logic
     if( !memo_is_expected(memo) ) return;
 
@@ -18,7 +26,7 @@ void fusion::receive_token_transfer(name from, name to, eosio::asset quantity, s
 
   	if( memo == "wax_lswax_liquidity" ){
   		check( tkcontract == WAX_CONTRACT, "only WAX should be sent with this memo" );
-  		check( from == POL_CONTRACT, ( "expected " + POL_CONTRACT.to_string() + " to be the sender" ).c_str() );
+  		check_or( from == POL_CONTRACT, [&]{ return "expected " + POL_CONTRACT.to_string() + " to be the sender"; } );
 
   		issue_swax(quantity.amount);	
 
@@ -35,7 +43,7 @@ void fusion::receive_token_transfer(name from, name to, eosio::asset quantity, s
 		s.liquified_swax.amount = safeAddInt64(s.liquified_swax.amount, converted_lsWAX_i64);	  
 		s.wax_available_for_rentals.amount = safeAddInt64(s.wax_available_for_rentals.amount, quantity.amount);    
 
-	    states.set(s, _self);
+	    save_state(s);
   		return;	    	
   	} 
 
@@ -77,7 +85,7 @@ void fusion::receive_token_transfer(name from, name to, eosio::asset quantity, s
 	    s.swax_currently_earning.amount = safeAddInt64(s.swax_currently_earning.amount, quantity.amount);
 	    s.wax_available_for_rentals.amount = safeAddInt64(s.wax_available_for_rentals.amount, quantity.amount);
 
-	    states.set(s, _self);
+	    save_state(s);
 
   		return;
   	}
@@ -90,6 +98,7 @@ void fusion::receive_token_transfer(name from, name to, eosio::asset quantity, s
   	if( memo == "unliquify" ){
   		//front end has to package in a "stake" action before transferring, to make sure they have a row
   		sync_epoch();
+  		sync_rewards();
 
   		check( tkcontract == TOKEN_CONTRACT, "only LSWAX can be unliquified" );
 
@@ -111,7 +120,7 @@ void fusion::receive_token_transfer(name from, name to, eosio::asset quantity, s
   		//add this amount to the "currently_earning" sWAX bucket
   		s.swax_currently_earning.amount = safeAddInt64(s.swax_currently_earning.amount, converted_sWAX_i64);
 	    
-	    states.set(s, _self);   
+	    save_state(s);   
 
 	    //sync this user before adjusting their row
   		sync_user(from);
@@ -140,7 +149,7 @@ void fusion::receive_token_transfer(name from, name to, eosio::asset quantity, s
   		//add the wax to state.revenue_awaiting_distribution
   		state s = states.get();
   		s.revenue_awaiting_distribution.amount = safeAddInt64(s.revenue_awaiting_distribution.amount, quantity.amount);
-  		states.set(s, _self); 
+  		save_state(s); 
   		return;
   	}
 
@@ -153,21 +162,12 @@ void fusion::receive_token_transfer(name from, name to, eosio::asset quantity, s
   		sync_epoch();
 
   		state s = states.get();
-  		state2 s2 = state_s_2.get();
-
-  		issue_swax(quantity.amount);
   		s.wax_available_for_rentals.amount = safeAddInt64( s.wax_available_for_rentals.amount, quantity.amount );
 
-		int64_t converted_lsWAX_i64 = internal_liquify( quantity.amount, s );		
-		issue_lswax(converted_lsWAX_i64, _self);
-
-  		s2.incentives_bucket.amount = safeAddInt64( s2.incentives_bucket.amount, converted_lsWAX_i64 );
-
-  		s.swax_currently_backing_lswax.amount = safeAddInt64( s.swax_currently_backing_lswax.amount, quantity.amount );
-  		s.liquified_swax.amount = safeAddInt64(s.liquified_swax.amount, converted_lsWAX_i64);
+  		//liquified into incentives_bucket during the next settlement
+		credit_settlements( 0, quantity.amount );
 
-  		states.set(s, _self);
-  		state_s_2.set(s2, _self);
+  		save_state(s);
 
   		return;
   	}
@@ -241,7 +241,7 @@ void fusion::receive_token_transfer(name from, name to, eosio::asset quantity, s
   			_e.total_added_to_redemption_bucket = total_added_to_redemption_bucket;
   		});
 
-  		states.set(s, _self);
+  		save_state(s);
   		return;
   	}
 
@@ -250,7 +250,7 @@ void fusion::receive_token_transfer(name from, name to, eosio::asset quantity, s
   	* anything below here should be a dynamic memo with multiple words to parse
   	*/
 
-  	std::vector<std::string> words = get_words(memo);
+  	const memo_words words = get_words(memo);
 
   	/**
   	* rent_cpu
@@ -259,22 +259,22 @@ void fusion::receive_token_transfer(name from, name to, eosio::asset quantity, s
 
   	if( words[1] == "rent_cpu" ){
   		check( tkcontract == WAX_CONTRACT, "only WAX can be sent with this memo" );
-  		check( words.size() >= 5, "memo for unliquify_exact operation is incomplete" );
+  		check( words.size() >= 5, "memo for rent_cpu operation is incomplete" );
   		sync_epoch();
 
   		//memo should also include account to rent to 
   		const eosio::name cpu_receiver = eosio::name( words[2] );
-  		check( is_account( cpu_receiver ), ( cpu_receiver.to_string() + " is not an account" ).c_str() );
+  		check_or( is_account( cpu_receiver ), [&]{ return cpu_receiver.to_string() + " is not an account"; } );
 
   		//memo should also include amount of wax to rent
-  		const uint64_t wax_amount_to_rent = std::strtoull( words[3].c_str(), NULL, 0 );
+  		const uint64_t wax_amount_to_rent = memo_to_uint64( words[3], "wax amount to rent" );
 
   		//that amount should be > min_rental
-  		check( wax_amount_to_rent >= MINIMUM_WAX_TO_RENT, ( "minimum wax amount to rent is " + std::to_string( MINIMUM_WAX_TO_RENT ) ).c_str() );
-  		check( wax_amount_to_rent <= MAXIMUM_WAX_TO_RENT, ( "maximum wax amount to rent is " + std::to_string( MAXIMUM_WAX_TO_RENT ) ).c_str() );
+  		check_or( wax_amount_to_rent >= MINIMUM_WAX_TO_RENT, [&]{ return "minimum wax amount to rent is " + std::to_string( MINIMUM_WAX_TO_RENT ); } );
+  		check_or( wax_amount_to_rent <= MAXIMUM_WAX_TO_RENT, [&]{ return "maximum wax amount to rent is " + std::to_string( MAXIMUM_WAX_TO_RENT ); } );
 
   		//memo should include an epoch ID
-  		const uint64_t epoch_id_to_rent_from = std::strtoull( words[4].c_str(), NULL, 0 );
+  		const uint64_t epoch_id_to_rent_from = memo_to_uint64( words[4], "epoch id" );
 
   		state s = states.get();
   		config3 c = config_s_3.get();
@@ -289,10 +289,12 @@ void fusion::receive_token_transfer(name from, name to, eosio::asset quantity, s
 
   		uint64_t seconds_to_rent = get_seconds_to_rent_cpu(s, c, epoch_id_to_rent_from);
 
-  		//TODO use 128 safemath
-  		int64_t expected_amount_received = s.cost_to_rent_1_wax.amount * wax_amount_to_rent * seconds_to_rent / days_to_seconds(1);
+  		//cost_to_rent_1_wax is per day, any fraction of a unit is rounded up in favour of the protocol
+  		const int64_t expected_amount_received = safe_math::to_int64(
+  			safe_math::muldiv( safe_math::mul( s.cost_to_rent_1_wax.amount, wax_amount_to_rent ), seconds_to_rent, days_to_seconds(1), safe_math::rounding::up )
+  		);
 
-  		check( quantity.amount >= expected_amount_received, ("expected to receive " + std::to_string(expected_amount_received) + " WAX" ).c_str() );
+  		check_or( quantity.amount >= expected_amount_received, [&]{ return "expected to receive " + std::to_string(expected_amount_received) + " WAX"; } );
   		s.revenue_awaiting_distribution.amount = safeAddInt64( s.revenue_awaiting_distribution.amount, expected_amount_received );
 
   		//if they sent more than expected, calculate difference and refund it
@@ -305,7 +307,7 @@ void fusion::receive_token_transfer(name from, name to, eosio::asset quantity, s
   			}
   		}
 
-  		auto epoch_itr = epochs_t.require_find( epoch_id_to_rent_from, ("epoch " + std::to_string(epoch_id_to_rent_from) + " does not exist").c_str() );
+  		auto epoch_itr = require_find_or( epochs_t, epoch_id_to_rent_from, [&]{ return "epoch " + std::to_string(epoch_id_to_rent_from) + " does not exist"; } );
 
   		//send funds to the cpu contract
   		transfer_tokens( epoch_itr->cpu_wallet, asset( (int64_t) amount_to_rent_with_precision, WAX_SYMBOL), WAX_CONTRACT, cpu_stake_memo(cpu_receiver, epoch_id_to_rent_from) );
@@ -339,7 +341,7 @@ void fusion::receive_token_transfer(name from, name to, eosio::asset quantity, s
         }
 
   		//update the state
-  		states.set(s, _self);
+  		save_state(s);
   		return;
   	}
 
@@ -348,12 +350,13 @@ void fusion::receive_token_transfer(name from, name to, eosio::asset quantity, s
   		check( words.size() >= 4, "memo for unliquify_exact operation is incomplete" );
   		check( tkcontract == TOKEN_CONTRACT, "only LSWAX can be unliquified" );
   		sync_epoch();
+  		sync_rewards();
 
   		config3 c = config_s_3.get();
   		check( quantity >= c.minimum_unliquify_amount, "minimum unliquify amount not met" );
 
-  		const uint64_t expected_output = std::strtoull( words[2].c_str(), NULL, 0 );
-  		const uint64_t max_slippage = std::strtoull( words[3].c_str(), NULL, 0 );
+  		const uint64_t expected_output = memo_to_uint64( words[2], "expected output" );
+  		const uint64_t max_slippage = memo_to_uint64( words[3], "max slippage" );
 
   		//calculate the conversion rate (amount of sWAX to stake to this user)
   		state s = states.get();
@@ -365,7 +368,7 @@ void fusion::receive_token_transfer(name from, name to, eosio::asset quantity, s
 		uint64_t minimum_output_percentage = ONE_HUNDRED_PERCENT_1E6 - max_slippage;
 		int64_t minimum_output = calculate_asset_share( expected_output, minimum_output_percentage );
 
-		check( converted_sWAX_i64 >= minimum_output, "output would be " + asset(converted_sWAX_i64, SWAX_SYMBOL).to_string() + " but expected " + asset(minimum_output, SWAX_SYMBOL).to_string() );	  		
+		check_or( converted_sWAX_i64 >= minimum_output, [&]{ return "output would be " + asset(converted_sWAX_i64, SWAX_SYMBOL).to_string() + " but expected " + asset(minimum_output, SWAX_SYMBOL).to_string(); } );	  		
 
   		retire_lswax(quantity.amount);
 
@@ -376,7 +379,7 @@ void fusion::receive_token_transfer(name from, name to, eosio::asset quantity, s
   		//add this amount to the "currently_earning" sWAX bucket
   		s.swax_currently_earning.amount = safeAddInt64(s.swax_currently_earning.amount, converted_sWAX_i64);
 	    
-	    states.set(s, _self);   
+	    save_state(s);   
 
 	    //sync this user before adjusting their row
   		sync_user(from);
@@ -394,4 +397,88 @@ void fusion::receive_token_transfer(name from, name to, eosio::asset quantity, s
   		return;
   	}  	
 
+  	/** stake_liquify
+  	 *  mints lsWAX straight from WAX in a single step, i.e. stake + liquify
+  	 *  the sWAX never gets credited to a staker, so the sender doesn't need a row here
+  	 *  memo format is |stake_liquify|minimum_lswax_output|
+  	 */
+
+  	if( words[1] == "stake_liquify" ){
+
+  		check( words.size() >= 3, "memo for stake_liquify operation is incomplete" );
+  		check( tkcontract == WAX_CONTRACT, "only WAX is used for staking" );
+  		sync_epoch();
+
+  		config3 c = config_s_3.get();
+  		check( quantity >= c.minimum_stake_amount, "minimum stake amount not met" );
+
+  		const uint64_t minimum_output = memo_to_uint64( words[2], "minimum output" );
+  		check( minimum_output <= MAX_ASSET_AMOUNT_U64, "minimum output is out of range" );
+
+  		issue_swax(quantity.amount);
+
+  		//calculate equivalent amount of lsWAX (BEFORE adjusting sWAX amounts)
+	    state s = states.get();
+		int64_t converted_lsWAX_i64 = internal_liquify(quantity.amount, s);
+
+		check_or( converted_lsWAX_i64 >= (int64_t) minimum_output, [&]{ return "output would be " + asset(converted_lsWAX_i64, LSWAX_SYMBOL).to_string() + " but expected " + asset(minimum_output, LSWAX_SYMBOL).to_string(); } );
+
+		issue_lswax(converted_lsWAX_i64, from);
+
+		s.swax_currently_backing_lswax.amount = safeAddInt64(s.swax_currently_backing_lswax.amount, quantity.amount);
+		s.liquified_swax.amount = safeAddInt64(s.liquified_swax.amount, converted_lsWAX_i64);
+		s.wax_available_for_rentals.amount = safeAddInt64(s.wax_available_for_rentals.amount, quantity.amount);
+
+	    save_state(s);
+  		return;
+  	}
+
+  	/** instant_redeem
+  	 *  unliquify + instaredeem in a single step, i.e. lsWAX -> WAX
+  	 *  paid out of wax_available_for_rentals with the same 0.05% fee as instaredeem
+  	 *  the sWAX never gets credited to a staker, so the stakers and requests tables aren't touched
+  	 *  memo format is |instant_redeem|minimum_wax_output|
+  	 */
+
+  	if( words[1] == "instant_redeem" ){
+
+  		check( words.size() >= 3, "memo for instant_redeem operation is incomplete" );
+  		check( tkcontract == TOKEN_CONTRACT, "only LSWAX can be redeemed with this memo" );
+  		sync_epoch();
+
+  		config3 c = config_s_3.get();
+  		check( quantity >= c.minimum_unliquify_amount, "minimum unliquify amount not met" );
+
+  		const uint64_t minimum_output = memo_to_uint64( words[2], "minimum output" );
+  		check( minimum_output <= MAX_ASSET_AMOUNT_U64, "minimum output is out of range" );
+
+  		//calculate the conversion rate (amount of sWAX being redeemed)
+  		state s = states.get();
+  		int64_t converted_sWAX_i64 = internal_unliquify(quantity.amount, s);
+
+  		check( s.wax_available_for_rentals.amount >= converted_sWAX_i64, "not enough instaredeem funds available" );
+
+  		int64_t protocol_share = calculate_asset_share( converted_sWAX_i64, INSTAREDEEM_FEE_1E6 );
+  		int64_t user_share = calculate_asset_share( converted_sWAX_i64, ONE_HUNDRED_PERCENT_1E6 - INSTAREDEEM_FEE_1E6 );
+
+  		check( safeAddInt64( protocol_share, user_share ) <= converted_sWAX_i64, "error calculating protocol fee" );
+  		check_or( user_share >= (int64_t) minimum_output, [&]{ return "output would be " + asset(user_share, WAX_SYMBOL).to_string() + " but expected " + asset(minimum_output, WAX_SYMBOL).to_string(); } );
+
+  		retire_lswax(quantity.amount);
+  		retire_swax(converted_sWAX_i64);
+
+  		//debit the amount from liquified sWAX
+  		s.liquified_swax.amount = safeSubInt64(s.liquified_swax.amount, quantity.amount);
+  		s.swax_currently_backing_lswax.amount = safeSubInt64(s.swax_currently_backing_lswax.amount, converted_sWAX_i64);
+
+  		//debit the rental pool and add the 0.05% to the revenue_awaiting_distribution
+  		s.wax_available_for_rentals.amount = safeSubInt64(s.wax_available_for_rentals.amount, converted_sWAX_i64);
+  		s.revenue_awaiting_distribution.amount = safeAddInt64(s.revenue_awaiting_distribution.amount, protocol_share);
+
+  		save_state(s);
+
+  		transfer_tokens( from, asset( user_share, WAX_SYMBOL ), WAX_CONTRACT, std::string("your lsWAX redemption from waxfusion.io - liquid staking protocol") );
+  		return;
+  	}
+
 }
\ No newline at end of file
@@ -15,20 +15,8 @@ int64_t fusion::safeAddInt64(const int64_t& a, const int64_t& b){
 }
 
 uint128_t fusion::safeMulUInt128(const uint128_t& a, const uint128_t& b){
-
-    if( a == 0 || b == 0 ) return 0;
-
-    if( a > (uint128_t) MAX_ASSET_AMOUNT_U64 || b > (uint128_t) MAX_ASSET_AMOUNT_U64 ){
-    	check( false, "uint128_t multiplication input is outside of range" );
-    }
-
-    check( a <= MAX_U128_VALUE / b, "uint128_t multiplication would result in overflow" );
-
-    uint128_t result = a * b;
-
-    check( result <= MAX_U128_VALUE, "uint128_t multiplication result is outside of the acceptable range" );
-
-    return result;
+	//inputs are capped at MAX_ASSET_AMOUNT so the product can't overflow, see safe_math.hpp
+	return safe_math::mul( a, b );
 }
 
 uint64_t fusion::safeMulUInt64(const uint64_t& a, const uint64_t& b){
@@ -0,0 +1,98 @@
+#pragma once
+
+/**
+* safe_math
+* header only, constexpr capable checked arithmetic
+* fused multiply then divide, so call sites don't need safeMulUInt128( a, b ) / c
+* and the divisor can be checked (or folded at compile time) in one place
+*/
+
+namespace safe_math {
+
+  enum class rounding : uint8_t {
+    down,
+    up
+  };
+
+  //MAX_ASSET_AMOUNT_U64 is 2^62 - 1, so both inputs are in range when their bitwise OR is
+  static_assert( ( MAX_ASSET_AMOUNT_U64 & ( MAX_ASSET_AMOUNT_U64 + 1 ) ) == 0, "MAX_ASSET_AMOUNT_U64 must be a low bit mask" );
+
+  /**
+  * mul
+  * both inputs must be <= MAX_ASSET_AMOUNT, which means the product is < 2^124
+  * and can never overflow a uint128_t, so no further checks are needed
+  */
+
+  constexpr uint128_t mul(const uint128_t& a, const uint128_t& b){
+    if( a == 0 || b == 0 ) return 0;
+
+    if( ( a | b ) > (uint128_t) MAX_ASSET_AMOUNT_U64 ){
+      eosio::check( false, "uint128_t multiplication input is outside of range" );
+    }
+    return a * b;
+  }
+
+  /**
+  * to_int64 / to_uint64
+  * checked narrowing of uint128_t results, out of range values fail instead of being truncated
+  * to_int64 is for asset amounts, so its limit is MAX_ASSET_AMOUNT
+  */
+
+  constexpr int64_t to_int64(const uint128_t& value){
+    if( value > (uint128_t) MAX_ASSET_AMOUNT_U64 ){
+      eosio::check( false, "result is outside of the acceptable range" );
+    }
+    return (int64_t) value;
+  }
+
+  constexpr uint64_t to_uint64(const uint128_t& value){
+    if( value > (uint128_t) UINT64_MAX ){
+      eosio::check( false, "result does not fit in uint64_t" );
+    }
+    return (uint64_t) value;
+  }
+
+  constexpr uint128_t div(const uint128_t& numerator, const uint128_t& divisor, const rounding& mode){
+    const uint128_t quotient = numerator / divisor;
+    if( mode == rounding::up ) return quotient + ( numerator % divisor != 0 ? 1 : 0 );
+    return quotient;
+  }
+
+  /**
+  * muldiv
+  * ( a * b ) / c with the same input range as safeMulUInt128
+  * rounding defaults to down, which is what the integer division it replaces did
+  */
+
+  constexpr uint128_t muldiv(const uint128_t& a, const uint128_t& b, const uint128_t& c, const rounding& mode = rounding::down){
+    if( c == 0 ){
+      eosio::check( false, "muldiv divisor can not be 0" );
+    }
+    return div( mul( a, b ), c, mode );
+  }
+
+  /**
+  * muldiv_by
+  * same as muldiv, for divisors that are known at compile time (scale factors, 100%)
+  * the zero check happens at compile time and the divisor is a constant in the wasm
+  */
+
+  template<uint64_t DIVISOR>
+  constexpr uint128_t muldiv_by(const uint128_t& a, const uint128_t& b, const rounding& mode = rounding::down){
+    static_assert( DIVISOR != 0, "muldiv divisor can not be 0" );
+    return div( mul( a, b ), (uint128_t) DIVISOR, mode );
+  }
+
+}
+
+//compile time edge cases, these cost nothing in the wasm
+static_assert( safe_math::muldiv( 7, 1, 2 ) == 3 );
+static_assert( safe_math::muldiv( 7, 1, 2, safe_math::rounding::up ) == 4 );
+static_assert( safe_math::muldiv( 8, 1, 2, safe_math::rounding::up ) == 4 );
+static_assert( safe_math::muldiv( 0, MAX_ASSET_AMOUNT_U64, 3 ) == 0 );
+static_assert( safe_math::mul( 0, MAX_U128_VALUE ) == 0 );
+static_assert( safe_math::muldiv( MAX_ASSET_AMOUNT_U64, MAX_ASSET_AMOUNT_U64, MAX_ASSET_AMOUNT_U64 ) == MAX_ASSET_AMOUNT_U64 );
+static_assert( safe_math::muldiv_by<ONE_HUNDRED_PERCENT_1E6>( 100000000, 10000 ) == 10000 );
+static_assert( safe_math::muldiv_by<ONE_HUNDRED_PERCENT_1E6>( 1, 1, safe_math::rounding::up ) == 1 );
+static_assert( safe_math::to_int64( MAX_ASSET_AMOUNT_U64 ) == MAX_ASSET_AMOUNT );
+static_assert( safe_math::to_uint64( UINT64_MAX ) == UINT64_MAX );
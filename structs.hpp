@@ -1,6 +1,145 @@
 #pragma once
 
+/** 
+* words of a |delimited|memo|, viewing into the memo so nothing is copied
+* indexing past the last word returns an empty view instead of reading out of bounds
+*/
+
+struct memo_words {
+	static constexpr size_t MAX_WORDS = 8; /* longest memo (rent_cpu) uses 5 */
+
+	std::array<std::string_view, MAX_WORDS> 	words{};
+	size_t 										count = 0;
+
+	size_t size() const { return count; }
+	std::string_view operator[](const size_t& index) const { return index < count ? words[index] : std::string_view{}; }
+};
+
 struct revenue_receiver {
 	eosio::name  	beneficiary;
 	double 			amount; //e.g. 0.1 = 10%
+};
+
+/** 
+* returned by read only actions
+*/
+
+struct epoch_capacity {
+	uint64_t 		epoch_id;
+	uint64_t 		redemption_period_start_time;
+	uint64_t 		redemption_period_end_time;
+	eosio::asset 	wax_bucket;
+	eosio::asset 	wax_to_refund;
+	eosio::asset 	available_for_redemption; /* 0 once the redemption period has started */
+};
+
+struct apr_quote {
+	uint64_t 		from_time;
+	uint64_t 		to_time;
+	uint64_t 		from_swax_per_lswax_1e12;
+	uint64_t 		to_swax_per_lswax_1e12;
+	uint64_t 		apr_1e6; /* simple annualized, 100% = 100,000,000 */
+};
+
+struct conversion_quote {
+	eosio::asset 	input;
+	eosio::asset 	output;
+	eosio::asset 	fee;
+};
+
+/** 
+* bump DASHBOARD_VERSION whenever fields are added, new fields go at the end
+*/
+
+struct dashboard {
+	uint8_t 		version;
+	uint64_t 		timestamp;
+
+	//sWAX and lsWAX
+	eosio::asset 	swax_currently_earning;
+	eosio::asset 	swax_currently_backing_lswax;
+	eosio::asset 	liquified_swax;
+	eosio::asset 	one_lswax_to_swax;
+
+	//revenue and rewards
+	eosio::asset 	revenue_awaiting_distribution;
+	eosio::asset 	user_funds_bucket;
+	eosio::asset 	total_revenue_distributed;
+	eosio::asset 	rewards_remaining;
+	uint64_t 		rewards_period_finish;
+	uint64_t 		next_distribution;
+	uint64_t 		last_distribution_time;
+	eosio::asset 	last_distribution_amount;
+	eosio::asset 	incentives_bucket;
+
+	//liabilities
+	eosio::asset 	total_value_locked;
+	eosio::asset 	total_claimable_wax;
+	eosio::asset 	total_wax_owed;
+	eosio::asset 	contract_wax_balance;
+
+	//cpu rentals
+	eosio::asset 	wax_available_for_rentals;
+	eosio::asset 	wax_in_live_epochs;
+	uint64_t 		rental_utilization_1e6;
+	eosio::asset 	cost_to_rent_1_wax;
+	eosio::name 	current_cpu_contract;
+	uint64_t 		next_stakeall_time;
+
+	//redemptions
+	eosio::asset 	wax_for_redemption;
+	uint64_t 		redemption_period_start;
+	uint64_t 		redemption_period_end;
+	std::vector<epoch_capacity> live_epochs;
+
+	//config
+	eosio::asset 	minimum_stake_amount;
+	eosio::asset 	minimum_unliquify_amount;
+	uint64_t 		user_share_1e6;
+	uint64_t 		pol_share_1e6;
+	uint64_t 		ecosystem_share_1e6;
+	std::vector<eosio::name> top21_producers;
+
+	//settlements (version 2), the token.fusion supplies only include these after next_settlement
+	eosio::asset 	pol_wax_pending;
+	eosio::asset 	lswax_pending_issue;
+	eosio::asset 	incentives_wax_pending;
+	eosio::asset 	route_lswax_pending;
+	eosio::asset 	swax_pending_issue;
+	eosio::asset 	swax_pending_retire;
+	uint64_t 		next_settlement;
+};
+
+struct exchange_rates {
+	eosio::asset 	swax_currently_backing_lswax;
+	eosio::asset 	liquified_swax;
+	eosio::asset 	one_swax_to_lswax; /* output of liquifying 1 sWAX */
+	eosio::asset 	one_lswax_to_swax; /* output of unliquifying 1 LSWAX */
+};
+
+struct pending_redemption {
+	uint64_t 		epoch_id;
+	eosio::asset 	wax_amount_requested;
+};
+
+struct redeem_quote {
+	eosio::asset 	swax_to_redeem;
+	eosio::asset 	paid_from_current_window; /* existing request in the open redemption window, paid immediately */
+	std::vector<pending_redemption> epoch_requests; /* replaces any existing requests in these epochs */
+	eosio::asset 	paid_from_rental_pool; /* paid immediately */
+};
+
+struct staker_position {
+	eosio::name 	wallet;
+	eosio::asset 	swax_balance; /* after pending rewards are routed */
+	eosio::asset 	claimable_wax; /* after pending rewards are routed */
+	eosio::asset 	pending_rewards; /* WAX earned since last sync */
+	uint8_t 		reward_route;
+	std::vector<pending_redemption> redemption_requests;
+	eosio::asset 	lswax_awaiting_payout; /* converted by the lsWAX route, issued by payroutes */
+};
+
+struct snapshot_tier {
+	uint64_t 		resolution_seconds;
+	uint64_t 		capacity;
 };
\ No newline at end of file
@@ -69,6 +69,27 @@ struct [[eosio::table]] account {
 typedef eosio::multi_index< "accounts"_n, account > accounts;
 
 
+/**
+* audit singleton records how far the running totals in state2/state3 had drifted
+* from the full recalculation the last time sync_tvl ran
+* drift = running total - recalculated total
+*/
+
+struct [[eosio::table, eosio::contract(CONTRACT_NAME)]] audit {
+  int64_t           tvl_drift;
+  int64_t           wax_owed_drift;
+  int64_t           wax_balance_drift;
+  uint64_t          last_audit;
+
+  EOSLIB_SERIALIZE(audit, (tvl_drift)
+                          (wax_owed_drift)
+                          (wax_balance_drift)
+                          (last_audit)
+                          )
+};
+using audit_singleton = eosio::singleton<"audit"_n, audit>;
+
+
 struct [[eosio::table, eosio::contract(CONTRACT_NAME)]] config3 {
   eosio::asset                      minimum_stake_amount;
   eosio::asset                      minimum_unliquify_amount;
@@ -237,11 +258,44 @@ typedef eosio::multi_index< "producers"_n, producer_info,
                          > producers_table;
 
 
+/**
+* ratering holds the lsWAX exchange rate after each distribution, in fixed size rings
+* scoped by resolution_seconds from RATE_HISTORY_TIERS, slot is ( timestamp / resolution_seconds ) % capacity
+* lsWAX started at 1:1, so swax_per_lswax_1e12 is also the cumulative growth since launch
+*/
+
+struct [[eosio::table, eosio::contract(CONTRACT_NAME)]] ratering {
+  uint64_t          slot;
+  uint64_t          timestamp;
+  uint64_t          swax_per_lswax_1e12;
+  eosio::asset      total_revenue_distributed;
+
+  uint64_t primary_key() const { return slot; }
+};
+using rate_ring_table = eosio::multi_index<"ratering"_n, ratering
+>;
+
 /** 
 * redeem_requests table stores requests for redemptions
 * scoped by user
 */
 
+/**
+* routepayouts holds lsWAX that sync_user converted for stakers on the convert route
+* it is already counted in state.liquified_swax, payroutes issues each row in one inline action
+* so syncing doesn't send an issue every time
+*/
+
+struct [[eosio::table, eosio::contract(CONTRACT_NAME)]] routepayouts {
+  eosio::name     wallet;
+  eosio::asset    lswax_owed;
+
+  uint64_t primary_key() const { return wallet.value; }
+};
+using route_payouts_table = eosio::multi_index<"routepayouts"_n, routepayouts
+>;
+
+
 struct [[eosio::table, eosio::contract(CONTRACT_NAME)]] redeem_requests {
   uint64_t        epoch_id;
   eosio::asset    wax_amount_requested;
@@ -287,6 +341,83 @@ eosio::indexed_by<"renter"_n, eosio::const_mem_fun<renters, uint64_t, &renters::
 eosio::indexed_by<"fromtocombo"_n, eosio::const_mem_fun<renters, uint128_t, &renters::by_from_to_combo>>
 >;
 
+/**
+* prunestate tracks the oldest last_update of any staker holding sWAX
+* scanstakers walks the stakers table in batches, and the minimum only becomes the
+* watermark once a pass has covered every row
+* snapshots at or before the watermark aren't needed by anyone and can be pruned
+* sweepstakers settles dormant stakers so the watermark doesn't get stuck behind them
+*/
+
+struct [[eosio::table, eosio::contract(CONTRACT_NAME)]] prunestate {
+  uint64_t          next_staker; /* primary key to resume the current pass from */
+  uint64_t          pass_min_last_update;
+  uint64_t          watermark;
+  uint64_t          last_pass_completed;
+  uint64_t          next_sweep; /* primary key for sweepstakers to resume from */
+
+  EOSLIB_SERIALIZE(prunestate, (next_staker)
+                            (pass_min_last_update)
+                            (watermark)
+                            (last_pass_completed)
+                            (next_sweep)
+                            )
+};
+using prunestate_singleton = eosio::singleton<"prunestate"_n, prunestate>;
+
+/**
+* rewards singleton keeps track of the sWAX earning rewards that are being streamed
+* each distribution starts a new period, and rewards_remaining is released linearly until period_finish
+* reward_per_swax_1e12 is the cumulative amount of WAX earned by 1 sWAX since streaming started
+*/
+
+struct [[eosio::table, eosio::contract(CONTRACT_NAME)]] rewards {
+  uint64_t          streaming_start_time; /* snapshots before this are still paid from the snapshots table */
+  uint64_t          last_update_time;
+  uint64_t          period_finish;
+  eosio::asset      rewards_remaining;
+  uint128_t         reward_per_swax_1e12;
+
+  EOSLIB_SERIALIZE(rewards, (streaming_start_time)
+                            (last_update_time)
+                            (period_finish)
+                            (rewards_remaining)
+                            (reward_per_swax_1e12)
+                            )
+};
+using rewards_singleton = eosio::singleton<"rewards"_n, rewards>;
+
+/**
+* settlements singleton is a ledger of allocations that are owed but haven't been sent yet
+* instead of transferring/issuing on every distribution, these are settled once per settlement interval
+* sWAX is never transferred, so its supply is tracked here and the net issue/retire is reconciled
+* with token.fusion during each settlement
+* the sWAX fields were added after the singleton was deployed, read it with get_settlements()
+* route_lswax_pending is the sum of routepayouts, it is issued to stakers by payroutes rather than by settle
+*/
+
+struct [[eosio::table, eosio::contract(CONTRACT_NAME)]] settlements {
+  eosio::asset      pol_wax_pending;
+  eosio::asset      lswax_pending_issue; /* lsWAX that is already counted in state2.incentives_bucket */
+  uint64_t          seconds_between_settlements;
+  uint64_t          next_settlement;
+  eosio::binary_extension<eosio::asset> swax_pending_issue;
+  eosio::binary_extension<eosio::asset> swax_pending_retire;
+  eosio::binary_extension<eosio::asset> incentives_wax_pending; /* liquified into state2.incentives_bucket at the settle rate */
+  eosio::binary_extension<eosio::asset> route_lswax_pending;
+
+  EOSLIB_SERIALIZE(settlements, (pol_wax_pending)
+                                (lswax_pending_issue)
+                                (seconds_between_settlements)
+                                (next_settlement)
+                                (swax_pending_issue)
+                                (swax_pending_retire)
+                                (incentives_wax_pending)
+                                (route_lswax_pending)
+                                )
+};
+using settlements_singleton = eosio::singleton<"settlements"_n, settlements>;
+
 
 struct [[eosio::table, eosio::contract(CONTRACT_NAME)]] snapshots {
   uint64_t          timestamp;
@@ -308,12 +439,36 @@ struct [[eosio::table, eosio::contract(CONTRACT_NAME)]] snapshots {
 using snaps_table = eosio::multi_index<"snapshots"_n, snapshots
 >;
 
+/**
+* snappages holds distribution snapshots, SNAPSHOT_PAGE_SIZE per row
+* period = timestamp / seconds_between_distributions, page = period / SNAPSHOT_PAGE_SIZE
+* each vector is indexed by period % SNAPSHOT_PAGE_SIZE, periods without a distribution are 0
+* snapshots rows are moved here with the migratesnaps action
+*/
+
+struct [[eosio::table, eosio::contract(CONTRACT_NAME)]] snappages {
+  uint64_t              page;
+  uint64_t              phase_seconds; /* timestamp % seconds_between_distributions */
+  std::vector<int64_t>  swax_earning_bucket;
+  std::vector<int64_t>  lswax_autocompounding_bucket;
+  std::vector<int64_t>  pol_bucket;
+  std::vector<int64_t>  ecosystem_bucket;
+  std::vector<int64_t>  total_distributed;
+  std::vector<int64_t>  total_swax_earning;
+
+  uint64_t primary_key() const { return page; }
+};
+using snap_pages_table = eosio::multi_index<"snappages"_n, snappages
+>;
+
 
 struct [[eosio::table, eosio::contract(CONTRACT_NAME)]] stakers {
   eosio::name       wallet;
   eosio::asset      swax_balance;
   eosio::asset      claimable_wax;
   uint64_t          last_update;
+  eosio::binary_extension<uint128_t> reward_per_swax_paid_1e12;
+  eosio::binary_extension<uint8_t>   reward_route;
   
   uint64_t primary_key() const { return wallet.value; }
 };
@@ -384,6 +539,43 @@ struct [[eosio::table, eosio::contract(CONTRACT_NAME)]] state3 {
 };
 using state_singleton_3 = eosio::singleton<"state3"_n, state3>;
 
+/**
+* snaptiers singleton configures the statering tables
+* if it doesn't exist, DEFAULT_SNAPSHOT_TIERS are used
+*/
+
+struct [[eosio::table, eosio::contract(CONTRACT_NAME)]] snaptiers {
+  std::vector<snapshot_tier>  tiers;
+
+  EOSLIB_SERIALIZE(snaptiers, (tiers))
+};
+using snaptiers_singleton = eosio::singleton<"snaptiers"_n, snaptiers>;
+
+
+/**
+* statering holds state snapshots in fixed size rings, one ring per snapshot_tier
+* scoped by resolution_seconds, slot is ( timestamp / resolution_seconds ) % capacity
+* rows are overwritten in place, so RAM stays flat no matter how long the contract runs
+*/
+
+struct [[eosio::table, eosio::contract(CONTRACT_NAME)]] statering {
+  uint64_t          slot;
+  uint64_t          timestamp;
+  eosio::asset      total_wax_owed;
+  eosio::asset      contract_wax_balance;
+  eosio::asset      total_value_locked;
+  
+  uint64_t primary_key() const { return slot; }
+};
+using state_ring_table = eosio::multi_index<"statering"_n, statering
+>;
+
+
+/**
+* statesnaps is no longer written to, it was replaced by statering
+* remaining rows can be removed with the clearsnaps action
+*/
+
 struct [[eosio::table, eosio::contract(CONTRACT_NAME)]] statesnaps {
   uint64_t          timestamp;
   eosio::asset      total_wax_owed;
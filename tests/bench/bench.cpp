@@ -0,0 +1,772 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "json.hpp"
+#include "meter.hpp"
+
+/**
+* bench measures every dapp.fusion action and transfer memo in a scripted scenario, e.g.
+*   ./build/tests/bench/bench --repetitions 25 --output after.json
+*   ./build/tests/bench/bench --compare before.json after.json
+*
+* - each scenario gets a fresh fusion_tester, sets up the state it needs without measuring it,
+*   then measures one transaction with meter::push
+* - wall time is the median (and minimum) over --repetitions runs, everything else is deterministic
+*   and comes from the first run: heap allocations, packed action bytes, inline actions, rows written,
+*   RAM per dapp.fusion table and the INSTRUMENT counts
+* - the report is written as json with --output, --compare prints the change per scenario between two reports
+* - --filter and --exclude pick scenarios by a substring of their label
+* - a scenario that fails is reported with its error and makes bench exit with 1, so the scenarios
+*   can't silently stop exercising the path they are named after (createfarms is the exception,
+*   it fails on chain as well and is measured up to its failure)
+*
+* the init* actions (other than initrewards and inittop21) only run at deployment and are left out,
+* read only actions don't write anything and are left out too
+*/
+
+namespace {
+
+  constexpr uint32_t DAY = 60 * 60 * 24;
+  constexpr eosio::name KEEPER = "keeper"_n;
+  constexpr eosio::name ALICE = "alice"_n;
+  constexpr eosio::name BOB = "bob"_n;
+  constexpr uint64_t POOL_ID = 1;
+
+  struct scenario {
+    const char*     label;
+    meter::cost     (*run)(fusion_tester&);
+    bool            init_rewards = true;
+    const char*     expected_error = nullptr; /* a path that fails on chain too, measured up to the failure */
+  };
+
+  struct result {
+    std::string           label;
+    meter::cost           cost;
+    double                wall_us_median = 0;
+    double                wall_us_min = 0;
+    const char*           expected_error = nullptr;
+
+    bool as_expected() const {
+      return expected_error == nullptr ? cost.succeeded : !cost.succeeded && cost.error.find( expected_error ) != std::string::npos;
+    }
+  };
+
+  /* prefix + 4 letters */
+  eosio::name account_name(const char* prefix, uint64_t index){
+    std::string s(prefix);
+    char letters[4];
+    for( int i = 3; i >= 0; i-- ){
+      letters[i] = char( 'a' + index % 26 );
+      index /= 26;
+    }
+    s.append( letters, 4 );
+    return eosio::name(s);
+  }
+
+  void sync_epoch(fusion_tester& t){ t.chain.push( FUSION, FUSION, "sync"_n, FUSION ); }
+
+  /* alice and bob with 1000 sWAX each, one distribution of 100 WAX and 6 hours of rewards streamed since */
+  void populated(fusion_tester& t){
+    t.stake( ALICE, wax(1000) );
+    t.stake( BOB, wax(1000) );
+    t.add_revenue( wax(100) );
+    t.distribute();
+    t.advance( 60 * 60 * 6 );
+  }
+
+  /* populated, and the rental pool staked to the next epoch so redemption requests can be placed */
+  void staked_to_cpu(fusion_tester& t){
+    populated(t);
+    const uint64_t next_stakeall = t.get_state().next_stakeall_time;
+    if( t.chain.now() < next_stakeall ) t.chain.set_time( uint32_t( next_stakeall ) );
+    t.chain.push( KEEPER, FUSION, "stakeallcpu"_n );
+  }
+
+  std::vector<eosio::name> many_stakers(fusion_tester& t, uint64_t count){
+    std::vector<eosio::name> users;
+    for( uint64_t i = 0; i < count; i++ ){
+      users.push_back( account_name( "stkr", i ) );
+      t.stake( users.back(), wax( double( 10 + i ) ) );
+    }
+    return users;
+  }
+
+  /* count snapshots rows from before streaming started, one per day */
+  void seed_legacy_snapshots(fusion_tester& t, uint64_t count){
+    const uint64_t streaming_start_time = t.get_rewards().streaming_start_time;
+    t.seed( [&]{
+      snaps_table snaps_t( FUSION, FUSION.value );
+      for( uint64_t i = 1; i <= count; i++ ){
+        snaps_t.emplace( FUSION, [&](auto &_snap){
+          _snap.timestamp = streaming_start_time - i * DAY;
+          _snap.swax_earning_bucket = wax(1);
+          _snap.lswax_autocompounding_bucket = wax(0);
+          _snap.pol_bucket = wax(0);
+          _snap.ecosystem_bucket = wax(0);
+          _snap.total_distributed = wax(1);
+          _snap.total_swax_earning = swax(1000);
+        });
+      }
+    });
+  }
+
+  /* 21 active producers with votes, in the system contract's producers table */
+  void seed_producers(fusion_tester& t){
+    t.chain.as( SYSTEM_CONTRACT, [&]{
+      producers_table producers_t( SYSTEM_CONTRACT, SYSTEM_CONTRACT.value );
+      for( uint64_t i = 0; i < 21; i++ ){
+        producers_t.emplace( SYSTEM_CONTRACT, [&](auto &_p){
+          _p.owner = account_name( "prod", i );
+          _p.total_votes = double( 1000 + i );
+          _p.is_active = true;
+          _p.location = uint16_t(i);
+        });
+      }
+    });
+  }
+
+  /* the delband row unstakecpu looks for before it sends unstakebatch */
+  void seed_delband(fusion_tester& t, eosio::name cpu){
+    t.chain.as( SYSTEM_CONTRACT, [&]{
+      del_bandwidth_table del_t( SYSTEM_CONTRACT, cpu.value );
+      del_t.emplace( SYSTEM_CONTRACT, [&](auto &_d){
+        _d.from = cpu;
+        _d.to = cpu;
+        _d.net_weight = wax(0);
+        _d.cpu_weight = wax(1);
+      });
+    });
+  }
+
+  /* an lsWAX/WAX pool on swax.alcor, with an incentive set up for it */
+  void seed_pool(fusion_tester& t, bool with_incentive){
+    t.chain.as( ALCOR_CONTRACT, [&]{
+      alcor_contract::pools_table pools_t( ALCOR_CONTRACT, ALCOR_CONTRACT.value );
+      pools_t.emplace( ALCOR_CONTRACT, [&](auto &_p){
+        _p.id = POOL_ID;
+        _p.active = true;
+        _p.tokenA = eosio::extended_asset( lswax(0), TOKEN_CONTRACT );
+        _p.tokenB = eosio::extended_asset( wax(0), WAX_CONTRACT );
+        _p.protocolFeeA = lswax(0);
+        _p.protocolFeeB = wax(0);
+      });
+    });
+
+    if( with_incentive ){
+      t.chain.push( FUSION, FUSION, "setincentive"_n, POOL_ID, WAX_SYMBOL, WAX_CONTRACT, uint64_t( 50 * SCALE_FACTOR_1E6 ) );
+    }
+  }
+
+  std::string rent_memo(eosio::name receiver, uint64_t wax_amount, uint64_t epoch_id){
+    return "|rent_cpu|" + receiver.to_string() + "|" + std::to_string(wax_amount) + "|" + std::to_string(epoch_id) + "|";
+  }
+
+  meter::cost push_self(fusion_tester& t, eosio::name action_name){ return meter::push( t.chain, FUSION, FUSION, action_name ); }
+
+  template<typename... Args>
+  meter::cost push_self(fusion_tester& t, eosio::name action_name, Args&&... args){
+    return meter::push( t.chain, FUSION, FUSION, action_name, std::forward<Args>(args)... );
+  }
+
+  const std::vector<scenario>& scenarios(){
+    static const std::vector<scenario> all = {
+
+      { "addadmin", [](fusion_tester& t){
+        t.chain.create_account( "newadmin"_n );
+        return push_self( t, "addadmin"_n, "newadmin"_n );
+      }},
+
+      { "addcpucntrct", [](fusion_tester& t){
+        t.chain.create_account( "cpu4.fusion"_n );
+        return push_self( t, "addcpucntrct"_n, "cpu4.fusion"_n );
+      }},
+
+      { "claimaslswax", [](fusion_tester& t){
+        populated(t);
+        return meter::push( t.chain, ALICE, FUSION, "claimaslswax"_n, ALICE, eosio::asset( 1, LSWAX_SYMBOL ), uint64_t(0) );
+      }},
+
+      { "claimgbmvote", [](fusion_tester& t){
+        return meter::push( t.chain, KEEPER, FUSION, "claimgbmvote"_n, "cpu1.fusion"_n );
+      }},
+
+      { "claimrefunds", [](fusion_tester& t){
+        const uint32_t requested = t.chain.now() - REFUND_DELAY_SEC - 60;
+        t.chain.as( SYSTEM_CONTRACT, [&]{
+          refunds_table refunds_t( SYSTEM_CONTRACT, "cpu1.fusion"_n.value );
+          refunds_t.emplace( SYSTEM_CONTRACT, [&](auto &_r){
+            _r.owner = "cpu1.fusion"_n;
+            _r.request_time = eosio::time_point_sec( requested );
+            _r.net_amount = wax(0);
+            _r.cpu_amount = wax(100);
+          });
+        });
+        return meter::push( t.chain, KEEPER, FUSION, "claimrefunds"_n );
+      }},
+
+      { "claimrewards", [](fusion_tester& t){
+        populated(t);
+        return meter::push( t.chain, ALICE, FUSION, "claimrewards"_n, ALICE );
+      }},
+
+      { "claimswax", [](fusion_tester& t){
+        populated(t);
+        return meter::push( t.chain, ALICE, FUSION, "claimswax"_n, ALICE );
+      }},
+
+      { "clearexpired", [](fusion_tester& t){
+        staked_to_cpu(t);
+        t.chain.push( ALICE, FUSION, "reqredeem"_n, ALICE, swax(100), true );
+        t.advance( 4 * 7 * DAY );
+        return meter::push( t.chain, ALICE, FUSION, "clearexpired"_n, ALICE );
+      }},
+
+      { "clearsnaps (statesnaps)", [](fusion_tester& t){
+        t.seed( [&]{
+          state_snaps_table state_snaps_t( FUSION, FUSION.value );
+          for( uint64_t i = 1; i <= 100; i++ ){
+            state_snaps_t.emplace( FUSION, [&](auto &_s){
+              _s.timestamp = t.chain.now() - i * DAY;
+              _s.total_wax_owed = wax(0);
+              _s.contract_wax_balance = wax(0);
+            });
+          }
+        });
+        return push_self( t, "clearsnaps"_n, uint64_t(0), 0 );
+      }},
+
+      { "clearsnaps (statering)", [](fusion_tester& t){
+        populated(t);
+        for( int day = 0; day < 10; day++ ){
+          t.add_revenue( wax(10) );
+          t.distribute();
+        }
+        //shrink the daily ring, leaving its old slots to clear
+        t.chain.push( FUSION, FUSION, "setsnaptiers"_n, std::vector<snapshot_tier>{ { 60 * 60 * 24, 1 } } );
+        return push_self( t, "clearsnaps"_n, uint64_t( 60 * 60 * 24 ), 0 );
+      }},
+
+      { "createfarms", [](fusion_tester& t){
+        seed_pool( t, true );
+        populated(t);
+        t.fund( "sponsor"_n, wax(100) );
+        t.transfer( WAX_CONTRACT, "sponsor"_n, FUSION, wax(100), "lp_incentives" );
+        t.chain.set_time( uint32_t( t.get_settlements().next_settlement ) );
+        t.settle();
+        t.advance( 8 * DAY );
+        return meter::push( t.chain, KEEPER, FUSION, "createfarms"_n );
+      //createfarms looks up the incentive newincentive creates before that inline action has run
+      }, true, "cannot dereference end iterator" },
+
+      { "distribute", [](fusion_tester& t){
+        populated(t);
+        t.add_revenue( wax(100) );
+        t.chain.set_time( uint32_t( t.get_state().next_distribution ) );
+        return meter::push( t.chain, KEEPER, FUSION, "distribute"_n );
+      }},
+
+      { "distribute (no revenue)", [](fusion_tester& t){
+        populated(t);
+        t.chain.set_time( uint32_t( t.get_state().next_distribution ) );
+        return meter::push( t.chain, KEEPER, FUSION, "distribute"_n );
+      }},
+
+      { "initrewards", [](fusion_tester& t){
+        return push_self( t, "initrewards"_n );
+      }, false },
+
+      { "inittop21", [](fusion_tester& t){
+        seed_producers(t);
+        return push_self( t, "inittop21"_n );
+      }},
+
+      { "instaredeem", [](fusion_tester& t){
+        populated(t);
+        return meter::push( t.chain, ALICE, FUSION, "instaredeem"_n, ALICE, swax(100) );
+      }},
+
+      { "liquify", [](fusion_tester& t){
+        populated(t);
+        return meter::push( t.chain, ALICE, FUSION, "liquify"_n, ALICE, swax(100) );
+      }},
+
+      { "liquifyexact", [](fusion_tester& t){
+        populated(t);
+        return meter::push( t.chain, ALICE, FUSION, "liquifyexact"_n, ALICE, swax(100), lswax(100), uint64_t( 10 * SCALE_FACTOR_1E6 ) );
+      }},
+
+      { "migratesnaps", [](fusion_tester& t){
+        seed_legacy_snapshots( t, 50 );
+        return meter::push( t.chain, KEEPER, FUSION, "migratesnaps"_n, 50 );
+      }},
+
+      { "payroutes", [](fusion_tester& t){
+        const std::vector<eosio::name> users = many_stakers( t, 20 );
+        for( const eosio::name user : users ) t.chain.push( user, FUSION, "setroute"_n, user, REWARD_ROUTE_CONVERT_LSWAX );
+        t.add_revenue( wax(1000) );
+        t.distribute();
+        t.advance( DAY );
+        for( const eosio::name user : users ) t.chain.push( user, FUSION, "stake"_n, user );
+        return meter::push( t.chain, KEEPER, FUSION, "payroutes"_n, 50 );
+      }},
+
+      { "prunesnaps", [](fusion_tester& t){
+        seed_legacy_snapshots( t, 50 );
+        populated(t);
+        t.chain.push( KEEPER, FUSION, "scanstakers"_n, 500 );
+        return meter::push( t.chain, KEEPER, FUSION, "prunesnaps"_n, 500 );
+      }},
+
+      { "reallocate", [](fusion_tester& t){
+        populated(t);
+        t.advance( 3 * DAY );
+        t.seed( [&]{
+          state_singleton states( FUSION, FUSION.value );
+          state s = states.get();
+          s.wax_for_redemption = wax(100);
+          s.wax_available_for_rentals.amount -= units(100);
+          states.set( s, FUSION );
+        });
+        return meter::push( t.chain, KEEPER, FUSION, "reallocate"_n );
+      }},
+
+      { "redeem", [](fusion_tester& t){
+        populated(t);
+        sync_epoch(t);
+        const uint64_t epoch_to_claim_from = t.get_state().last_epoch_start_time - config_singleton_3( FUSION, FUSION.value ).get().seconds_between_epochs;
+        t.seed( [&]{
+          requests_tbl requests_t( FUSION, ALICE.value );
+          requests_t.emplace( ALICE, [&](auto &_r){
+            _r.epoch_id = epoch_to_claim_from;
+            _r.wax_amount_requested = wax(100);
+          });
+
+          state_singleton states( FUSION, FUSION.value );
+          state s = states.get();
+          s.wax_for_redemption = wax(100);
+          s.wax_available_for_rentals.amount -= units(100);
+          states.set( s, FUSION );
+        });
+        return meter::push( t.chain, ALICE, FUSION, "redeem"_n, ALICE );
+      }},
+
+      { "removeadmin", [](fusion_tester& t){
+        return push_self( t, "removeadmin"_n, "oig"_n );
+      }},
+
+      { "reqredeem", [](fusion_tester& t){
+        staked_to_cpu(t);
+        return meter::push( t.chain, ALICE, FUSION, "reqredeem"_n, ALICE, swax(100), true );
+      }},
+
+      { "rmvcpucntrct", [](fusion_tester& t){
+        return push_self( t, "rmvcpucntrct"_n, "cpu3.fusion"_n );
+      }},
+
+      { "rmvincentive", [](fusion_tester& t){
+        seed_pool( t, true );
+        return push_self( t, "rmvincentive"_n, POOL_ID );
+      }},
+
+      { "scanstakers", [](fusion_tester& t){
+        many_stakers( t, 50 );
+        return meter::push( t.chain, KEEPER, FUSION, "scanstakers"_n, 500 );
+      }},
+
+      { "setfallback", [](fusion_tester& t){
+        return push_self( t, "setfallback"_n, FUSION, KEEPER );
+      }},
+
+      { "setincentive", [](fusion_tester& t){
+        seed_pool( t, false );
+        return push_self( t, "setincentive"_n, POOL_ID, WAX_SYMBOL, WAX_CONTRACT, uint64_t( 50 * SCALE_FACTOR_1E6 ) );
+      }},
+
+      { "setpolshare", [](fusion_tester& t){
+        return push_self( t, "setpolshare"_n, uint64_t( 6 * SCALE_FACTOR_1E6 ) );
+      }},
+
+      { "setrentprice", [](fusion_tester& t){
+        return push_self( t, "setrentprice"_n, FUSION, wax(0.02) );
+      }},
+
+      { "setroute", [](fusion_tester& t){
+        populated(t);
+        return meter::push( t.chain, ALICE, FUSION, "setroute"_n, ALICE, REWARD_ROUTE_COMPOUND_SWAX );
+      }},
+
+      { "setsnaptiers", [](fusion_tester& t){
+        return push_self( t, "setsnaptiers"_n, std::vector<snapshot_tier>{ { 60 * 30, 336 }, { 60 * 60 * 4, 540 }, { 60 * 60 * 24, 365 } } );
+      }},
+
+      { "setsettleint", [](fusion_tester& t){
+        return push_self( t, "setsettleint"_n, uint64_t( 60 * 60 ) );
+      }},
+
+      { "settle", [](fusion_tester& t){
+        populated(t);
+        t.chain.set_time( uint32_t( t.get_settlements().next_settlement ) );
+        return meter::push( t.chain, KEEPER, FUSION, "settle"_n );
+      }},
+
+      { "stake (new row)", [](fusion_tester& t){
+        t.chain.create_account( ALICE );
+        return meter::push( t.chain, ALICE, FUSION, "stake"_n, ALICE );
+      }},
+
+      { "stake (sync)", [](fusion_tester& t){
+        populated(t);
+        return meter::push( t.chain, ALICE, FUSION, "stake"_n, ALICE );
+      }},
+
+      { "stakeallcpu", [](fusion_tester& t){
+        populated(t);
+        t.chain.set_time( uint32_t( std::max<uint64_t>( t.chain.now(), t.get_state().next_stakeall_time ) ) );
+        return meter::push( t.chain, KEEPER, FUSION, "stakeallcpu"_n );
+      }},
+
+      { "sweepstakers", [](fusion_tester& t){
+        const uint64_t streaming_start_time = t.get_rewards().streaming_start_time;
+        seed_legacy_snapshots( t, 1 );
+        t.seed( [&]{
+          staker_table staker_t( FUSION, FUSION.value );
+          for( uint64_t i = 0; i < 50; i++ ){
+            staker_t.emplace( FUSION, [&](auto &_s){
+              _s.wallet = account_name( "stkr", i );
+              _s.swax_balance = swax(20);
+              _s.claimable_wax = wax(0);
+              _s.last_update = streaming_start_time - 2 * DAY;
+              _s.reward_per_swax_paid_1e12 = 0;
+              _s.reward_route = REWARD_ROUTE_CLAIMABLE_WAX;
+            });
+          }
+
+          state_singleton states( FUSION, FUSION.value );
+          state s = states.get();
+          s.swax_currently_earning = swax(1000);
+          s.user_funds_bucket = wax(1);
+          states.set( s, FUSION );
+        });
+        t.chain.push( FUSION, FUSION, "synctvl"_n, FUSION );
+        return meter::push( t.chain, KEEPER, FUSION, "sweepstakers"_n, 50 );
+      }},
+
+      { "sync", [](fusion_tester& t){
+        t.advance( 7 * DAY );
+        return push_self( t, "sync"_n, FUSION );
+      }},
+
+      { "synctvl", [](fusion_tester& t){
+        populated(t);
+        return push_self( t, "synctvl"_n, FUSION );
+      }},
+
+      { "unstakecpu", [](fusion_tester& t){
+        populated(t);
+        seed_delband( t, "cpu1.fusion"_n );
+        for( uint64_t i = 0; i < 10; i++ ){
+          const eosio::name renter = account_name( "rntr", i );
+          t.fund( renter, wax(20) );
+          t.transfer( WAX_CONTRACT, renter, FUSION, wax(20), rent_memo( renter, 100, INITIAL_EPOCH_START_TIMESTAMP ) );
+        }
+        t.chain.set_time( INITIAL_EPOCH_START_TIMESTAMP + 12 * DAY );
+        return meter::push( t.chain, KEEPER, FUSION, "unstakecpu"_n, uint64_t(0), 0 );
+      }},
+
+      { "updatetop21", [](fusion_tester& t){
+        seed_producers(t);
+        t.chain.push( FUSION, FUSION, "inittop21"_n );
+        t.advance( DAY );
+        return meter::push( t.chain, KEEPER, FUSION, "updatetop21"_n );
+      }},
+
+      { "memo: stake", [](fusion_tester& t){
+        populated(t);
+        t.fund( ALICE, wax(100) );
+        return meter::transfer( t.chain, WAX_CONTRACT, ALICE, FUSION, wax(100), "stake" );
+      }},
+
+      { "memo: unliquify", [](fusion_tester& t){
+        populated(t);
+        t.chain.push( ALICE, FUSION, "liquify"_n, ALICE, swax(100) );
+        return meter::transfer( t.chain, TOKEN_CONTRACT, ALICE, FUSION, lswax(50), "unliquify" );
+      }},
+
+      { "memo: unliquify_exact", [](fusion_tester& t){
+        populated(t);
+        t.chain.push( ALICE, FUSION, "liquify"_n, ALICE, swax(100) );
+        return meter::transfer( t.chain, TOKEN_CONTRACT, ALICE, FUSION, lswax(50),
+          "|unliquify_exact|" + std::to_string( units(50) ) + "|" + std::to_string( uint64_t( 10 * SCALE_FACTOR_1E6 ) ) + "|" );
+      }},
+
+      { "memo: waxfusion_revenue", [](fusion_tester& t){
+        populated(t);
+        t.fund( fusion_tester::REVENUE, wax(100) );
+        return meter::transfer( t.chain, WAX_CONTRACT, fusion_tester::REVENUE, FUSION, wax(100), "waxfusion_revenue" );
+      }},
+
+      { "memo: lp_incentives", [](fusion_tester& t){
+        populated(t);
+        t.fund( "sponsor"_n, wax(100) );
+        return meter::transfer( t.chain, WAX_CONTRACT, "sponsor"_n, FUSION, wax(100), "lp_incentives" );
+      }},
+
+      { "memo: cpu rental return", [](fusion_tester& t){
+        staked_to_cpu(t);
+        //returns are matched to the epoch that started two rental lengths (28 days) before the current one,
+        //and sync_epoch only moves one epoch at a time
+        for( uint32_t week = 1; week < 4; week++ ){
+          t.chain.set_time( INITIAL_EPOCH_START_TIMESTAMP + week * 7 * DAY + 60 * 60 );
+          sync_epoch(t);
+        }
+        t.chain.set_time( INITIAL_EPOCH_START_TIMESTAMP + 28 * DAY + 60 * 60 );
+        t.fund( "cpu1.fusion"_n, wax(100) );
+        return meter::transfer( t.chain, WAX_CONTRACT, "cpu1.fusion"_n, FUSION, wax(100), "cpu rental return" );
+      }},
+
+      { "memo: wax_lswax_liquidity", [](fusion_tester& t){
+        populated(t);
+        t.fund( POL_CONTRACT, wax(100) );
+        return meter::transfer( t.chain, WAX_CONTRACT, POL_CONTRACT, FUSION, wax(100), "wax_lswax_liquidity" );
+      }},
+
+      { "memo: rent_cpu", [](fusion_tester& t){
+        populated(t);
+        const eosio::name renter = "renter"_n;
+        t.fund( renter, wax(20) );
+        const uint64_t next_epoch = t.get_state().last_epoch_start_time + config_singleton_3( FUSION, FUSION.value ).get().seconds_between_epochs;
+        return meter::transfer( t.chain, WAX_CONTRACT, renter, FUSION, wax(20), rent_memo( renter, 100, next_epoch ) );
+      }},
+
+      { "memo: stake_liquify", [](fusion_tester& t){
+        populated(t);
+        t.fund( ALICE, wax(100) );
+        return meter::transfer( t.chain, WAX_CONTRACT, ALICE, FUSION, wax(100), "|stake_liquify|" + std::to_string( units(90) ) + "|" );
+      }},
+
+      { "memo: instant_redeem", [](fusion_tester& t){
+        populated(t);
+        t.chain.push( ALICE, FUSION, "liquify"_n, ALICE, swax(100) );
+        return meter::transfer( t.chain, TOKEN_CONTRACT, ALICE, FUSION, lswax(50), "|instant_redeem|" + std::to_string( units(45) ) + "|" );
+      }},
+
+      { "memo: other", [](fusion_tester& t){
+        populated(t);
+        t.fund( "sponsor"_n, wax(1) );
+        return meter::transfer( t.chain, WAX_CONTRACT, "sponsor"_n, FUSION, wax(1), "thanks for the cpu" );
+      }}
+    };
+    return all;
+  }
+
+}
+
+namespace {
+
+  struct options {
+    uint64_t                  repetitions = 25;
+    std::string               filter;
+    std::string               exclude;
+    std::string               output;
+    std::vector<std::string>  compare;
+  };
+
+  double median(std::vector<double> values){
+    std::sort( values.begin(), values.end() );
+    return values[ values.size() / 2 ];
+  }
+
+  result run(const scenario& s, uint64_t repetitions){
+    result r;
+    r.label = s.label;
+    r.expected_error = s.expected_error;
+    std::vector<double> wall_us;
+
+    for( uint64_t i = 0; i < repetitions; i++ ){
+      fusion_tester t( s.init_rewards );
+      t.chain.create_account( KEEPER );
+
+      meter::cost c;
+      try {
+        c = s.run(t);
+      } catch( const eosio::check_failure& e ){
+        //the setup itself failed
+        c.error = std::string("setup: ") + e.what();
+      }
+
+      if( i == 0 ) r.cost = c;
+      wall_us.push_back( c.wall_us );
+    }
+
+    r.wall_us_median = median( wall_us );
+    r.wall_us_min = *std::min_element( wall_us.begin(), wall_us.end() );
+    return r;
+  }
+
+  void print_results(const std::vector<result>& results){
+    std::printf( "%-26s %9s %9s %7s %8s %6s %7s %7s %7s %6s %6s %7s\n", "scenario", "us p50", "us min", "allocs", "alloc kb",
+      "bytes", "inlines", "reads", "writes", "snaps", "rows", "ram" );
+    for( const result& r : results ){
+      const meter::cost& c = r.cost;
+      std::printf( "%-26s %9.1f %9.1f %7llu %8.1f %6llu %7llu %7llu %7llu %6llu %6llu %7lld%s%s\n", r.label.c_str(), r.wall_us_median, r.wall_us_min,
+        (unsigned long long) c.allocations, double( c.allocated_bytes ) / 1024.0, (unsigned long long) c.action_bytes,
+        (unsigned long long) c.inline_actions, (unsigned long long) c.counts.db_reads, (unsigned long long) c.counts.db_writes,
+        (unsigned long long) c.counts.snapshots_iterated, (unsigned long long) c.rows_written, (long long) c.ram_bytes,
+        c.succeeded ? "" : r.as_expected() ? "  expected failure: " : "  FAILED: ", c.succeeded ? "" : c.error.c_str() );
+    }
+  }
+
+  void write_report(FILE* f, const std::vector<result>& results, uint64_t repetitions){
+    std::fprintf( f, "{\n  \"format\": \"fusion-bench-1\",\n  \"repetitions\": %llu,\n  \"scenarios\": [", (unsigned long long) repetitions );
+
+    for( std::size_t i = 0; i < results.size(); i++ ){
+      const result& r = results[i];
+      const meter::cost& c = r.cost;
+
+      std::fprintf( f, "%s\n    {\"scenario\": %s, \"succeeded\": %s, \"error\": %s, \"wall_us\": %.2f, \"wall_us_min\": %.2f,",
+        i == 0 ? "" : ",", json::quote( r.label ).c_str(), c.succeeded ? "true" : "false", json::quote( c.error ).c_str(),
+        r.wall_us_median, r.wall_us_min );
+      std::fprintf( f, " \"allocations\": %llu, \"allocated_bytes\": %llu, \"action_bytes\": %llu, \"inline_actions\": %llu,"
+        " \"notifications\": %llu, \"rows_written\": %llu, \"ram_bytes\": %lld,",
+        (unsigned long long) c.allocations, (unsigned long long) c.allocated_bytes, (unsigned long long) c.action_bytes,
+        (unsigned long long) c.inline_actions, (unsigned long long) c.notifications, (unsigned long long) c.rows_written, (long long) c.ram_bytes );
+      std::fprintf( f, " \"db_reads\": %llu, \"db_writes\": %llu, \"rows_emplaced\": %llu, \"rows_erased\": %llu, \"snapshots_iterated\": %llu,",
+        (unsigned long long) c.counts.db_reads, (unsigned long long) c.counts.db_writes, (unsigned long long) c.counts.rows_emplaced,
+        (unsigned long long) c.counts.rows_erased, (unsigned long long) c.counts.snapshots_iterated );
+
+      std::fprintf( f, " \"table_ram_bytes\": {" );
+      bool first = true;
+      for( const auto& [table, bytes] : c.table_ram_bytes ){
+        std::fprintf( f, "%s%s: %lld", first ? "" : ", ", json::quote( table.to_string() ).c_str(), (long long) bytes );
+        first = false;
+      }
+      std::fprintf( f, "}}" );
+    }
+
+    std::fprintf( f, "\n  ]\n}\n" );
+  }
+
+  /* prints the change in each metric between two reports, scenarios are matched by label */
+  int compare(const std::string& before_path, const std::string& after_path){
+    const json::value before = json::parse_file( before_path );
+    const json::value after = json::parse_file( after_path );
+
+    auto find = [](const json::value& report, const std::string& label) -> const json::value* {
+      for( const json::value& s : report.at("scenarios").items ) if( s.at("scenario").as_string() == label ) return &s;
+      return nullptr;
+    };
+
+    auto delta = [](const json::value& b, const json::value& a, const char* key){
+      return a.at(key).as_int64() - b.at(key).as_int64();
+    };
+
+    std::printf( "%s -> %s\n\n", before_path.c_str(), after_path.c_str() );
+    std::printf( "%-26s %9s %9s %8s %8s %8s %8s %7s %7s %7s %7s\n", "scenario", "us before", "us after", "us %",
+      "allocs", "allocs", "alloc kb", "reads", "writes", "rows", "ram" );
+
+    double total_before = 0, total_after = 0;
+    int64_t allocations_before = 0, allocations_after = 0;
+
+    for( const json::value& a : after.at("scenarios").items ){
+      const std::string& label = a.at("scenario").as_string();
+      const json::value* b = find( before, label );
+
+      if( b == nullptr ){
+        std::printf( "%-26s only in %s\n", label.c_str(), after_path.c_str() );
+        continue;
+      }
+
+      //a scenario that fails the same way in both (createfarms) is still compared up to its failure
+      if( b->at("error").as_string() != a.at("error").as_string() ){
+        const bool failed_before = !b->at("succeeded").as_bool();
+        std::printf( "%-26s failed in %s: %s\n", label.c_str(), failed_before ? before_path.c_str() : after_path.c_str(),
+          ( failed_before ? b : &a )->at("error").as_string().c_str() );
+        continue;
+      }
+
+      const double us_before = b->at("wall_us").as_double();
+      const double us_after = a.at("wall_us").as_double();
+      total_before += us_before;
+      total_after += us_after;
+      allocations_before += b->at("allocations").as_int64();
+      allocations_after += a.at("allocations").as_int64();
+
+      std::printf( "%-26s %9.1f %9.1f %+7.1f%% %8lld %8lld %+8.1f %+7lld %+7lld %+7lld %+7lld\n", label.c_str(), us_before, us_after,
+        us_before == 0 ? 0.0 : 100.0 * ( us_after - us_before ) / us_before,
+        (long long) b->at("allocations").as_int64(), (long long) a.at("allocations").as_int64(),
+        double( delta( *b, a, "allocated_bytes" ) ) / 1024.0, (long long) delta( *b, a, "db_reads" ), (long long) delta( *b, a, "db_writes" ),
+        (long long) delta( *b, a, "rows_written" ), (long long) delta( *b, a, "ram_bytes" ) );
+    }
+
+    for( const json::value& b : before.at("scenarios").items ){
+      if( find( after, b.at("scenario").as_string() ) == nullptr ) std::printf( "%-26s only in %s\n", b.at("scenario").as_string().c_str(), before_path.c_str() );
+    }
+
+    std::printf( "\n%-26s %9.1f %9.1f %+7.1f%% %8lld %8lld\n", "total", total_before, total_after,
+      total_before == 0 ? 0.0 : 100.0 * ( total_after - total_before ) / total_before, (long long) allocations_before, (long long) allocations_after );
+    std::printf( "(us is the median wall time, allocs are before and after, the other columns are after - before)\n" );
+    return 0;
+  }
+
+  bool parse(int argc, char** argv, options& o){
+    for( int i = 1; i < argc; i++ ){
+      const bool has_value = i + 1 < argc;
+
+      if( std::strcmp( argv[i], "--repetitions" ) == 0 && has_value ) o.repetitions = std::strtoull( argv[++i], nullptr, 10 );
+      else if( std::strcmp( argv[i], "--filter" ) == 0 && has_value ) o.filter = argv[++i];
+      else if( std::strcmp( argv[i], "--exclude" ) == 0 && has_value ) o.exclude = argv[++i];
+      else if( std::strcmp( argv[i], "--output" ) == 0 && has_value ) o.output = argv[++i];
+      else if( std::strcmp( argv[i], "--compare" ) == 0 && i + 2 < argc ){
+        o.compare = { argv[i + 1], argv[i + 2] };
+        i += 2;
+      }
+      else return false;
+    }
+    return o.repetitions > 0;
+  }
+
+}
+
+int main(int argc, char** argv){
+  options o;
+  if( !parse( argc, argv, o ) ){
+    std::fprintf( stderr, "usage: %s [--repetitions n] [--filter text] [--exclude text] [--output report.json]\n"
+                          "       %s --compare before.json after.json\n", argv[0], argv[0] );
+    return 2;
+  }
+
+  if( !o.compare.empty() ){
+    try {
+      return compare( o.compare[0], o.compare[1] );
+    } catch( const json::error& e ){
+      std::fprintf( stderr, "%s\n", e.what() );
+      return 2;
+    }
+  }
+
+  std::vector<result> results;
+  for( const scenario& s : scenarios() ){
+    if( !o.filter.empty() && std::string( s.label ).find( o.filter ) == std::string::npos ) continue;
+    if( !o.exclude.empty() && std::string( s.label ).find( o.exclude ) != std::string::npos ) continue;
+    results.push_back( run( s, o.repetitions ) );
+  }
+
+  print_results( results );
+
+  if( !o.output.empty() ){
+    FILE* f = std::fopen( o.output.c_str(), "w" );
+    if( f == nullptr ){
+      std::fprintf( stderr, "could not write %s\n", o.output.c_str() );
+      return 2;
+    }
+    write_report( f, results, o.repetitions );
+    std::fclose( f );
+  }
+
+  const bool all_as_expected = std::all_of( results.begin(), results.end(), [](const result& r){ return r.as_expected(); } );
+  return all_as_expected ? 0 : 1;
+}
@@ -0,0 +1,131 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "safe_reference.hpp"
+
+/**
+* bench_math times safe_math against the checks safe.cpp used to do (see safe_reference.hpp), e.g.
+*   ./build/tests/bench/bench_math --repetitions 25
+*
+* - every pair runs over the same inputs: asset sized operands (up to 2^40, about 11,000 WAX)
+*   and divisors that are never 0, drawn from a fixed seed
+* - the time per call is the median (and minimum) over --repetitions runs of --iterations calls each
+* - the results of each pair are summed and compared, so a pair that disagrees makes bench_math exit with 1
+*/
+
+namespace {
+
+  struct inputs {
+    std::vector<uint64_t>   a;
+    std::vector<uint64_t>   b;
+    std::vector<uint64_t>   c;
+  };
+
+  struct options {
+    uint64_t    repetitions = 25;
+    uint64_t    iterations = 1 << 20;
+  };
+
+  inputs make_inputs(size_t count){
+    std::mt19937_64 rng( 47 );
+    std::uniform_int_distribution<uint64_t> operand( 0, uint64_t(1) << 40 );
+    std::uniform_int_distribution<uint64_t> divisor( 1, uint64_t(1) << 40 );
+
+    inputs in;
+    for( size_t i = 0; i < count; i++ ){
+      in.a.push_back( operand(rng) );
+      in.b.push_back( operand(rng) );
+      in.c.push_back( divisor(rng) );
+    }
+    return in;
+  }
+
+  struct timing {
+    double      ns_median = 0;
+    double      ns_min = 0;
+    uint128_t   checksum = 0;
+  };
+
+  template<typename F>
+  timing measure(const inputs& in, const options& o, F&& f){
+    const size_t mask = in.a.size() - 1;
+    std::vector<double> ns;
+    timing t;
+
+    for( uint64_t r = 0; r < o.repetitions; r++ ){
+      uint128_t sum = 0;
+      const auto start = std::chrono::steady_clock::now();
+      for( uint64_t i = 0; i < o.iterations; i++ ){
+        const size_t k = i & mask;
+        sum += f( in.a[k], in.b[k], in.c[k] );
+      }
+      const auto stop = std::chrono::steady_clock::now();
+
+      ns.push_back( std::chrono::duration<double, std::nano>( stop - start ).count() / double( o.iterations ) );
+      t.checksum = sum;
+    }
+
+    std::sort( ns.begin(), ns.end() );
+    t.ns_median = ns[ ns.size() / 2 ];
+    t.ns_min = ns.front();
+    return t;
+  }
+
+  bool compare(const char* label, const inputs& in, const options& o, auto&& before, auto&& after){
+    const timing b = measure( in, o, before );
+    const timing a = measure( in, o, after );
+
+    std::printf( "%-36s %8.2f %8.2f %8.2f %8.2f %+7.1f%%%s\n", label, b.ns_median, b.ns_min, a.ns_median, a.ns_min,
+      b.ns_median == 0 ? 0.0 : 100.0 * ( a.ns_median - b.ns_median ) / b.ns_median, a.checksum == b.checksum ? "" : "  results differ" );
+    return a.checksum == b.checksum;
+  }
+
+  bool parse(int argc, char** argv, options& o){
+    for( int i = 1; i < argc; i++ ){
+      const bool has_value = i + 1 < argc;
+
+      if( std::strcmp( argv[i], "--repetitions" ) == 0 && has_value ) o.repetitions = std::strtoull( argv[++i], nullptr, 10 );
+      else if( std::strcmp( argv[i], "--iterations" ) == 0 && has_value ) o.iterations = std::strtoull( argv[++i], nullptr, 10 );
+      else return false;
+    }
+    return o.repetitions > 0 && o.iterations > 0;
+  }
+
+}
+
+int main(int argc, char** argv){
+  options o;
+  if( !parse( argc, argv, o ) ){
+    std::fprintf( stderr, "usage: %s [--repetitions n] [--iterations n]\n", argv[0] );
+    return 2;
+  }
+
+  const inputs in = make_inputs( 4096 );
+  bool same = true;
+
+  std::printf( "%-36s %8s %8s %8s %8s %8s\n", "ns per call", "safe.cpp", "min", "safe_math", "min", "change" );
+
+  same &= compare( "mul", in, o,
+    [](uint64_t a, uint64_t b, uint64_t){ return reference::safe_mul_u128( a, b ); },
+    [](uint64_t a, uint64_t b, uint64_t){ return safe_math::mul( a, b ); } );
+
+  same &= compare( "muldiv (safeMulUInt128( a, b ) / c)", in, o,
+    [](uint64_t a, uint64_t b, uint64_t c){ return reference::muldiv( a, b, c ); },
+    [](uint64_t a, uint64_t b, uint64_t c){ return safe_math::muldiv( a, b, c ); } );
+
+  same &= compare( "muldiv rounding up", in, o,
+    [](uint64_t a, uint64_t b, uint64_t c){ const uint128_t p = reference::safe_mul_u128( a, b ); return p / c + ( p % c != 0 ? 1 : 0 ); },
+    [](uint64_t a, uint64_t b, uint64_t c){ return safe_math::muldiv( a, b, c, safe_math::rounding::up ); } );
+
+  //percentages up to 100%
+  same &= compare( "calculate_asset_share", in, o,
+    [](uint64_t a, uint64_t b, uint64_t){ return (uint128_t) reference::asset_share( int64_t(a), b % ( ONE_HUNDRED_PERCENT_1E6 + 1 ) ); },
+    [](uint64_t a, uint64_t b, uint64_t){ return safe_math::muldiv_by<ONE_HUNDRED_PERCENT_1E6>( a, b % ( ONE_HUNDRED_PERCENT_1E6 + 1 ) ); } );
+
+  return same ? 0 : 1;
+}
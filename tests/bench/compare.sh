@@ -0,0 +1,42 @@
+#!/usr/bin/env bash
+# benchmarks the contract at two commits with the same scenarios and compares the reports, e.g.
+#   tests/bench/compare.sh HEAD~1 HEAD
+#   tests/bench/compare.sh f6eac00 299edd1 --repetitions 50 --exclude "memo: other"
+#
+# the harness and scenarios come from the current checkout, only the contract sources are taken from
+# each commit (through FUSION_SOURCE_DIR), so actions an older commit doesn't have fail as unknown actions
+# the reports are left in the current directory as bench-<commit>.json, extra arguments are passed to bench
+
+set -euo pipefail
+
+if [ $# -lt 2 ]; then
+  echo "usage: $0 <before commit> <after commit> [bench arguments]" >&2
+  exit 2
+fi
+
+repo=$(git -C "$(dirname "$0")" rev-parse --show-toplevel)
+before=$(git -C "$repo" rev-parse --short "$1")
+after=$(git -C "$repo" rev-parse --short "$2")
+shift 2
+
+work=$(mktemp -d)
+
+cleanup(){
+  git -C "$repo" worktree remove --force "$work/src-$before" 2>/dev/null || true
+  git -C "$repo" worktree remove --force "$work/src-$after" 2>/dev/null || true
+  rm -rf "$work"
+}
+trap cleanup EXIT
+
+for commit in "$before" "$after"; do
+  git -C "$repo" worktree add --quiet --detach "$work/src-$commit" "$commit"
+  cmake -S "$repo" -B "$work/build-$commit" -DCMAKE_BUILD_TYPE=Release -DFUSION_SOURCE_DIR="$work/src-$commit" > /dev/null
+  cmake --build "$work/build-$commit" -j"$(nproc)" --target bench > /dev/null
+
+  rm -f "bench-$commit.json"
+  #a scenario failing at one of the commits is reported, not fatal
+  "$work/build-$commit/tests/bench/bench" "$@" --output "bench-$commit.json" > /dev/null || true
+  [ -f "bench-$commit.json" ] || { echo "bench did not write a report for $commit" >&2; exit 1; }
+done
+
+"$work/build-$after/tests/bench/bench" --compare "bench-$before.json" "bench-$after.json"
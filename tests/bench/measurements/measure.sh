@@ -0,0 +1,19 @@
+#!/usr/bin/env bash
+# reruns the comparisons the measurements in tests/README.md quote, each into its own directory next to this script:
+# the two bench reports (bench-<commit>.json) and the comparison bench printed (compare.txt)
+#   tests/bench/measurements/measure.sh
+
+set -euo pipefail
+
+here=$(cd "$(dirname "$0")" && pwd)
+
+measure(){
+  local name=$1 before=$2 after=$3
+  mkdir -p "$here/$name"
+  (cd "$here/$name" && "$here/../compare.sh" "$before" "$after" --repetitions 201 --exclude "memo: other" > compare.txt)
+}
+
+#only build error messages when a check fails
+measure user-045 f6eac00 299edd1
+#state/config by reference, std::array epoch lists and an in place get_words
+measure user-046 299edd1 e7edf53
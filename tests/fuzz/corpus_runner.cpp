@@ -0,0 +1,34 @@
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+/**
+* runs fuzz inputs without libFuzzer, for compilers that don't have it
+* every file in the given directories is run, followed by each of its prefixes
+*/
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+int main(int argc, char** argv){
+  std::size_t inputs = 0;
+
+  for( int i = 1; i < argc; i++ ){
+    for( const auto& entry : std::filesystem::directory_iterator( argv[i] ) ){
+      if( !entry.is_regular_file() ) continue;
+
+      std::ifstream file( entry.path(), std::ios::binary );
+      const std::vector<uint8_t> input( ( std::istreambuf_iterator<char>(file) ), std::istreambuf_iterator<char>() );
+
+      for( std::size_t size = input.size(); size > 0; size-- ){
+        LLVMFuzzerTestOneInput( input.data(), size );
+        inputs ++;
+      }
+    }
+  }
+
+  std::printf( "ran %zu inputs\n", inputs );
+  return inputs > 0 ? 0 : 1;
+}
@@ -0,0 +1,180 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "safe_reference.hpp"
+
+/**
+* fuzzes safe_math against the checks safe.cpp used to do (see safe_reference.hpp), and the integer_functions.cpp
+* helpers built on it
+* input: a, b and c as little endian uint64_t, followed by a byte whose low 6 bits shift a and b right,
+* so small operands are reached as often as ones near MAX_ASSET_AMOUNT. missing bytes are 0
+*
+* safe_math
+* - muldiv and mul fail in exactly the cases the reference fails, with the same message
+* - otherwise muldiv rounded down matches the reference, and rounding up adds 1 only when there is a remainder
+* - muldiv_by<ONE_HUNDRED_PERCENT_1E6> matches the reference calculate_asset_share
+* - to_int64 fails exactly when the result is above MAX_ASSET_AMOUNT
+*
+* integer_functions.cpp, with inputs in the range the contract calls them with
+* - calculate_asset_share is the floor of quantity * percentage / 100%, and 100% of a quantity is the quantity
+* - the earning and autocompounding allocations of a distribution add up to the amount, less at most 1 unit
+* - streamed rewards never exceed what is left and never go down as time passes
+* - lsWAX -> sWAX -> lsWAX and sWAX -> lsWAX -> sWAX round trips never create value
+* - rewards paid out per sWAX never add up to more than was streamed
+* - a staker's share of a pool is never more than the pool
+*
+* any disagreement aborts, so libFuzzer and fuzz_math_corpus both report it
+*/
+
+namespace {
+
+  uint64_t read_u64(const uint8_t* data, size_t size, size_t offset){
+    uint8_t bytes[8] = {};
+    if( offset < size ) std::memcpy( bytes, data + offset, std::min<size_t>( 8, size - offset ) );
+
+    uint64_t v = 0;
+    for( int i = 7; i >= 0; i-- ) v = ( v << 8 ) | bytes[i];
+    return v;
+  }
+
+  void require(bool condition, const char* what){
+    if( !condition ){
+      std::fprintf( stderr, "fuzz_math: %s\n", what );
+      std::abort();
+    }
+  }
+
+  /* the message of the check f fails, empty if it succeeds */
+  template<typename F>
+  std::string failure(F&& f){
+    try {
+      f();
+    } catch( const eosio::check_failure& e ){
+      return e.what();
+    }
+    return "";
+  }
+
+}
+
+/* the private math helpers, on a contract object that never touches its tables */
+struct host_math {
+  static fusion& contract(){
+    static fusion f( "dapp.fusion"_n, "dapp.fusion"_n, eosio::datastream<const char*>( nullptr, 0 ) );
+    return f;
+  }
+
+  static int64_t asset_share(int64_t quantity, uint64_t percentage){ return contract().calculate_asset_share( quantity, percentage ); }
+  static int64_t earned_rewards(int64_t user_stake, uint128_t reward_per_swax_delta){ return contract().internal_get_earned_rewards( user_stake, reward_per_swax_delta ); }
+  static uint128_t reward_per_swax(int64_t reward_amount, int64_t total_stake){ return contract().internal_get_reward_per_swax( reward_amount, total_stake ); }
+  static int64_t streamed_rewards(int64_t remaining, uint64_t elapsed, uint64_t duration){ return contract().internal_get_streamed_rewards( remaining, elapsed, duration ); }
+  static int64_t swax_allocation(int64_t amount, int64_t divisor, int64_t supply){ return contract().internal_get_swax_allocations( amount, divisor, supply ); }
+  static int64_t wax_owed_to_user(int64_t user_stake, int64_t total_stake, int64_t pool){ return contract().internal_get_wax_owed_to_user( user_stake, total_stake, pool ); }
+  static int64_t liquify(int64_t quantity, const state& s){ return contract().internal_liquify( quantity, s ); }
+  static int64_t unliquify(int64_t quantity, const state& s){ return contract().internal_unliquify( quantity, s ); }
+};
+
+namespace {
+
+  void check_safe_math(const uint128_t& a, const uint128_t& b, const uint128_t& c){
+    const std::string mul_error = failure( [&]{ safe_math::mul( a, b ); } );
+    require( mul_error == failure( [&]{ reference::safe_mul_u128( a, b ); } ), "mul fails differently from the reference" );
+
+    if( c == 0 ){
+      require( failure( [&]{ safe_math::muldiv( a, b, c ); } ) == "muldiv divisor can not be 0", "muldiv accepted a divisor of 0" );
+    } else if( mul_error.empty() ){
+      const uint128_t down = safe_math::muldiv( a, b, c );
+      const uint128_t up = safe_math::muldiv( a, b, c, safe_math::rounding::up );
+      const uint128_t product = a * b;
+
+      require( down == reference::muldiv( a, b, c ), "muldiv differs from the reference" );
+      require( up == down + ( product % c != 0 ? 1 : 0 ), "rounding up is off" );
+      require( down * c <= product && product - down * c < c, "muldiv is not the floor of a * b / c" );
+
+      const std::string narrowing_error = failure( [&]{ safe_math::to_int64( down ); } );
+      require( narrowing_error.empty() == ( down <= (uint128_t) MAX_ASSET_AMOUNT_U64 ), "to_int64 range check is off" );
+    } else {
+      require( failure( [&]{ safe_math::muldiv( a, b, c ); } ) == mul_error, "muldiv fails differently from mul" );
+    }
+
+    //asset amounts are int64_t, percentages are uint64_t
+    const int64_t quantity = int64_t( a & MAX_ASSET_AMOUNT_U64 );
+    const uint64_t percentage = uint64_t( b );
+    int64_t share = 0;
+    const std::string share_error = failure( [&]{ share = safe_math::to_int64( safe_math::muldiv_by<ONE_HUNDRED_PERCENT_1E6>( (uint128_t) quantity, (uint128_t) percentage ) ); } );
+    if( share_error.empty() ){
+      require( quantity == 0 || share == reference::asset_share( quantity, percentage ), "muldiv_by differs from the reference asset share" );
+    } else if( share_error == "uint128_t multiplication input is outside of range" ){
+      require( failure( [&]{ reference::asset_share( quantity, percentage ); } ) == share_error, "muldiv_by fails where the reference doesn't" );
+    } else {
+      //the reference truncated shares above MAX_ASSET_AMOUNT instead of failing
+      require( quantity != 0 && share_error == "result is outside of the acceptable range", "muldiv_by failed for an unexpected reason" );
+    }
+  }
+
+  void check_integer_functions(const uint128_t& a, const uint128_t& b, const uint128_t& c){
+    const int64_t x = int64_t( a & MAX_ASSET_AMOUNT_U64 );
+    const int64_t y = int64_t( b & MAX_ASSET_AMOUNT_U64 );
+    const int64_t z = int64_t( c & MAX_ASSET_AMOUNT_U64 );
+
+    const uint64_t percentage = uint64_t( b % ( ONE_HUNDRED_PERCENT_1E6 + 1 ) );
+    require( host_math::asset_share( x, percentage ) == int64_t( (uint128_t) x * percentage / ONE_HUNDRED_PERCENT_1E6 ), "calculate_asset_share is not the floor" );
+    require( host_math::asset_share( x, ONE_HUNDRED_PERCENT_1E6 ) == x, "100% of a quantity is not the quantity" );
+
+    //distribute splits the user share between y sWAX earning and z sWAX backing lsWAX
+    if( y <= MAX_ASSET_AMOUNT - z && y + z > 0 ){
+      const int64_t earning = host_math::swax_allocation( x, y, y + z );
+      const int64_t autocompounding = host_math::swax_allocation( x, z, y + z );
+      require( earning <= x - autocompounding && x - autocompounding - earning <= 1, "the allocations don't add up to the amount" );
+    }
+
+    //x left to stream, y seconds into a period of z + 1 seconds
+    const uint64_t duration = uint64_t(z) + 1;
+    const int64_t streamed = host_math::streamed_rewards( x, uint64_t(y), duration );
+    require( streamed <= x, "streamed more than was left" );
+    if( uint64_t(y) < duration ) require( streamed <= host_math::streamed_rewards( x, uint64_t(y) + 1, duration ), "streamed rewards went down" );
+
+    //y lsWAX backed by z sWAX
+    if( y > 0 && z > 0 ){
+      state s{};
+      s.liquified_swax = eosio::asset( y, LSWAX_SYMBOL );
+      s.swax_currently_backing_lswax = eosio::asset( z, SWAX_SYMBOL );
+
+      int64_t lswax = 0;
+      const std::string liquify_error = failure( [&]{ lswax = host_math::liquify( x, s ); } );
+      require( liquify_error.empty() || liquify_error == "result is outside of the acceptable range", "liquify failed for an unexpected reason" );
+      if( liquify_error.empty() ) require( host_math::unliquify( lswax, s ) <= x, "sWAX -> lsWAX -> sWAX created sWAX" );
+
+      int64_t swax = 0;
+      const std::string unliquify_error = failure( [&]{ swax = host_math::unliquify( x, s ); } );
+      require( unliquify_error.empty() || unliquify_error == "result is outside of the acceptable range", "unliquify failed for an unexpected reason" );
+      if( unliquify_error.empty() ) require( host_math::liquify( swax, s ) <= x, "lsWAX -> sWAX -> lsWAX created lsWAX" );
+    }
+
+    //x WAX streamed to y sWAX, all of it paid out to a single staker
+    if( x > 0 && y > 0 ){
+      const uint128_t per_swax = host_math::reward_per_swax( x, y );
+      require( host_math::earned_rewards( y, per_swax ) <= x, "paid out more than was streamed" );
+    }
+
+    //a staker with the smaller of y and z out of the larger, sharing a pool of x
+    if( y > 0 || z > 0 ){
+      require( host_math::wax_owed_to_user( std::min( y, z ), std::max( y, z ), x ) <= x, "a share of the pool is more than the pool" );
+    }
+  }
+
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size){
+  const unsigned shift = size > 24 ? data[24] & 63 : 0;
+  const uint128_t a = read_u64( data, size, 0 ) >> shift;
+  const uint128_t b = read_u64( data, size, 8 ) >> shift;
+  const uint128_t c = read_u64( data, size, 16 );
+
+  check_safe_math( a, b, c );
+  check_integer_functions( a, b, c );
+  return 0;
+}
@@ -0,0 +1,52 @@
+#include "tester.hpp"
+
+/**
+* fuzzes the memo of transfers into dapp.fusion
+* first byte: bit 0 picks the token (WAX or LSWAX), the rest picks the amount (1 to 128 whole tokens)
+* remaining bytes: the memo
+*
+* a failed check is an expected outcome and is reverted like on chain, anything else
+* (another exception type, a sanitizer report, a crash) is a finding
+*/
+
+namespace {
+
+  constexpr eosio::name FUZZER = "fuzzer"_n;
+
+  fusion_tester& tester(){
+    static fusion_tester* t = []{
+      fusion_tester* t = new fusion_tester();
+      t->stake( FUZZER, wax(1000) );
+      t->fund( FUZZER, wax(10000) );
+      t->transfer( WAX_CONTRACT, FUZZER, FUSION, wax(10000), "|stake_liquify|0|" );
+      t->add_revenue( wax(100) );
+      return t;
+    }();
+    return *t;
+  }
+
+}
+
+//failed applies never destroy the contract object, the same way a failed wasm never runs its destructors
+extern "C" const char* __asan_default_options(){ return "detect_leaks=0"; }
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size){
+  if( size == 0 ) return 0;
+
+  fusion_tester& t = tester();
+
+  const bool send_lswax = ( data[0] & 1 ) == 1;
+  const double whole_tokens = 1 + ( data[0] >> 1 );
+  const std::string memo( reinterpret_cast<const char*>( data + 1 ), size - 1 );
+
+  try {
+    if( send_lswax ){
+      t.transfer( TOKEN_CONTRACT, FUZZER, FUSION, lswax(whole_tokens), memo );
+    } else {
+      t.fund( FUZZER, wax(whole_tokens) );
+      t.transfer( WAX_CONTRACT, FUZZER, FUSION, wax(whole_tokens), memo );
+    }
+  } catch( const eosio::check_failure& ){}
+
+  return 0;
+}
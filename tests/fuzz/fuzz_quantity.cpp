@@ -0,0 +1,78 @@
+#include "tester.hpp"
+
+/**
+* fuzzes the quantity of transfers into dapp.fusion over the whole asset range, together with the memo
+* bytes 0-7: the amount, little endian, reduced to 1 to MAX_ASSET_AMOUNT
+* byte 8: bit 0 picks the token (WAX or LSWAX)
+* remaining bytes: the memo
+*
+* fuzz_memo keeps amounts small so its inputs can change the state, this target reaches the range checks and
+* 128-bit math that only large amounts hit (rent_cpu pricing, unliquify_exact, instant_redeem)
+* the sender's balance is written directly, so any amount can be sent without running into the token's
+* max supply, and the transaction always ends in a failing transfer so every input runs against the same state
+*
+* a failed check is an expected outcome, anything else (another exception type, a sanitizer report, a crash) is a finding
+*/
+
+namespace {
+
+  constexpr eosio::name FUZZER = "fuzzer"_n;
+
+  /* a rental pool and lsWAX rate that aren't 1:1, so the large amounts meet real state */
+  fusion_tester& tester(){
+    static fusion_tester* t = []{
+      fusion_tester* t = new fusion_tester();
+      t->stake( FUZZER, wax(100000) );
+      t->fund( FUZZER, wax(10000) );
+      t->transfer( WAX_CONTRACT, FUZZER, FUSION, wax(10000), "|stake_liquify|0|" );
+      t->add_revenue( wax(1000) );
+      t->distribute();
+      return t;
+    }();
+    return *t;
+  }
+
+  /* the fuzzer's balance row, written without going through the token's supply */
+  void set_balance(fusion_tester& t, eosio::name token_contract, const eosio::asset& balance){
+    t.chain.as( token_contract, [&]{
+      ::host::token::accounts acnts( token_contract, FUZZER.value );
+      acnts.modify( acnts.get( balance.symbol.code().raw() ), eosio::same_payer, [&](auto& a){ a.balance = balance; } );
+    });
+  }
+
+  eosio::action transfer_action(eosio::name token_contract, eosio::name from, eosio::name to, const eosio::asset& quantity, const std::string& memo){
+    return eosio::action( eosio::permission_level{ from, "active"_n }, token_contract, "transfer"_n, std::make_tuple( from, to, quantity, memo ) );
+  }
+
+}
+
+//failed applies never destroy the contract object, the same way a failed wasm never runs its destructors
+extern "C" const char* __asan_default_options(){ return "detect_leaks=0"; }
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size){
+  if( size < 9 ) return 0;
+
+  fusion_tester& t = tester();
+
+  uint64_t raw = 0;
+  for( int i = 7; i >= 0; i-- ) raw = ( raw << 8 ) | data[i];
+
+  const bool send_lswax = ( data[8] & 1 ) == 1;
+  const eosio::asset quantity( int64_t( 1 + raw % MAX_ASSET_AMOUNT_U64 ), send_lswax ? LSWAX_SYMBOL : WAX_SYMBOL );
+  const std::string memo( reinterpret_cast<const char*>( data + 9 ), size - 9 );
+
+  const eosio::name token_contract = send_lswax ? TOKEN_CONTRACT : WAX_CONTRACT;
+  const eosio::asset balance = t.balance( token_contract, FUZZER, quantity.symbol );
+  set_balance( t, token_contract, quantity );
+
+  try {
+    t.chain.push_transaction({
+      transfer_action( token_contract, FUZZER, FUSION, quantity, memo ),
+      //reverts the transaction
+      transfer_action( WAX_CONTRACT, FUZZER, SYSTEM_CONTRACT, wax(0), "" )
+    });
+  } catch( const eosio::check_failure& ){}
+
+  set_balance( t, token_contract, balance );
+  return 0;
+}
@@ -0,0 +1,303 @@
+#include "chain.hpp"
+
+#include <algorithm>
+
+namespace host {
+
+  namespace {
+    chain* active_chain = nullptr;
+  }
+
+  chain::chain(){
+    eosio::check( active_chain == nullptr, "only one host chain can exist at a time" );
+    active_chain = this;
+    for( const name account : { "eosio"_n, "eosio.null"_n } ) create_account(account);
+  }
+
+  chain::~chain(){
+    active_chain = nullptr;
+  }
+
+  chain& chain::active(){
+    eosio::check( active_chain != nullptr, "no host chain is running" );
+    return *active_chain;
+  }
+
+  void chain::create_account(name account){
+    _accounts.insert( account.value );
+  }
+
+  bool chain::account_exists(name account) const {
+    return _accounts.count( account.value ) > 0;
+  }
+
+  void chain::deploy(name account, contract_handler handler){
+    create_account(account);
+    _contracts[account.value] = std::move(handler);
+  }
+
+  int64_t chain::ram_usage(name account) const {
+    const auto itr = _db.ram.find( account.value );
+    return itr == _db.ram.end() ? 0 : itr->second;
+  }
+
+  std::map<name, table_size> chain::table_sizes(name code) const {
+    std::map<name, table_size> sizes;
+
+    for( auto t = _db.tables.lower_bound( table_key{ code.value, 0, 0 } ); t != _db.tables.end() && std::get<0>(t->first) == code.value; ++t ){
+      table_size& size = sizes[ name( std::get<2>(t->first) ) ];
+      for( const auto& [primary_key, row] : t->second ){
+        size.rows ++;
+        size.bytes += int64_t( row.data.size() ) + ROW_OVERHEAD_BYTES;
+      }
+    }
+
+    return sizes;
+  }
+
+  void chain::begin_transaction(){
+    _changes.clear();
+    _ram_changes.clear();
+  }
+
+  void chain::revert(){
+    for( auto c = _changes.rbegin(); c != _changes.rend(); ++c ){
+      auto& t = _db.tables[ table_key{ c->code.value, c->scope, c->table.value } ];
+      if( c->before.has_value() ){
+        t[c->primary_key] = *c->before;
+      } else {
+        t.erase( c->primary_key );
+      }
+    }
+
+    for( auto r = _ram_changes.rbegin(); r != _ram_changes.rend(); ++r ) _db.ram[r->first] -= r->second;
+
+    begin_transaction();
+    _contexts.clear();
+  }
+
+  std::vector<action_trace> chain::push_transaction(std::vector<eosio::action> actions){
+    begin_transaction();
+    std::vector<action_trace> traces;
+
+    try {
+      for( const auto& act : actions ){
+        eosio::check( !act.authorization.empty(), "transaction must have at least one authorization" );
+        for( const auto& auth : act.authorization ){
+          eosio::check( account_exists( auth.actor ), "authorizing account does not exist: " + auth.actor.to_string() );
+        }
+        execute( act, 0, traces );
+      }
+    } catch(...) {
+      revert();
+      throw;
+    }
+
+    return traces;
+  }
+
+  std::any chain::run_read_only(const eosio::action& act){
+    begin_transaction();
+    std::vector<action_trace> traces;
+    _read_only = true;
+
+    try {
+      execute( act, 0, traces );
+    } catch(...) {
+      revert();
+      _read_only = false;
+      throw;
+    }
+
+    revert();
+    _read_only = false;
+    return traces.front().return_value;
+  }
+
+  void chain::execute(const eosio::action& act, uint32_t depth, std::vector<action_trace>& traces){
+    eosio::check( account_exists( act.account ), "action's receiving account does not exist: " + act.account.to_string() );
+
+    apply_context ctx{ act.account, act };
+    ctx.notified.push_back( act.account );
+    apply( ctx, traces );
+
+    for( std::size_t i = 1; i < ctx.notified.size(); ++i ){
+      apply_context notify_ctx{ ctx.notified[i], act, true };
+      notify_ctx.notified = ctx.notified;
+      apply( notify_ctx, traces );
+
+      //notified contracts can add recipients and send inline actions of their own
+      for( const name n : notify_ctx.notified ){
+        if( std::find( ctx.notified.begin(), ctx.notified.end(), n ) == ctx.notified.end() ) ctx.notified.push_back(n);
+      }
+      for( auto& inline_act : notify_ctx.inlines ) ctx.inlines.push_back( std::move(inline_act) );
+    }
+
+    if( !ctx.inlines.empty() ){
+      eosio::check( depth < MAX_INLINE_ACTION_DEPTH, "max inline action depth per transaction reached" );
+    }
+
+    const std::vector<eosio::action> inlines = std::move( ctx.inlines );
+    for( const auto& inline_act : inlines ) execute( inline_act, depth + 1, traces );
+  }
+
+  void chain::apply(apply_context& ctx, std::vector<action_trace>& traces){
+    _contexts.push_back(&ctx);
+
+    const auto handler = _contracts.find( ctx.receiver.value );
+    if( handler != _contracts.end() ) handler->second(ctx);
+
+    _contexts.pop_back();
+    traces.push_back( action_trace{ ctx.receiver, ctx.act, ctx.notification, std::move(ctx.return_value) } );
+  }
+
+  apply_context& chain::context(){
+    eosio::check( !_contexts.empty(), "not inside an action" );
+    return *_contexts.back();
+  }
+
+  bool chain::has_auth(name account) const {
+    if( _contexts.empty() ) return false;
+    const auto& auths = _contexts.back()->act.authorization;
+    return std::any_of( auths.begin(), auths.end(), [&](const eosio::permission_level& p){ return p.actor == account; } );
+  }
+
+  const eosio::host::db_rows& chain::rows(name code, uint64_t scope, name table) const {
+    static const eosio::host::db_rows empty;
+    const auto itr = _db.tables.find( table_key{ code.value, scope, table.value } );
+    return itr == _db.tables.end() ? empty : itr->second;
+  }
+
+  void chain::require_writable(){
+    eosio::check( !_contexts.empty(), "tables can only be written from inside an action" );
+    eosio::check( !_read_only, "this API is not allowed in read only action" );
+  }
+
+  void chain::bill(name payer, int64_t delta){
+    _db.ram[payer.value] += delta;
+    _ram_changes.emplace_back( payer.value, delta );
+    if( delta <= 0 || _privileged ) return;
+
+    const apply_context& ctx = context();
+    if( payer == ctx.receiver ) return;
+
+    eosio::check( !ctx.notification, "cannot charge RAM to other accounts during notify" );
+    eosio::check( has_auth(payer), "unprivileged contract cannot increase RAM usage of another account that has not authorized the action: " + payer.to_string() );
+  }
+
+  void chain::store(uint64_t scope, name table, name payer, uint64_t primary_key, std::vector<char> data){
+    require_writable();
+    eosio::check( payer != eosio::same_payer, "must specify a valid account to pay for new record" );
+    eosio::check( account_exists(payer), "account " + payer.to_string() + " does not exist" );
+
+    auto& t = _db.tables[ table_key{ context().receiver.value, scope, table.value } ];
+    eosio::check( !t.count(primary_key), "could not insert object, most likely a uniqueness constraint was violated" );
+
+    _changes.push_back( row_change{ context().receiver, scope, table, primary_key, std::nullopt } );
+    const int64_t size = int64_t( data.size() ) + ROW_OVERHEAD_BYTES;
+    t[primary_key] = eosio::host::db_row{ std::move(data), payer };
+    bill( payer, size );
+  }
+
+  void chain::update(uint64_t scope, name table, name payer, uint64_t primary_key, std::vector<char> data){
+    require_writable();
+
+    auto& t = _db.tables[ table_key{ context().receiver.value, scope, table.value } ];
+    auto row = t.find(primary_key);
+    eosio::check( row != t.end(), "db_update called on a row that does not exist" );
+
+    _changes.push_back( row_change{ context().receiver, scope, table, primary_key, row->second } );
+    const name old_payer = row->second.payer;
+    const name new_payer = payer == eosio::same_payer ? old_payer : payer;
+    const int64_t old_size = int64_t( row->second.data.size() ) + ROW_OVERHEAD_BYTES;
+    const int64_t new_size = int64_t( data.size() ) + ROW_OVERHEAD_BYTES;
+
+    row->second = eosio::host::db_row{ std::move(data), new_payer };
+
+    if( new_payer != old_payer ){
+      bill( old_payer, -old_size );
+      bill( new_payer, new_size );
+    } else {
+      bill( new_payer, new_size - old_size );
+    }
+  }
+
+  void chain::remove(uint64_t scope, name table, uint64_t primary_key){
+    require_writable();
+
+    auto& t = _db.tables[ table_key{ context().receiver.value, scope, table.value } ];
+    auto row = t.find(primary_key);
+    eosio::check( row != t.end(), "db_remove called on a row that does not exist" );
+
+    _changes.push_back( row_change{ context().receiver, scope, table, primary_key, row->second } );
+    const name payer = row->second.payer;
+    const int64_t size = int64_t( row->second.data.size() ) + ROW_OVERHEAD_BYTES;
+    t.erase(row);
+    bill( payer, -size );
+  }
+
+}
+
+namespace eosio::host {
+
+  const db_rows& rows(name code, uint64_t scope, name table){ return ::host::chain::active().rows( code, scope, table ); }
+
+  void store(uint64_t scope, name table, name payer, uint64_t primary_key, std::vector<char> data){
+    ::host::chain::active().store( scope, table, payer, primary_key, std::move(data) );
+  }
+
+  void update(uint64_t scope, name table, name payer, uint64_t primary_key, std::vector<char> data){
+    ::host::chain::active().update( scope, table, payer, primary_key, std::move(data) );
+  }
+
+  void remove(uint64_t scope, name table, uint64_t primary_key){
+    ::host::chain::active().remove( scope, table, primary_key );
+  }
+
+  name current_receiver(){
+    auto& c = ::host::chain::active();
+    return c.has_context() ? c.context().receiver : name();
+  }
+
+  name first_receiver(){ return ::host::chain::active().context().act.account; }
+
+  const std::vector<char>& action_data(){ return ::host::chain::active().context().act.data; }
+
+  bool has_auth(name n){ return ::host::chain::active().has_auth(n); }
+
+  void require_auth(name n){
+    check( ::host::chain::active().has_auth(n), "missing authority of " + n.to_string() );
+  }
+
+  void require_auth(const permission_level& level){
+    const auto& auths = ::host::chain::active().context().act.authorization;
+    check( std::find( auths.begin(), auths.end(), level ) != auths.end(),
+      "missing authority of " + level.actor.to_string() + "/" + level.permission.to_string() );
+  }
+
+  void require_recipient(name n){
+    auto& ctx = ::host::chain::active().context();
+    if( std::find( ctx.notified.begin(), ctx.notified.end(), n ) == ctx.notified.end() ) ctx.notified.push_back(n);
+  }
+
+  bool is_account(name n){ return ::host::chain::active().account_exists(n); }
+
+  void send_inline(name account, name action_name, std::vector<permission_level> authorization, std::vector<char> data){
+    auto& ctx = ::host::chain::active().context();
+    for( const auto& auth : authorization ){
+      check( auth.actor == ctx.receiver, "inline action can only use the authority of the contract sending it, not " + auth.actor.to_string() );
+    }
+
+    action act;
+    act.account = account;
+    act.name = action_name;
+    act.authorization = std::move(authorization);
+    act.data = std::move(data);
+    ctx.inlines.push_back( std::move(act) );
+  }
+
+  time_point current_time(){ return time_point( seconds( ::host::chain::active().now() ) ); }
+
+  void print(std::string_view s){ ::host::chain::active().print(s); }
+
+}
@@ -0,0 +1,170 @@
+#pragma once
+
+/**
+* a minimal single node "chain" for running contracts on the host
+* - each push is one transaction, a failed check reverts every table write made by it
+*   (from an undo log, so reverting doesn't depend on how big the tables are)
+* - inline actions run after the action that sent them (and its notifications), in send order
+* - require_recipient notifications run with the same action, receiver = the notified account
+* - RAM is billed per row payer with the on chain rules: a contract can only bill
+*   another account if that account authorized the action, and never during a notification
+* - time only moves when a test moves it
+*
+* contracts are plain functions that receive an apply_context, see fusion_contract.cpp
+*/
+
+#include <any>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <optional>
+#include <set>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <eosio/eosio.hpp>
+
+namespace host {
+
+  using eosio::name;
+
+  struct apply_context {
+    name                        receiver;
+    const eosio::action&        act;
+    bool                        notification = false;
+    std::vector<name>           notified;
+    std::vector<eosio::action>  inlines;
+    std::any                    return_value;
+  };
+
+  struct action_trace {
+    name            receiver;
+    eosio::action   act;
+    bool            notification = false;
+    std::any        return_value;
+  };
+
+  using contract_handler = std::function<void(apply_context&)>;
+
+  /* a row written by the last transaction, with what it held before (nothing if the transaction created it) */
+  struct row_change {
+    name                                  code;
+    uint64_t                              scope;
+    name                                  table;
+    uint64_t                              primary_key;
+    std::optional<eosio::host::db_row>    before;
+  };
+
+  struct table_size {
+    uint64_t    rows = 0;
+    int64_t     bytes = 0;
+  };
+
+  class chain {
+    public:
+      static constexpr int64_t ROW_OVERHEAD_BYTES = 112;
+      static constexpr uint32_t MAX_INLINE_ACTION_DEPTH = 4;
+
+      chain();
+      ~chain();
+
+      chain(const chain&) = delete;
+      chain& operator=(const chain&) = delete;
+
+      static chain& active();
+
+      void create_account(name account);
+      bool account_exists(name account) const;
+      void deploy(name account, contract_handler handler);
+
+      uint32_t now() const { return _now; }
+      void set_time(uint32_t seconds){ _now = seconds; }
+      void advance(uint32_t seconds){ _now += seconds; }
+
+      std::vector<action_trace> push_transaction(std::vector<eosio::action> actions);
+
+      template<typename... Args>
+      std::vector<action_trace> push(name actor, name contract, name action_name, Args&&... args){
+        return push_transaction({ eosio::action( eosio::permission_level{ actor, eosio::name("active") }, contract, action_name,
+          std::make_tuple( std::forward<Args>(args)... ) ) });
+      }
+
+      /* runs a read only action and reverts anything it touched, returns the action's return value */
+      template<typename Result, typename... Args>
+      Result read_only(name contract, name action_name, Args&&... args){
+        const eosio::action act( std::vector<eosio::permission_level>{}, contract, action_name, std::make_tuple( std::forward<Args>(args)... ) );
+        return std::any_cast<Result>( run_read_only(act) );
+      }
+
+      /* runs f as if it were code in the receiver contract, for seeding tables. RAM isn't restricted */
+      template<typename F>
+      void as(name receiver, F&& f){
+        begin_transaction();
+        const eosio::action act;
+        apply_context ctx{ receiver, act };
+        _contexts.push_back(&ctx);
+        _privileged = true;
+        try {
+          f();
+        } catch(...) {
+          _contexts.pop_back();
+          _privileged = false;
+          throw;
+        }
+        _contexts.pop_back();
+        _privileged = false;
+      }
+
+      int64_t ram_usage(name account) const;
+
+      /* rows and billed bytes of each of code's tables, over every scope */
+      std::map<name, table_size> table_sizes(name code) const;
+
+      /* every row write of the last transaction (or seed), in the order they were made */
+      const std::vector<row_change>& changes() const { return _changes; }
+
+      const std::string& console() const { return _console; }
+      void clear_console(){ _console.clear(); }
+
+      /* intrinsics, called through eosio::host */
+      const eosio::host::db_rows& rows(name code, uint64_t scope, name table) const;
+      void store(uint64_t scope, name table, name payer, uint64_t primary_key, std::vector<char> data);
+      void update(uint64_t scope, name table, name payer, uint64_t primary_key, std::vector<char> data);
+      void remove(uint64_t scope, name table, uint64_t primary_key);
+      apply_context& context();
+      bool has_context() const { return !_contexts.empty(); }
+      bool has_auth(name account) const;
+      void print(std::string_view s){ _console += s; }
+
+    private:
+      using table_key = std::tuple<uint64_t, uint64_t, uint64_t>;
+
+      struct database {
+        std::map<table_key, eosio::host::db_rows> tables;
+        std::map<uint64_t, int64_t> ram;
+      };
+
+      void begin_transaction();
+      void revert();
+      void execute(const eosio::action& act, uint32_t depth, std::vector<action_trace>& traces);
+      void apply(apply_context& ctx, std::vector<action_trace>& traces);
+      void bill(name payer, int64_t delta);
+      void require_writable();
+      std::any run_read_only(const eosio::action& act);
+
+      database _db;
+      //undo log of the last transaction, a failed check replays it backwards
+      std::vector<row_change> _changes;
+      std::vector<std::pair<uint64_t, int64_t>> _ram_changes;
+      std::set<uint64_t> _accounts;
+      std::map<uint64_t, contract_handler> _contracts;
+      std::vector<apply_context*> _contexts;
+      uint32_t _now = 0;
+      bool _read_only = false;
+      bool _privileged = false;
+      std::string _console;
+  };
+
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+/**
+* host stand-in for eosio::action and the authorization intrinsics
+* inline actions are queued on the host chain and run after the current action,
+* in the order they were sent, like on chain
+*/
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "datastream.hpp"
+#include "host.hpp"
+#include "name.hpp"
+
+namespace eosio {
+
+  struct action {
+    eosio::name account;
+    eosio::name name;
+    std::vector<permission_level> authorization;
+    std::vector<char> data;
+
+    action() = default;
+
+    template<typename T>
+    action(const permission_level& auth, eosio::name a, eosio::name n, T&& value)
+      : account(a), name(n), authorization{ auth }, data( pack( std::forward<T>(value) ) ) {}
+
+    template<typename T>
+    action(std::vector<permission_level> auths, eosio::name a, eosio::name n, T&& value)
+      : account(a), name(n), authorization( std::move(auths) ), data( pack( std::forward<T>(value) ) ) {}
+
+    void send() const {
+      host::send_inline( account, name, authorization, data );
+    }
+
+    template<typename T>
+    T data_as() const {
+      return unpack<T>( data );
+    }
+  };
+
+  inline void require_auth(name n){ host::require_auth(n); }
+  inline void require_auth(const permission_level& level){ host::require_auth(level); }
+  inline bool has_auth(name n){ return host::has_auth(n); }
+  inline void require_recipient(name n){ host::require_recipient(n); }
+
+  template<typename... Names>
+  void require_recipient(name n, Names... more){
+    host::require_recipient(n);
+    require_recipient(more...);
+  }
+
+  inline bool is_account(name n){ return host::is_account(n); }
+
+  inline name current_receiver(){ return host::current_receiver(); }
+
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+/**
+* host stand-in for eosio::binary_extension, with the CDT serialization:
+* a missing extension reads as empty, and writing always emits value_or() so
+* re-saving a legacy row makes it grow
+*/
+
+#include <utility>
+
+#include "check.hpp"
+#include "datastream.hpp"
+
+namespace eosio {
+
+  template<typename T>
+  class binary_extension {
+    public:
+      using value_type = T;
+
+      constexpr binary_extension() {}
+      constexpr binary_extension(const T& ext) : _value(ext), _has_value(true) {}
+      constexpr binary_extension(T&& ext) : _value(std::move(ext)), _has_value(true) {}
+
+      constexpr bool has_value() const { return _has_value; }
+
+      constexpr T& value() & {
+        check( _has_value, "cannot get value of empty binary_extension" );
+        return _value;
+      }
+
+      constexpr const T& value() const & {
+        check( _has_value, "cannot get value of empty binary_extension" );
+        return _value;
+      }
+
+      constexpr T value_or() const { return _has_value ? _value : T{}; }
+
+      template<typename U>
+      constexpr T value_or(U&& def) const { return _has_value ? _value : static_cast<T>( std::forward<U>(def) ); }
+
+      constexpr T* operator->(){ return &value(); }
+      constexpr const T* operator->() const { return &value(); }
+      constexpr T& operator*() & { return value(); }
+      constexpr const T& operator*() const & { return value(); }
+
+      template<typename... Args>
+      T& emplace(Args&&... args){
+        _value = T( std::forward<Args>(args)... );
+        _has_value = true;
+        return _value;
+      }
+
+      void reset(){
+        _value = T{};
+        _has_value = false;
+      }
+
+    private:
+      T _value{};
+      bool _has_value = false;
+  };
+
+  template<host_stream DS, typename T>
+  DS& operator<<(DS& ds, const binary_extension<T>& be){
+    ds << be.value_or();
+    return ds;
+  }
+
+  template<host_stream DS, typename T>
+  DS& operator>>(DS& ds, binary_extension<T>& be){
+    if( ds.remaining() ){
+      T val;
+      ds >> val;
+      be.emplace( std::move(val) );
+    }
+    return ds;
+  }
+
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+/**
+* host stand-in for eosio::check
+* on chain a failed check aborts the wasm and reverts the transaction, here it throws
+* check_failure and the host chain (tests/host/chain.cpp) reverts the transaction
+*/
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+namespace eosio {
+
+  struct check_failure : std::runtime_error {
+    using std::runtime_error::runtime_error;
+  };
+
+  [[noreturn]] inline void abort_with(std::string_view msg){
+    throw check_failure( std::string(msg) );
+  }
+
+  inline void check(bool pred, const char* msg){
+    if( !pred ) abort_with(msg);
+  }
+
+  inline void check(bool pred, const std::string& msg){
+    if( !pred ) abort_with(msg);
+  }
+
+  inline void check(bool pred, std::string_view msg){
+    if( !pred ) abort_with(msg);
+  }
+
+  inline void check(bool pred, uint64_t code){
+    if( !pred ) abort_with( "assertion failure with error code: " + std::to_string(code) );
+  }
+
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+/**
+* host stand-in for eosio::contract and the contract attribute macros
+* the attributes are only read by the CDT's ABI generator, the host dispatcher is written
+* by hand in tests/host/fusion_contract.cpp
+*/
+
+#include "datastream.hpp"
+#include "name.hpp"
+
+#define CONTRACT class
+#define ACTION void
+#define TABLE struct
+
+namespace eosio {
+
+  class contract {
+    public:
+      contract(name self, name first_receiver, datastream<const char*> ds) : _self(self), _first_receiver(first_receiver), _ds(ds) {}
+
+      inline name get_self() const { return _self; }
+      inline name get_first_receiver() const { return _first_receiver; }
+      inline datastream<const char*>& get_datastream(){ return _ds; }
+      inline const datastream<const char*>& get_datastream() const { return _ds; }
+
+    protected:
+      name _self;
+      name _first_receiver;
+      datastream<const char*> _ds = datastream<const char*>( nullptr, 0 );
+  };
+
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+/**
+* host stand-ins for the CDT key types, only what table layouts need
+*/
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <variant>
+#include <vector>
+
+#include "datastream.hpp"
+
+namespace eosio {
+
+  using ecc_public_key = std::array<char, 33>;
+
+  struct webauthn_public_key {
+    enum class user_presence_t : uint8_t { USER_PRESENCE_NONE, USER_PRESENCE_PRESENT, USER_PRESENCE_VERIFIED };
+
+    ecc_public_key key;
+    user_presence_t user_presence;
+    std::string rpid;
+  };
+
+  template<host_stream DS> DS& operator<<(DS& ds, const webauthn_public_key& k){ return ds << k.key << uint8_t(k.user_presence) << k.rpid; }
+  template<host_stream DS> DS& operator>>(DS& ds, webauthn_public_key& k){
+    uint8_t presence = 0;
+    ds >> k.key >> presence >> k.rpid;
+    k.user_presence = webauthn_public_key::user_presence_t(presence);
+    return ds;
+  }
+
+  using public_key = std::variant<ecc_public_key, ecc_public_key, webauthn_public_key>;
+
+  struct checksum256 {
+    std::array<uint8_t, 32> hash{};
+
+    friend bool operator==(const checksum256& a, const checksum256& b){ return a.hash == b.hash; }
+  };
+
+}
@@ -0,0 +1,417 @@
+#pragma once
+
+/**
+* host stand-in for the CDT datastream and serialization
+* - EOSLIB_SERIALIZE writes the listed fields in order, like the CDT macro
+* - other aggregates are serialized field by field (the CDT uses boost::pfr for this)
+* - binary_extension fields are handled in binary_extension.hpp
+* rows are stored as bytes, so layout changes behave like they would on chain
+*/
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "asset.hpp"
+#include "check.hpp"
+#include "name.hpp"
+#include "symbol.hpp"
+#include "time.hpp"
+
+namespace eosio {
+
+  template<typename T>
+  class datastream;
+
+  template<>
+  class datastream<const char*> {
+    public:
+      datastream(const char* start, std::size_t s) : _start(start), _pos(start), _end(start + s) {}
+
+      void read(char* d, std::size_t s){
+        check( std::size_t( _end - _pos ) >= s, "datastream attempted to read past the end" );
+        if( s > 0 ) std::memcpy( d, _pos, s );
+        _pos += s;
+      }
+
+      void skip(std::size_t s){
+        check( std::size_t( _end - _pos ) >= s, "datastream attempted to read past the end" );
+        _pos += s;
+      }
+
+      std::size_t remaining() const { return std::size_t( _end - _pos ); }
+      std::size_t tellp() const { return std::size_t( _pos - _start ); }
+      const char* pos() const { return _pos; }
+
+    private:
+      const char* _start;
+      const char* _pos;
+      const char* _end;
+  };
+
+  template<>
+  class datastream<char*> {
+    public:
+      void write(const char* d, std::size_t s){ _buffer.insert( _buffer.end(), d, d + s ); }
+      void put(char c){ _buffer.push_back(c); }
+      std::size_t tellp() const { return _buffer.size(); }
+      std::vector<char>& buffer(){ return _buffer; }
+
+    private:
+      std::vector<char> _buffer;
+  };
+
+  template<typename T> struct is_datastream : std::false_type {};
+  template<> struct is_datastream< datastream<const char*> > : std::true_type {};
+  template<> struct is_datastream< datastream<char*> > : std::true_type {};
+
+  template<typename DS>
+  concept host_stream = is_datastream< std::remove_cvref_t<DS> >::value;
+
+  struct unsigned_int {
+    uint32_t value = 0;
+  };
+
+  /* fixed width numbers and bool */
+
+  template<host_stream DS, typename T> requires std::is_arithmetic_v<T>
+  DS& operator<<(DS& ds, const T& v){
+    ds.write( (const char*) &v, sizeof(T) );
+    return ds;
+  }
+
+  template<host_stream DS, typename T> requires std::is_arithmetic_v<T>
+  DS& operator>>(DS& ds, T& v){
+    ds.read( (char*) &v, sizeof(T) );
+    return ds;
+  }
+
+  template<host_stream DS> DS& operator<<(DS& ds, const unsigned __int128& v){ ds.write( (const char*) &v, sizeof(v) ); return ds; }
+  template<host_stream DS> DS& operator>>(DS& ds, unsigned __int128& v){ ds.read( (char*) &v, sizeof(v) ); return ds; }
+  template<host_stream DS> DS& operator<<(DS& ds, const __int128& v){ ds.write( (const char*) &v, sizeof(v) ); return ds; }
+  template<host_stream DS> DS& operator>>(DS& ds, __int128& v){ ds.read( (char*) &v, sizeof(v) ); return ds; }
+
+  template<host_stream DS>
+  DS& operator<<(DS& ds, const unsigned_int& v){
+    uint64_t val = v.value;
+    do {
+      uint8_t b = uint8_t( val & 0x7f );
+      val >>= 7;
+      b |= ( ( val > 0 ) << 7 );
+      ds.write( (const char*) &b, 1 );
+    } while( val );
+    return ds;
+  }
+
+  template<host_stream DS>
+  DS& operator>>(DS& ds, unsigned_int& v){
+    uint64_t val = 0;
+    char b = 0;
+    uint8_t by = 0;
+    do {
+      ds.read( &b, 1 );
+      val |= uint64_t( uint8_t(b) & 0x7f ) << by;
+      by += 7;
+    } while( uint8_t(b) & 0x80 && by < 32 );
+    v.value = uint32_t(val);
+    return ds;
+  }
+
+  /* eosio types */
+
+  template<host_stream DS> DS& operator<<(DS& ds, const name& v){ return ds << v.value; }
+  template<host_stream DS> DS& operator>>(DS& ds, name& v){ return ds >> v.value; }
+
+  template<host_stream DS> DS& operator<<(DS& ds, const symbol_code& v){ return ds << v.raw(); }
+  template<host_stream DS> DS& operator>>(DS& ds, symbol_code& v){ uint64_t raw = 0; ds >> raw; v = symbol_code(raw); return ds; }
+
+  template<host_stream DS> DS& operator<<(DS& ds, const symbol& v){ return ds << v.raw(); }
+  template<host_stream DS> DS& operator>>(DS& ds, symbol& v){ uint64_t raw = 0; ds >> raw; v = symbol(raw); return ds; }
+
+  template<host_stream DS> DS& operator<<(DS& ds, const asset& v){ return ds << v.amount << v.symbol; }
+  template<host_stream DS> DS& operator>>(DS& ds, asset& v){ return ds >> v.amount >> v.symbol; }
+
+  template<host_stream DS> DS& operator<<(DS& ds, const extended_asset& v){ return ds << v.quantity << v.contract; }
+  template<host_stream DS> DS& operator>>(DS& ds, extended_asset& v){ return ds >> v.quantity >> v.contract; }
+
+  template<host_stream DS> DS& operator<<(DS& ds, const extended_symbol& v){ return ds << v.sym << v.contract; }
+  template<host_stream DS> DS& operator>>(DS& ds, extended_symbol& v){ return ds >> v.sym >> v.contract; }
+
+  template<host_stream DS> DS& operator<<(DS& ds, const microseconds& v){ return ds << v._count; }
+  template<host_stream DS> DS& operator>>(DS& ds, microseconds& v){ return ds >> v._count; }
+
+  template<host_stream DS> DS& operator<<(DS& ds, const time_point& v){ return ds << v.elapsed; }
+  template<host_stream DS> DS& operator>>(DS& ds, time_point& v){ return ds >> v.elapsed; }
+
+  template<host_stream DS> DS& operator<<(DS& ds, const time_point_sec& v){ return ds << v.utc_seconds; }
+  template<host_stream DS> DS& operator>>(DS& ds, time_point_sec& v){ return ds >> v.utc_seconds; }
+
+  /* std containers */
+
+  template<host_stream DS>
+  DS& operator<<(DS& ds, const std::string& v){
+    ds << unsigned_int{ uint32_t( v.size() ) };
+    ds.write( v.data(), v.size() );
+    return ds;
+  }
+
+  template<host_stream DS>
+  DS& operator>>(DS& ds, std::string& v){
+    unsigned_int size;
+    ds >> size;
+    check( size.value <= ds.remaining(), "datastream attempted to read past the end" );
+    v.resize( size.value );
+    ds.read( v.data(), size.value );
+    return ds;
+  }
+
+  template<host_stream DS, typename T>
+  DS& operator<<(DS& ds, const std::vector<T>& v){
+    ds << unsigned_int{ uint32_t( v.size() ) };
+    for( const auto& i : v ) ds << i;
+    return ds;
+  }
+
+  template<host_stream DS, typename T>
+  DS& operator>>(DS& ds, std::vector<T>& v){
+    unsigned_int size;
+    ds >> size;
+    check( size.value <= ds.remaining(), "datastream attempted to read past the end" );
+    v.clear();
+    v.resize( size.value );
+    for( auto& i : v ) ds >> i;
+    return ds;
+  }
+
+  template<host_stream DS, typename T, std::size_t N>
+  DS& operator<<(DS& ds, const std::array<T, N>& v){
+    for( const auto& i : v ) ds << i;
+    return ds;
+  }
+
+  template<host_stream DS, typename T, std::size_t N>
+  DS& operator>>(DS& ds, std::array<T, N>& v){
+    for( auto& i : v ) ds >> i;
+    return ds;
+  }
+
+  template<host_stream DS, typename K, typename V>
+  DS& operator<<(DS& ds, const std::map<K, V>& m){
+    ds << unsigned_int{ uint32_t( m.size() ) };
+    for( const auto& [k, v] : m ) ds << k << v;
+    return ds;
+  }
+
+  template<host_stream DS, typename K, typename V>
+  DS& operator>>(DS& ds, std::map<K, V>& m){
+    unsigned_int size;
+    ds >> size;
+    m.clear();
+    for( uint32_t i = 0; i < size.value; ++i ){
+      K k;
+      V v;
+      ds >> k >> v;
+      m.emplace( std::move(k), std::move(v) );
+    }
+    return ds;
+  }
+
+  template<host_stream DS, typename T>
+  DS& operator<<(DS& ds, const std::optional<T>& v){
+    const bool has = v.has_value();
+    ds << has;
+    if( has ) ds << *v;
+    return ds;
+  }
+
+  template<host_stream DS, typename T>
+  DS& operator>>(DS& ds, std::optional<T>& v){
+    bool has = false;
+    ds >> has;
+    if( has ){
+      T val;
+      ds >> val;
+      v = std::move(val);
+    } else {
+      v.reset();
+    }
+    return ds;
+  }
+
+  template<host_stream DS, typename A, typename B>
+  DS& operator<<(DS& ds, const std::pair<A, B>& v){ return ds << v.first << v.second; }
+
+  template<host_stream DS, typename A, typename B>
+  DS& operator>>(DS& ds, std::pair<A, B>& v){ return ds >> v.first >> v.second; }
+
+  template<host_stream DS, typename... Ts>
+  DS& operator<<(DS& ds, const std::tuple<Ts...>& v){
+    std::apply( [&](const auto&... e){ ( ( ds << e ), ... ); }, v );
+    return ds;
+  }
+
+  template<host_stream DS, typename... Ts>
+  DS& operator>>(DS& ds, std::tuple<Ts...>& v){
+    std::apply( [&](auto&... e){ ( ( ds >> e ), ... ); }, v );
+    return ds;
+  }
+
+  template<host_stream DS, typename... Ts>
+  DS& operator<<(DS& ds, const std::variant<Ts...>& v){
+    ds << unsigned_int{ uint32_t( v.index() ) };
+    std::visit( [&](const auto& e){ ds << e; }, v );
+    return ds;
+  }
+
+  namespace detail {
+    template<std::size_t I, typename DS, typename... Ts>
+    void read_variant(DS& ds, std::variant<Ts...>& v, uint32_t index){
+      if constexpr( I < sizeof...(Ts) ){
+        if( index == I ){
+          std::variant_alternative_t<I, std::variant<Ts...>> e;
+          ds >> e;
+          v.template emplace<I>( std::move(e) );
+        } else {
+          read_variant<I + 1>( ds, v, index );
+        }
+      } else {
+        check( false, "invalid variant index" );
+      }
+    }
+  }
+
+  template<host_stream DS, typename... Ts>
+  DS& operator>>(DS& ds, std::variant<Ts...>& v){
+    unsigned_int index;
+    ds >> index;
+    detail::read_variant<0>( ds, v, index.value );
+    return ds;
+  }
+
+  /* aggregates without EOSLIB_SERIALIZE are serialized field by field */
+
+  namespace detail {
+    struct any_field {
+      template<typename T> operator T() const;
+    };
+
+    template<typename T, std::size_t... I>
+    constexpr bool brace_constructible(std::index_sequence<I...>){
+      return requires { T{ ( (void) I, any_field{} )... }; };
+    }
+
+    template<typename T, std::size_t N = 0>
+    constexpr std::size_t field_count(){
+      if constexpr( brace_constructible<T>( std::make_index_sequence<N + 1>{} ) ) return field_count<T, N + 1>();
+      else return N;
+    }
+
+    #define EOSIO_HOST_TIE(N, ...) \
+      if constexpr( count == N ){ auto& [__VA_ARGS__] = v; return std::tie(__VA_ARGS__); } else
+
+    template<typename T>
+    auto tie_fields(T& v){
+      constexpr std::size_t count = field_count< std::remove_const_t<T> >();
+      static_assert( count > 0 && count <= 24, "too many fields to serialize, add EOSLIB_SERIALIZE" );
+      EOSIO_HOST_TIE(1, f1)
+      EOSIO_HOST_TIE(2, f1, f2)
+      EOSIO_HOST_TIE(3, f1, f2, f3)
+      EOSIO_HOST_TIE(4, f1, f2, f3, f4)
+      EOSIO_HOST_TIE(5, f1, f2, f3, f4, f5)
+      EOSIO_HOST_TIE(6, f1, f2, f3, f4, f5, f6)
+      EOSIO_HOST_TIE(7, f1, f2, f3, f4, f5, f6, f7)
+      EOSIO_HOST_TIE(8, f1, f2, f3, f4, f5, f6, f7, f8)
+      EOSIO_HOST_TIE(9, f1, f2, f3, f4, f5, f6, f7, f8, f9)
+      EOSIO_HOST_TIE(10, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10)
+      EOSIO_HOST_TIE(11, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11)
+      EOSIO_HOST_TIE(12, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12)
+      EOSIO_HOST_TIE(13, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13)
+      EOSIO_HOST_TIE(14, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14)
+      EOSIO_HOST_TIE(15, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15)
+      EOSIO_HOST_TIE(16, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16)
+      EOSIO_HOST_TIE(17, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17)
+      EOSIO_HOST_TIE(18, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18)
+      EOSIO_HOST_TIE(19, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18, f19)
+      EOSIO_HOST_TIE(20, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18, f19, f20)
+      EOSIO_HOST_TIE(21, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18, f19, f20, f21)
+      EOSIO_HOST_TIE(22, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18, f19, f20, f21, f22)
+      EOSIO_HOST_TIE(23, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18, f19, f20, f21, f22, f23)
+      EOSIO_HOST_TIE(24, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18, f19, f20, f21, f22, f23, f24)
+      { return std::tuple<>{}; }
+    }
+
+    #undef EOSIO_HOST_TIE
+  }
+
+  template<typename T>
+  concept reflected_aggregate = std::is_class_v<T> && std::is_aggregate_v<T>;
+
+  template<host_stream DS, reflected_aggregate T>
+  DS& operator<<(DS& ds, const T& v){
+    std::apply( [&](const auto&... f){ ( ( ds << f ), ... ); }, detail::tie_fields(v) );
+    return ds;
+  }
+
+  template<host_stream DS, reflected_aggregate T>
+  DS& operator>>(DS& ds, T& v){
+    std::apply( [&](auto&... f){ ( ( ds >> f ), ... ); }, detail::tie_fields(v) );
+    return ds;
+  }
+
+  template<typename T>
+  std::vector<char> pack(const T& v){
+    datastream<char*> ds;
+    ds << v;
+    return std::move( ds.buffer() );
+  }
+
+  template<typename T>
+  T unpack(const char* data, std::size_t size){
+    T v{};
+    datastream<const char*> ds( data, size );
+    ds >> v;
+    return v;
+  }
+
+  template<typename T>
+  T unpack(const std::vector<char>& data){
+    return unpack<T>( data.data(), data.size() );
+  }
+
+  template<typename T>
+  std::size_t pack_size(const T& v){
+    return pack(v).size();
+  }
+
+}
+
+#define EOSIO_HOST_CAT(a, b) EOSIO_HOST_CAT_I(a, b)
+#define EOSIO_HOST_CAT_I(a, b) a ## b
+
+#define EOSIO_HOST_OUT_A(m) << t.m EOSIO_HOST_OUT_B
+#define EOSIO_HOST_OUT_B(m) << t.m EOSIO_HOST_OUT_A
+#define EOSIO_HOST_OUT_A_END
+#define EOSIO_HOST_OUT_B_END
+
+#define EOSIO_HOST_IN_A(m) >> t.m EOSIO_HOST_IN_B
+#define EOSIO_HOST_IN_B(m) >> t.m EOSIO_HOST_IN_A
+#define EOSIO_HOST_IN_A_END
+#define EOSIO_HOST_IN_B_END
+
+#define EOSLIB_SERIALIZE(TYPE, MEMBERS) \
+  template<typename DataStream> \
+  friend DataStream& operator<<(DataStream& ds, const TYPE& t){ \
+    return ds EOSIO_HOST_CAT(EOSIO_HOST_OUT_A MEMBERS, _END); \
+  } \
+  template<typename DataStream> \
+  friend DataStream& operator>>(DataStream& ds, TYPE& t){ \
+    return ds EOSIO_HOST_CAT(EOSIO_HOST_IN_A MEMBERS, _END); \
+  }
@@ -0,0 +1,25 @@
+#pragma once
+
+/**
+* host stand-ins for the eosio.cdt headers, enough to build the contract for tests
+* see tests/README.md
+*/
+
+#include "action.hpp"
+#include "asset.hpp"
+#include "binary_extension.hpp"
+#include "check.hpp"
+#include "contract.hpp"
+#include "crypto.hpp"
+#include "datastream.hpp"
+#include "host.hpp"
+#include "multi_index.hpp"
+#include "name.hpp"
+#include "print.hpp"
+#include "singleton.hpp"
+#include "symbol.hpp"
+#include "system.hpp"
+#include "time.hpp"
+
+typedef unsigned __int128 uint128_t;
+typedef __int128 int128_t;
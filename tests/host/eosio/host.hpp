@@ -0,0 +1,66 @@
+#pragma once
+
+/**
+* the interface between the stand-in eosio headers and the host chain in tests/host/chain.cpp
+* on chain these are wasm intrinsics
+*/
+
+#include <cstdint>
+#include <map>
+#include <string_view>
+#include <vector>
+
+#include "datastream.hpp"
+#include "name.hpp"
+#include "time.hpp"
+
+namespace eosio {
+
+  struct permission_level {
+    permission_level(name a, name p) : actor(a), permission(p) {}
+    permission_level() {}
+
+    name actor;
+    name permission;
+
+    friend bool operator==(const permission_level& a, const permission_level& b){ return a.actor == b.actor && a.permission == b.permission; }
+  };
+
+  template<host_stream DS> DS& operator<<(DS& ds, const permission_level& p){ return ds << p.actor << p.permission; }
+  template<host_stream DS> DS& operator>>(DS& ds, permission_level& p){ return ds >> p.actor >> p.permission; }
+
+  namespace host {
+
+    struct db_row {
+      std::vector<char> data;
+      name payer;
+    };
+
+    using db_rows = std::map<uint64_t, db_row>;
+
+    /* reads are allowed from any contract's tables */
+    const db_rows& rows(name code, uint64_t scope, name table);
+
+    /* writes go to the tables of the contract that is currently executing */
+    void store(uint64_t scope, name table, name payer, uint64_t primary_key, std::vector<char> data);
+    void update(uint64_t scope, name table, name payer, uint64_t primary_key, std::vector<char> data);
+    void remove(uint64_t scope, name table, uint64_t primary_key);
+
+    name current_receiver();
+    name first_receiver();
+    const std::vector<char>& action_data();
+
+    bool has_auth(name n);
+    void require_auth(name n);
+    void require_auth(const permission_level& level);
+    void require_recipient(name n);
+    bool is_account(name n);
+
+    void send_inline(name account, name action_name, std::vector<permission_level> authorization, std::vector<char> data);
+
+    time_point current_time();
+    void print(std::string_view s);
+
+  }
+
+}
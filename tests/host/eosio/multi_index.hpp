@@ -0,0 +1,389 @@
+#pragma once
+
+/**
+* host stand-in for eosio::multi_index
+* rows live in the host chain as serialized bytes, each table object keeps its own
+* cache of deserialized rows like the CDT does, so iterators and references stay valid
+* until the row is erased
+*
+* secondary indices are rebuilt from the rows when they are used, they are only meant
+* for the small tables tests create
+*/
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "check.hpp"
+#include "datastream.hpp"
+#include "host.hpp"
+#include "name.hpp"
+
+namespace eosio {
+
+  template<name::raw IndexName, typename Extractor>
+  struct indexed_by {
+    static constexpr name index_name = name(IndexName);
+    using extractor_type = Extractor;
+  };
+
+  template<class Class, typename Type, Type (Class::*PtrToMemberFunction)() const>
+  struct const_mem_fun {
+    using result_type = Type;
+
+    Type operator()(const Class& c) const { return (c.*PtrToMemberFunction)(); }
+  };
+
+  template<name::raw TableName, typename T, typename... Indices>
+  class multi_index {
+    public:
+      class const_iterator {
+        public:
+          using value_type = T;
+
+          const_iterator() {}
+          const_iterator(const multi_index* mi, std::optional<uint64_t> pk) : _mi(mi), _pk(pk) {}
+
+          const T& operator*() const {
+            check( _pk.has_value(), "cannot dereference end iterator" );
+            return _mi->load( *_pk );
+          }
+
+          const T* operator->() const { return &**this; }
+
+          const_iterator& operator++(){
+            check( _pk.has_value(), "cannot increment end iterator" );
+            _pk = _mi->next_key( *_pk );
+            return *this;
+          }
+
+          const_iterator operator++(int){
+            const_iterator copy = *this;
+            ++( *this );
+            return copy;
+          }
+
+          const_iterator& operator--(){
+            _pk = _mi->previous_key( _pk );
+            return *this;
+          }
+
+          const_iterator operator--(int){
+            const_iterator copy = *this;
+            --( *this );
+            return copy;
+          }
+
+          friend bool operator==(const const_iterator& a, const const_iterator& b){ return a._mi == b._mi && a._pk == b._pk; }
+          friend bool operator!=(const const_iterator& a, const const_iterator& b){ return !( a == b ); }
+
+          std::optional<uint64_t> primary_key() const { return _pk; }
+
+        private:
+          const multi_index* _mi = nullptr;
+          std::optional<uint64_t> _pk;
+      };
+
+      using iterator = const_iterator;
+
+      template<typename Index>
+      class index {
+        public:
+          using extractor_type = typename Index::extractor_type;
+          using secondary_key_type = std::decay_t<typename extractor_type::result_type>;
+          using entry = std::pair<secondary_key_type, uint64_t>;
+          using entries = std::vector<entry>;
+
+          class const_iterator {
+            public:
+              const_iterator() {}
+              const_iterator(const index* idx, std::shared_ptr<const entries> e, std::size_t pos) : _idx(idx), _entries(std::move(e)), _pos(pos) {}
+
+              const T& operator*() const {
+                check( !is_end(), "cannot dereference end iterator" );
+                return _idx->_mi->load( ( *_entries )[_pos].second );
+              }
+
+              const T* operator->() const { return &**this; }
+
+              const_iterator& operator++(){
+                check( !is_end(), "cannot increment end iterator" );
+                ++_pos;
+                return *this;
+              }
+
+              const_iterator operator++(int){
+                const_iterator copy = *this;
+                ++( *this );
+                return copy;
+              }
+
+              const_iterator& operator--(){
+                check( _pos > 0, "cannot decrement iterator at beginning of index" );
+                --_pos;
+                return *this;
+              }
+
+              bool is_end() const { return !_entries || _pos >= _entries->size(); }
+              uint64_t primary_key() const { return ( *_entries )[_pos].second; }
+
+              friend bool operator==(const const_iterator& a, const const_iterator& b){
+                if( a.is_end() || b.is_end() ) return a.is_end() == b.is_end();
+                return a.primary_key() == b.primary_key();
+              }
+
+              friend bool operator!=(const const_iterator& a, const const_iterator& b){ return !( a == b ); }
+
+            private:
+              const index* _idx = nullptr;
+              std::shared_ptr<const entries> _entries;
+              std::size_t _pos = 0;
+          };
+
+          using iterator = const_iterator;
+
+          explicit index(multi_index* mi) : _mi(mi) {}
+
+          const_iterator begin() const { return const_iterator( this, snapshot(), 0 ); }
+          const_iterator cbegin() const { return begin(); }
+          const_iterator end() const { return const_iterator( this, nullptr, 0 ); }
+          const_iterator cend() const { return end(); }
+
+          const_iterator lower_bound(const secondary_key_type& key) const {
+            auto e = snapshot();
+            const auto itr = std::lower_bound( e->begin(), e->end(), key, [](const entry& a, const secondary_key_type& k){ return a.first < k; } );
+            return const_iterator( this, e, std::size_t( itr - e->begin() ) );
+          }
+
+          const_iterator upper_bound(const secondary_key_type& key) const {
+            auto e = snapshot();
+            const auto itr = std::upper_bound( e->begin(), e->end(), key, [](const secondary_key_type& k, const entry& a){ return k < a.first; } );
+            return const_iterator( this, e, std::size_t( itr - e->begin() ) );
+          }
+
+          const_iterator find(const secondary_key_type& key) const {
+            auto itr = lower_bound(key);
+            if( itr != end() && extractor_type()( *itr ) == key ) return itr;
+            return end();
+          }
+
+          const_iterator require_find(const secondary_key_type& key, const char* error_msg = "unable to find secondary key") const {
+            auto itr = find(key);
+            check( itr != end(), error_msg );
+            return itr;
+          }
+
+          const T& get(const secondary_key_type& key, const char* error_msg = "unable to find secondary key") const {
+            return *require_find( key, error_msg );
+          }
+
+          template<typename Lambda>
+          void modify(const const_iterator& itr, name payer, Lambda&& updater){
+            check( !itr.is_end(), "cannot pass end iterator to modify" );
+            _mi->modify( _mi->find( itr.primary_key() ), payer, std::forward<Lambda>(updater) );
+          }
+
+          const_iterator erase(const_iterator itr){
+            check( !itr.is_end(), "cannot pass end iterator to erase" );
+            const uint64_t pk = itr.primary_key();
+            ++itr;
+            _mi->erase( _mi->find(pk) );
+            return itr;
+          }
+
+        private:
+          std::shared_ptr<const entries> snapshot() const {
+            auto e = std::make_shared<entries>();
+            for( auto itr = _mi->begin(); itr != _mi->end(); ++itr ){
+              e->emplace_back( extractor_type()( *itr ), itr->primary_key() );
+            }
+            std::sort( e->begin(), e->end(), [](const entry& a, const entry& b){
+              if( a.first < b.first ) return true;
+              if( b.first < a.first ) return false;
+              return a.second < b.second;
+            });
+            return e;
+          }
+
+          multi_index* _mi;
+      };
+
+      multi_index(name code, uint64_t scope) : _code(code), _scope(scope) {}
+
+      multi_index(const multi_index&) = delete;
+      multi_index& operator=(const multi_index&) = delete;
+
+      name get_code() const { return _code; }
+      uint64_t get_scope() const { return _scope; }
+
+      const_iterator begin() const {
+        const auto& r = rows();
+        return r.empty() ? end() : const_iterator( this, r.begin()->first );
+      }
+
+      const_iterator cbegin() const { return begin(); }
+      const_iterator end() const { return const_iterator( this, std::nullopt ); }
+      const_iterator cend() const { return end(); }
+
+      const_iterator find(uint64_t primary) const {
+        const auto& r = rows();
+        return r.count(primary) ? const_iterator( this, primary ) : end();
+      }
+
+      const_iterator require_find(uint64_t primary, const char* error_msg = "unable to find key") const {
+        auto itr = find(primary);
+        check( itr != end(), error_msg );
+        return itr;
+      }
+
+      const T& get(uint64_t primary, const char* error_msg = "unable to find key") const {
+        return *require_find( primary, error_msg );
+      }
+
+      const_iterator lower_bound(uint64_t primary) const {
+        const auto& r = rows();
+        const auto itr = r.lower_bound(primary);
+        return itr == r.end() ? end() : const_iterator( this, itr->first );
+      }
+
+      const_iterator upper_bound(uint64_t primary) const {
+        const auto& r = rows();
+        const auto itr = r.upper_bound(primary);
+        return itr == r.end() ? end() : const_iterator( this, itr->first );
+      }
+
+      uint64_t available_primary_key() const {
+        const auto& r = rows();
+        if( r.empty() ) return 0;
+        check( r.rbegin()->first < UINT64_MAX - 1, "next primary key in table is at autoincrement limit" );
+        return r.rbegin()->first + 1;
+      }
+
+      template<name::raw IndexName>
+      auto get_index(){
+        using found = typename find_index<IndexName, Indices...>::type;
+        static_assert( !std::is_void_v<found>, "name provided is not the name of any secondary index within multi_index" );
+        return index<found>( this );
+      }
+
+      template<typename Lambda>
+      const_iterator emplace(name payer, Lambda&& constructor){
+        check( _code == host::current_receiver(), "cannot create objects in table of another contract" );
+
+        auto obj = std::make_unique<T>();
+        constructor( *obj );
+        const uint64_t pk = obj->primary_key();
+
+        check( !rows().count(pk), "could not insert object, most likely a uniqueness constraint was violated" );
+        host::store( _scope, table_name(), payer, pk, pack( *obj ) );
+        _cache[pk] = std::move(obj);
+
+        return const_iterator( this, pk );
+      }
+
+      template<typename Lambda>
+      void modify(const const_iterator& itr, name payer, Lambda&& updater){
+        check( itr != end(), "cannot pass end iterator to modify" );
+        modify_key( *itr.primary_key(), payer, std::forward<Lambda>(updater) );
+      }
+
+      template<typename Lambda>
+      void modify(const T& obj, name payer, Lambda&& updater){
+        modify_key( obj.primary_key(), payer, std::forward<Lambda>(updater) );
+      }
+
+      const_iterator erase(const_iterator itr){
+        check( itr != end(), "cannot pass end iterator to erase" );
+        const uint64_t pk = *itr.primary_key();
+        ++itr;
+        erase_key(pk);
+        return itr;
+      }
+
+      void erase(const T& obj){
+        erase_key( obj.primary_key() );
+      }
+
+    private:
+      template<name::raw IndexName, typename... Is>
+      struct find_index { using type = void; };
+
+      template<name::raw IndexName, typename I, typename... Is>
+      struct find_index<IndexName, I, Is...> {
+        using type = std::conditional_t< I::index_name == name(IndexName), I, typename find_index<IndexName, Is...>::type >;
+      };
+
+      static constexpr name table_name(){ return name(TableName); }
+
+      const host::db_rows& rows() const { return host::rows( _code, _scope, table_name() ); }
+
+      const T& load(uint64_t pk) const {
+        auto cached = _cache.find(pk);
+        if( cached != _cache.end() ) return *cached->second;
+
+        const auto& r = rows();
+        const auto row = r.find(pk);
+        check( row != r.end(), "unable to find key" );
+
+        auto obj = std::make_unique<T>();
+        datastream<const char*> ds( row->second.data.data(), row->second.data.size() );
+        ds >> *obj;
+
+        const T& result = *obj;
+        _cache[pk] = std::move(obj);
+        return result;
+      }
+
+      std::optional<uint64_t> next_key(uint64_t pk) const {
+        const auto& r = rows();
+        const auto itr = r.upper_bound(pk);
+        if( itr == r.end() ) return std::nullopt;
+        return itr->first;
+      }
+
+      std::optional<uint64_t> previous_key(std::optional<uint64_t> pk) const {
+        const auto& r = rows();
+
+        if( !pk.has_value() ){
+          check( !r.empty(), "cannot decrement end iterator when the table is empty" );
+          return r.rbegin()->first;
+        }
+
+        auto itr = r.lower_bound(*pk);
+        check( itr != r.begin(), "cannot decrement iterator at beginning of table" );
+        --itr;
+        return itr->first;
+      }
+
+      template<typename Lambda>
+      void modify_key(uint64_t pk, name payer, Lambda&& updater){
+        check( _code == host::current_receiver(), "cannot modify objects in table of another contract" );
+
+        T& obj = const_cast<T&>( load(pk) );
+        updater( obj );
+
+        check( obj.primary_key() == pk, "updater cannot change primary key when modifying an object" );
+        host::update( _scope, table_name(), payer, pk, pack( obj ) );
+      }
+
+      void erase_key(uint64_t pk){
+        check( _code == host::current_receiver(), "cannot erase objects in table of another contract" );
+        check( rows().count(pk), "attempt to remove object that was not in multi_index" );
+
+        host::remove( _scope, table_name(), pk );
+        _cache.erase(pk);
+      }
+
+      name _code;
+      uint64_t _scope;
+      mutable std::map<uint64_t, std::unique_ptr<T>> _cache;
+  };
+
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+/**
+* host stand-in for eosio::print, output goes to the host chain's console buffer
+*/
+
+#include <string>
+#include <type_traits>
+
+#include "asset.hpp"
+#include "host.hpp"
+#include "name.hpp"
+#include "symbol.hpp"
+
+namespace eosio {
+
+  inline void print_one(const char* s){ host::print(s); }
+  inline void print_one(const std::string& s){ host::print(s); }
+  inline void print_one(std::string_view s){ host::print(s); }
+  inline void print_one(const name& n){ host::print( n.to_string() ); }
+  inline void print_one(const symbol& s){ host::print( s.to_string() ); }
+  inline void print_one(const asset& a){ host::print( a.to_string() ); }
+  inline void print_one(bool b){ host::print( b ? "true" : "false" ); }
+
+  template<typename T> requires std::is_arithmetic_v<T>
+  void print_one(T v){ host::print( std::to_string(v) ); }
+
+  template<typename... Args>
+  void print(Args&&... args){
+    ( print_one( std::forward<Args>(args) ), ... );
+  }
+
+}
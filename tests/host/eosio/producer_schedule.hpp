@@ -0,0 +1,32 @@
+#pragma once
+
+/**
+* host stand-ins for the CDT producer authority types
+*/
+
+#include <variant>
+#include <vector>
+
+#include "crypto.hpp"
+#include "name.hpp"
+
+namespace eosio {
+
+  struct key_weight {
+    public_key key;
+    uint16_t weight;
+  };
+
+  struct block_signing_authority_v0 {
+    uint32_t threshold = 0;
+    std::vector<key_weight> keys;
+  };
+
+  using block_signing_authority = std::variant<block_signing_authority_v0>;
+
+  struct producer_authority {
+    name producer_name;
+    block_signing_authority authority;
+  };
+
+}
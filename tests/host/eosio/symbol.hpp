@@ -0,0 +1,108 @@
+#pragma once
+
+/**
+* host stand-ins for eosio::symbol_code and eosio::symbol, same raw encoding as the CDT
+*/
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "check.hpp"
+#include "name.hpp"
+
+namespace eosio {
+
+  class symbol_code {
+    public:
+      constexpr symbol_code() : value(0) {}
+      constexpr explicit symbol_code(uint64_t raw) : value(raw) {}
+
+      constexpr explicit symbol_code(std::string_view str) : value(0) {
+        if( str.size() > 7 ) abort_with("string is too long to be a valid symbol_code");
+        for( auto itr = str.rbegin(); itr != str.rend(); ++itr ){
+          if( *itr < 'A' || *itr > 'Z' ) abort_with("only uppercase letters allowed in symbol_code string");
+          value <<= 8;
+          value |= *itr;
+        }
+      }
+
+      constexpr bool is_valid() const {
+        uint64_t sym = value;
+        for( int i = 0; i < 7; ++i ){
+          const char c = (char)( sym & 0xFF );
+          if( !( 'A' <= c && c <= 'Z' ) ) return false;
+          sym >>= 8;
+          if( !( sym & 0xFF ) ){
+            do {
+              sym >>= 8;
+              if( ( sym & 0xFF ) ) return false;
+              ++i;
+            } while( i < 7 );
+          }
+        }
+        return true;
+      }
+
+      constexpr uint64_t raw() const { return value; }
+      constexpr explicit operator bool() const { return value != 0; }
+
+      std::string to_string() const {
+        std::string s;
+        uint64_t v = value;
+        while( v > 0 ){
+          s += (char)( v & 0xFF );
+          v >>= 8;
+        }
+        return s;
+      }
+
+      friend constexpr bool operator==(const symbol_code& a, const symbol_code& b){ return a.value == b.value; }
+      friend constexpr bool operator!=(const symbol_code& a, const symbol_code& b){ return a.value != b.value; }
+      friend constexpr bool operator<(const symbol_code& a, const symbol_code& b){ return a.value < b.value; }
+
+    private:
+      uint64_t value;
+  };
+
+  class symbol {
+    public:
+      constexpr symbol() : value(0) {}
+      constexpr explicit symbol(uint64_t raw) : value(raw) {}
+      constexpr symbol(symbol_code sc, uint8_t precision) : value( ( sc.raw() << 8 ) | (uint64_t) precision ) {}
+      constexpr symbol(std::string_view ss, uint8_t precision) : value( ( symbol_code(ss).raw() << 8 ) | (uint64_t) precision ) {}
+
+      constexpr bool is_valid() const { return code().is_valid(); }
+      constexpr uint8_t precision() const { return value & 0xFFull; }
+      constexpr symbol_code code() const { return symbol_code( value >> 8 ); }
+      constexpr uint64_t raw() const { return value; }
+      constexpr explicit operator bool() const { return value != 0; }
+
+      std::string to_string() const {
+        return std::to_string( precision() ) + "," + code().to_string();
+      }
+
+      friend constexpr bool operator==(const symbol& a, const symbol& b){ return a.value == b.value; }
+      friend constexpr bool operator!=(const symbol& a, const symbol& b){ return a.value != b.value; }
+      friend constexpr bool operator<(const symbol& a, const symbol& b){ return a.value < b.value; }
+
+    private:
+      uint64_t value;
+  };
+
+  class extended_symbol {
+    public:
+      constexpr extended_symbol() {}
+      constexpr extended_symbol(symbol s, name con) : sym(s), contract(con) {}
+
+      constexpr symbol get_symbol() const { return sym; }
+      constexpr name get_contract() const { return contract; }
+
+      friend constexpr bool operator==(const extended_symbol& a, const extended_symbol& b){ return a.sym == b.sym && a.contract == b.contract; }
+      friend constexpr bool operator!=(const extended_symbol& a, const extended_symbol& b){ return !( a == b ); }
+
+      symbol sym;
+      name contract;
+  };
+
+}
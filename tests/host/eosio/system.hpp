@@ -0,0 +1,12 @@
+#pragma once
+
+#include "host.hpp"
+#include "time.hpp"
+
+namespace eosio {
+
+  inline time_point current_time_point(){ return host::current_time(); }
+
+  inline time_point_sec current_block_time(){ return time_point_sec( host::current_time() ); }
+
+}
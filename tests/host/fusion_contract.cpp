@@ -0,0 +1,146 @@
+#include "fusion.cpp"
+
+#include <new>
+
+#include "fusion_contract.hpp"
+
+/**
+* hand written version of the dispatcher eosio-cpp generates for fusion
+* each apply gets a fresh contract object and fresh statics, like a fresh wasm instance
+* fusion.cpp comes from FUSION_SOURCE_DIR, actions that don't exist in those sources fail like an unknown action
+*/
+
+namespace {
+
+  using dispatch_fn = void (*)(fusion&, ::host::apply_context&);
+
+  template<typename Result, typename... Args>
+  void call(fusion& contract, Result (fusion::*method)(Args...), ::host::apply_context& ctx){
+    using args_tuple = std::tuple< std::decay_t<Args>... >;
+
+    eosio::datastream<const char*> ds( ctx.act.data.data(), ctx.act.data.size() );
+    args_tuple args;
+    ds >> args;
+    eosio::check( ds.remaining() == 0, "action data for " + ctx.act.name.to_string() + " has trailing bytes" );
+
+    if constexpr( std::is_void_v<Result> ){
+      std::apply( [&](auto&... a){ ( contract.*method )( a... ); }, args );
+    } else {
+      ctx.return_value = std::apply( [&](auto&... a){ return ( contract.*method )( a... ); }, args );
+    }
+  }
+
+  #define FUSION_ACTION(action_name) \
+    { eosio::name( #action_name ).value, []<typename Contract>(Contract& f, ::host::apply_context& ctx){ \
+      if constexpr( requires { &Contract::action_name; } ) call( f, &Contract::action_name, ctx ); \
+      else eosio::check( false, "unknown action " #action_name ); \
+    } }
+
+  const std::map<uint64_t, dispatch_fn>& fusion_actions(){
+    static const std::map<uint64_t, dispatch_fn> actions = {
+#if INSTRUMENT
+      FUSION_ACTION(getstats),
+#endif
+      FUSION_ACTION(addadmin),
+      FUSION_ACTION(addcpucntrct),
+      FUSION_ACTION(claimaslswax),
+      FUSION_ACTION(claimgbmvote),
+      FUSION_ACTION(claimrefunds),
+      FUSION_ACTION(claimrewards),
+      FUSION_ACTION(claimswax),
+      FUSION_ACTION(clearsnaps),
+      FUSION_ACTION(clearexpired),
+      FUSION_ACTION(createfarms),
+      FUSION_ACTION(distribute),
+      FUSION_ACTION(getapr),
+      FUSION_ACTION(getdashboard),
+      FUSION_ACTION(getposition),
+      FUSION_ACTION(getrates),
+      FUSION_ACTION(initconfig),
+      FUSION_ACTION(initconfig3),
+      FUSION_ACTION(initrewards),
+      FUSION_ACTION(initsettle),
+      FUSION_ACTION(initstate2),
+      FUSION_ACTION(initstate3),
+      FUSION_ACTION(inittop21),
+      FUSION_ACTION(instaredeem),
+      FUSION_ACTION(liquify),
+      FUSION_ACTION(liquifyexact),
+      FUSION_ACTION(migratesnaps),
+      FUSION_ACTION(payroutes),
+      FUSION_ACTION(prunesnaps),
+      FUSION_ACTION(quoteclaim),
+      FUSION_ACTION(quoteinsta),
+      FUSION_ACTION(quoteliquify),
+      FUSION_ACTION(quoteredeem),
+      FUSION_ACTION(quoteunliq),
+      FUSION_ACTION(reallocate),
+      FUSION_ACTION(redeem),
+      FUSION_ACTION(removeadmin),
+      FUSION_ACTION(reqredeem),
+      FUSION_ACTION(rmvcpucntrct),
+      FUSION_ACTION(rmvincentive),
+      FUSION_ACTION(scanstakers),
+      FUSION_ACTION(setfallback),
+      FUSION_ACTION(setincentive),
+      FUSION_ACTION(setpolshare),
+      FUSION_ACTION(setrentprice),
+      FUSION_ACTION(setroute),
+      FUSION_ACTION(setsnaptiers),
+      FUSION_ACTION(setsettleint),
+      FUSION_ACTION(settle),
+      FUSION_ACTION(stake),
+      FUSION_ACTION(stakeallcpu),
+      FUSION_ACTION(sweepstakers),
+      FUSION_ACTION(sync),
+      FUSION_ACTION(synctvl),
+      FUSION_ACTION(unstakecpu),
+      FUSION_ACTION(updatetop21)
+    };
+    return actions;
+  }
+
+  #undef FUSION_ACTION
+
+  void reset_statics(){
+    //sources from before invariants.hpp keep the action name in instrument_counts
+#if defined(INVARIANTS) && ( INSTRUMENT || INVARIANTS )
+    current_action() = eosio::name();
+#endif
+#if INSTRUMENT
+    instrument_counts() = action_counts{};
+#endif
+#if INVARIANTS
+    invariant_deltas() = inline_deltas{};
+#endif
+  }
+
+  void apply_fusion(::host::apply_context& ctx){
+    reset_statics();
+
+    //a failed check aborts the wasm before the contract is destroyed, so the destructor
+    //(and the INVARIANTS/INSTRUMENT work in it) only runs when the action succeeded
+    alignas(fusion) unsigned char storage[ sizeof(fusion) ];
+    fusion* contract = new (storage) fusion( ctx.receiver, ctx.act.account, eosio::datastream<const char*>( ctx.act.data.data(), ctx.act.data.size() ) );
+
+    if( ctx.receiver == ctx.act.account ){
+      const auto& actions = fusion_actions();
+      const auto itr = actions.find( ctx.act.name.value );
+      eosio::check( itr != actions.end(), "unknown action " + ctx.act.name.to_string() );
+      itr->second( *contract, ctx );
+    } else if( ctx.act.name == "transfer"_n ){
+      call( *contract, &fusion::receive_token_transfer, ctx );
+    }
+
+    contract->~fusion();
+  }
+
+}
+
+namespace host {
+
+  void deploy_fusion(chain& c, eosio::name account){
+    c.deploy( account, apply_fusion );
+  }
+
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+/**
+* the fusion contract built for the host chain
+* link fusion_host (or fusion_host_invariants for a build with -DINVARIANTS=true)
+*/
+
+#include "chain.hpp"
+
+namespace host {
+
+  void deploy_fusion(chain& c, eosio::name account);
+
+}
@@ -0,0 +1,189 @@
+#include "standins.hpp"
+
+namespace host {
+
+  namespace token {
+
+    namespace {
+
+      void sub_balance(eosio::name self, eosio::name owner, const eosio::asset& value){
+        accounts from_acnts( self, owner.value );
+        const auto& from = from_acnts.get( value.symbol.code().raw(), "no balance object found" );
+        eosio::check( from.balance.amount >= value.amount, "overdrawn balance" );
+
+        from_acnts.modify( from, owner, [&](auto& a){
+          a.balance -= value;
+        });
+      }
+
+      void add_balance(eosio::name self, eosio::name owner, const eosio::asset& value, eosio::name ram_payer){
+        accounts to_acnts( self, owner.value );
+        auto to = to_acnts.find( value.symbol.code().raw() );
+
+        if( to == to_acnts.end() ){
+          to_acnts.emplace( ram_payer, [&](auto& a){
+            a.balance = value;
+          });
+        } else {
+          to_acnts.modify( to, eosio::same_payer, [&](auto& a){
+            a.balance += value;
+          });
+        }
+      }
+
+      const currency_stats& existing_stats(stats& statstable, const eosio::asset& quantity){
+        eosio::check( quantity.symbol.is_valid(), "invalid symbol name" );
+        const auto& st = statstable.get( quantity.symbol.code().raw(), "token with symbol does not exist" );
+        eosio::check( quantity.is_valid(), "invalid quantity" );
+        eosio::check( quantity.symbol == st.supply.symbol, "symbol precision mismatch" );
+        return st;
+      }
+
+      void create(eosio::name self, eosio::name issuer, const eosio::asset& maximum_supply){
+        eosio::require_auth(self);
+        eosio::check( maximum_supply.is_valid(), "invalid supply" );
+        eosio::check( maximum_supply.amount > 0, "max-supply must be positive" );
+
+        stats statstable( self, maximum_supply.symbol.code().raw() );
+        eosio::check( statstable.find( maximum_supply.symbol.code().raw() ) == statstable.end(), "token with symbol already exists" );
+
+        statstable.emplace( self, [&](auto& s){
+          s.supply = eosio::asset( 0, maximum_supply.symbol );
+          s.max_supply = maximum_supply;
+          s.issuer = issuer;
+        });
+      }
+
+      void issue(eosio::name self, eosio::name to, const eosio::asset& quantity, const std::string& memo, flavour f){
+        eosio::check( memo.size() <= 256, "memo has more than 256 bytes" );
+
+        stats statstable( self, quantity.symbol.code().raw() );
+        const auto& st = existing_stats( statstable, quantity );
+
+        eosio::require_auth( st.issuer );
+        if( f == flavour::eosio_token ) eosio::check( to == st.issuer, "tokens can only be issued to issuer account" );
+        eosio::check( quantity.amount > 0, "must issue positive quantity" );
+        eosio::check( quantity.amount <= st.max_supply.amount - st.supply.amount, "quantity exceeds available supply" );
+
+        statstable.modify( st, eosio::same_payer, [&](auto& s){
+          s.supply += quantity;
+        });
+
+        add_balance( self, to, quantity, st.issuer );
+      }
+
+      void retire(eosio::name self, eosio::name owner, const eosio::asset& quantity, const std::string& memo){
+        eosio::check( memo.size() <= 256, "memo has more than 256 bytes" );
+
+        stats statstable( self, quantity.symbol.code().raw() );
+        const auto& st = existing_stats( statstable, quantity );
+
+        eosio::require_auth( owner );
+        eosio::check( owner == st.issuer, "only the issuer can retire" );
+        eosio::check( quantity.amount > 0, "must retire positive quantity" );
+
+        statstable.modify( st, eosio::same_payer, [&](auto& s){
+          s.supply -= quantity;
+        });
+
+        sub_balance( self, owner, quantity );
+      }
+
+      void transfer(eosio::name self, eosio::name from, eosio::name to, const eosio::asset& quantity, const std::string& memo){
+        eosio::check( from != to, "cannot transfer to self" );
+        eosio::require_auth( from );
+        eosio::check( eosio::is_account( to ), "to account does not exist" );
+
+        stats statstable( self, quantity.symbol.code().raw() );
+        existing_stats( statstable, quantity );
+
+        eosio::require_recipient( from );
+        eosio::require_recipient( to );
+
+        eosio::check( quantity.amount > 0, "must transfer positive quantity" );
+        eosio::check( memo.size() <= 256, "memo has more than 256 bytes" );
+
+        const eosio::name payer = eosio::has_auth( to ) ? to : from;
+        sub_balance( self, from, quantity );
+        add_balance( self, to, quantity, payer );
+      }
+
+    }
+
+    eosio::asset balance(eosio::name token_contract, eosio::name owner, eosio::symbol sym){
+      accounts acnts( token_contract, owner.value );
+      auto itr = acnts.find( sym.code().raw() );
+      return itr == acnts.end() ? eosio::asset( 0, sym ) : itr->balance;
+    }
+
+    eosio::asset supply(eosio::name token_contract, eosio::symbol sym){
+      stats statstable( token_contract, sym.code().raw() );
+      auto itr = statstable.find( sym.code().raw() );
+      return itr == statstable.end() ? eosio::asset( 0, sym ) : itr->supply;
+    }
+
+  }
+
+  void deploy_token(chain& c, eosio::name account, token::flavour f){
+    c.deploy( account, [f](apply_context& ctx){
+      if( ctx.receiver != ctx.act.account ) return;
+
+      const eosio::name self = ctx.receiver;
+      const eosio::name act = ctx.act.name;
+
+      if( act == "create"_n ){
+        const auto [issuer, maximum_supply] = ctx.act.data_as<std::tuple<eosio::name, eosio::asset>>();
+        token::create( self, issuer, maximum_supply );
+      } else if( act == "transfer"_n ){
+        const auto [from, to, quantity, memo] = ctx.act.data_as<std::tuple<eosio::name, eosio::name, eosio::asset, std::string>>();
+        token::transfer( self, from, to, quantity, memo );
+      } else if( act == "issue"_n && f == token::flavour::eosio_token ){
+        const auto [to, quantity, memo] = ctx.act.data_as<std::tuple<eosio::name, eosio::asset, std::string>>();
+        token::issue( self, to, quantity, memo, f );
+      } else if( act == "issue"_n ){
+        const auto [issuer, to, quantity, memo] = ctx.act.data_as<std::tuple<eosio::name, eosio::name, eosio::asset, std::string>>();
+        eosio::require_auth( issuer );
+        token::issue( self, to, quantity, memo, f );
+      } else if( act == "retire"_n && f == token::flavour::eosio_token ){
+        const auto [quantity, memo] = ctx.act.data_as<std::tuple<eosio::asset, std::string>>();
+        token::stats statstable( self, quantity.symbol.code().raw() );
+        token::retire( self, statstable.get( quantity.symbol.code().raw(), "token with symbol does not exist" ).issuer, quantity, memo );
+      } else if( act == "retire"_n ){
+        const auto [owner, quantity, memo] = ctx.act.data_as<std::tuple<eosio::name, eosio::asset, std::string>>();
+        token::retire( self, owner, quantity, memo );
+      } else {
+        eosio::check( false, "unknown action " + act.to_string() + " on " + self.to_string() );
+      }
+    });
+  }
+
+  void deploy_alcor(chain& c, eosio::name account){
+    c.deploy( account, [](apply_context& ctx){
+      if( ctx.receiver != ctx.act.account || ctx.act.name != "newincentive"_n ) return;
+
+      const auto args = ctx.act.data_as<std::tuple<eosio::name, uint64_t, eosio::extended_asset, uint32_t>>();
+      const eosio::name creator = std::get<0>(args);
+      eosio::require_auth( creator );
+
+      alcor::incentives_table incentives_t( ctx.receiver, ctx.receiver.value );
+      incentives_t.emplace( creator, [&](auto& i){
+        i.id = incentives_t.available_primary_key();
+        i.creator = creator;
+        i.poolId = std::get<1>(args);
+        i.reward = std::get<2>(args);
+        i.periodFinish = 0;
+        i.rewardsDuration = std::get<3>(args);
+        i.rewardRateE18 = 0;
+        i.rewardPerTokenStored = 0;
+        i.totalStakingWeight = 0;
+        i.lastUpdateTime = 0;
+        i.numberOfStakes = 0;
+      });
+    });
+  }
+
+  void deploy_passive(chain& c, eosio::name account){
+    c.deploy( account, [](apply_context&){} );
+  }
+
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+/**
+* host versions of the contracts fusion talks to
+* - token: eosio.token (issue to the issuer, then transfer) or token.fusion, which lets its
+*   issuer issue straight to any account and retire from its own balance, matching the
+*   issue/retire calls fusion makes
+* - alcor: only newincentive, which adds an incentives row like swap.alcor does
+* - passive: accepts any action and ignores it (pol.fusion, the cpu contracts, the system contract)
+*/
+
+#include <eosio/eosio.hpp>
+
+#include "chain.hpp"
+
+namespace host {
+
+  namespace token {
+
+    struct account {
+      eosio::asset    balance;
+
+      uint64_t primary_key() const { return balance.symbol.code().raw(); }
+    };
+    using accounts = eosio::multi_index<"accounts"_n, account>;
+
+    struct currency_stats {
+      eosio::asset    supply;
+      eosio::asset    max_supply;
+      eosio::name     issuer;
+
+      uint64_t primary_key() const { return supply.symbol.code().raw(); }
+    };
+    using stats = eosio::multi_index<"stat"_n, currency_stats>;
+
+    enum class flavour { eosio_token, fusion_token };
+
+    eosio::asset balance(eosio::name token_contract, eosio::name owner, eosio::symbol sym);
+    eosio::asset supply(eosio::name token_contract, eosio::symbol sym);
+
+  }
+
+  namespace alcor {
+
+    struct incentives {
+      uint64_t                  id;
+      eosio::name               creator;
+      uint64_t                  poolId;
+      eosio::extended_asset     reward;
+      uint32_t                  periodFinish;
+      uint32_t                  rewardsDuration;
+      unsigned __int128         rewardRateE18;
+      unsigned __int128         rewardPerTokenStored;
+      uint64_t                  totalStakingWeight;
+      uint32_t                  lastUpdateTime;
+      uint32_t                  numberOfStakes;
+
+      uint64_t primary_key() const { return id; }
+    };
+    using incentives_table = eosio::multi_index<"incentives"_n, incentives>;
+
+  }
+
+  void deploy_token(chain& c, eosio::name account, token::flavour f);
+  void deploy_alcor(chain& c, eosio::name account);
+  void deploy_passive(chain& c, eosio::name account);
+
+}
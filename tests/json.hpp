@@ -0,0 +1,313 @@
+#pragma once
+
+/**
+* json is the small reader/writer for the benchmark and replay reports and the replay input
+* - objects keep their keys in file order, so reports and diffs come out in the order they were written
+* - numbers keep the text they were written with, so uint64/int64 values round trip without going through double
+* - a malformed document throws json::error with the byte offset
+*/
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace json {
+
+  struct error : std::runtime_error {
+    using std::runtime_error::runtime_error;
+  };
+
+  struct value {
+    enum class kind { null, boolean, number, string, array, object };
+
+    kind                                        type = kind::null;
+    bool                                        boolean = false;
+    std::string                                 text; /* the string, or the number as written */
+    std::vector<value>                          items;
+    std::vector<std::pair<std::string, value>>  members;
+
+    bool is_null() const { return type == kind::null; }
+    bool is_string() const { return type == kind::string; }
+    bool is_number() const { return type == kind::number; }
+    bool is_array() const { return type == kind::array; }
+    bool is_object() const { return type == kind::object; }
+
+    /* the member named key, or nullptr */
+    const value* find(std::string_view key) const {
+      for( const auto& [k, v] : members ) if( k == key ) return &v;
+      return nullptr;
+    }
+
+    const value& at(std::string_view key) const {
+      const value* v = find(key);
+      if( v == nullptr ) throw error( "missing key \"" + std::string(key) + "\"" );
+      return *v;
+    }
+
+    const std::string& as_string() const {
+      if( type != kind::string ) throw error( "expected a string" );
+      return text;
+    }
+
+    bool as_bool() const {
+      if( type != kind::boolean ) throw error( "expected true or false" );
+      return boolean;
+    }
+
+    double as_double() const {
+      if( type != kind::number ) throw error( "expected a number" );
+      return std::strtod( text.c_str(), nullptr );
+    }
+
+    int64_t as_int64() const {
+      if( type != kind::number ) throw error( "expected a number" );
+      return std::strtoll( text.c_str(), nullptr, 10 );
+    }
+
+    uint64_t as_uint64() const {
+      if( type != kind::number || ( !text.empty() && text[0] == '-' ) ) throw error( "expected an unsigned number" );
+      return std::strtoull( text.c_str(), nullptr, 10 );
+    }
+  };
+
+  namespace detail {
+
+    class parser {
+      public:
+        explicit parser(std::string_view input) : _in(input) {}
+
+        value parse_document(){
+          value v = parse_value();
+          skip_space();
+          if( _pos != _in.size() ) fail( "trailing characters" );
+          return v;
+        }
+
+      private:
+        std::string_view  _in;
+        std::size_t       _pos = 0;
+
+        [[noreturn]] void fail(const std::string& message) const {
+          throw error( "json: " + message + " at byte " + std::to_string(_pos) );
+        }
+
+        void skip_space(){
+          while( _pos < _in.size() && ( _in[_pos] == ' ' || _in[_pos] == '\t' || _in[_pos] == '\n' || _in[_pos] == '\r' ) ) _pos ++;
+        }
+
+        char peek(){
+          skip_space();
+          if( _pos == _in.size() ) fail( "unexpected end of input" );
+          return _in[_pos];
+        }
+
+        void expect(char c){
+          if( peek() != c ) fail( std::string("expected '") + c + "'" );
+          _pos ++;
+        }
+
+        bool consume_word(std::string_view word){
+          if( _in.substr( _pos, word.size() ) != word ) return false;
+          _pos += word.size();
+          return true;
+        }
+
+        value parse_value(){
+          value v;
+          const char c = peek();
+
+          if( c == '{' ){
+            v.type = value::kind::object;
+            _pos ++;
+            if( peek() == '}' ){ _pos ++; return v; }
+            while( true ){
+              if( peek() != '"' ) fail( "expected a key" );
+              std::string key = parse_string();
+              expect( ':' );
+              v.members.emplace_back( std::move(key), parse_value() );
+              if( peek() == ',' ){ _pos ++; continue; }
+              expect( '}' );
+              return v;
+            }
+          }
+
+          if( c == '[' ){
+            v.type = value::kind::array;
+            _pos ++;
+            if( peek() == ']' ){ _pos ++; return v; }
+            while( true ){
+              v.items.push_back( parse_value() );
+              if( peek() == ',' ){ _pos ++; continue; }
+              expect( ']' );
+              return v;
+            }
+          }
+
+          if( c == '"' ){
+            v.type = value::kind::string;
+            v.text = parse_string();
+            return v;
+          }
+
+          if( consume_word( "true" ) ){ v.type = value::kind::boolean; v.boolean = true; return v; }
+          if( consume_word( "false" ) ){ v.type = value::kind::boolean; return v; }
+          if( consume_word( "null" ) ) return v;
+
+          const std::size_t start = _pos;
+          if( _pos < _in.size() && _in[_pos] == '-' ) _pos ++;
+          while( _pos < _in.size() && ( ( _in[_pos] >= '0' && _in[_pos] <= '9' ) || _in[_pos] == '.' || _in[_pos] == 'e'
+                                        || _in[_pos] == 'E' || _in[_pos] == '+' || _in[_pos] == '-' ) ) _pos ++;
+          if( _pos == start || ( _pos == start + 1 && _in[start] == '-' ) ) fail( "unexpected character" );
+
+          v.type = value::kind::number;
+          v.text = std::string( _in.substr( start, _pos - start ) );
+          return v;
+        }
+
+        static void append_utf8(std::string& out, uint32_t cp){
+          if( cp < 0x80 ){
+            out += char(cp);
+          } else if( cp < 0x800 ){
+            out += char( 0xc0 | ( cp >> 6 ) );
+            out += char( 0x80 | ( cp & 0x3f ) );
+          } else if( cp < 0x10000 ){
+            out += char( 0xe0 | ( cp >> 12 ) );
+            out += char( 0x80 | ( ( cp >> 6 ) & 0x3f ) );
+            out += char( 0x80 | ( cp & 0x3f ) );
+          } else {
+            out += char( 0xf0 | ( cp >> 18 ) );
+            out += char( 0x80 | ( ( cp >> 12 ) & 0x3f ) );
+            out += char( 0x80 | ( ( cp >> 6 ) & 0x3f ) );
+            out += char( 0x80 | ( cp & 0x3f ) );
+          }
+        }
+
+        uint32_t parse_hex4(){
+          if( _pos + 4 > _in.size() ) fail( "incomplete \\u escape" );
+          uint32_t cp = 0;
+          for( int i = 0; i < 4; i++ ){
+            const char h = _in[_pos++];
+            cp <<= 4;
+            if( h >= '0' && h <= '9' ) cp |= uint32_t( h - '0' );
+            else if( h >= 'a' && h <= 'f' ) cp |= uint32_t( h - 'a' + 10 );
+            else if( h >= 'A' && h <= 'F' ) cp |= uint32_t( h - 'A' + 10 );
+            else fail( "invalid \\u escape" );
+          }
+          return cp;
+        }
+
+        std::string parse_string(){
+          expect( '"' );
+          std::string out;
+
+          while( true ){
+            if( _pos == _in.size() ) fail( "unterminated string" );
+            const char c = _in[_pos++];
+            if( c == '"' ) return out;
+            if( c != '\\' ){ out += c; continue; }
+
+            if( _pos == _in.size() ) fail( "unterminated string" );
+            const char e = _in[_pos++];
+            switch( e ){
+              case '"': out += '"'; break;
+              case '\\': out += '\\'; break;
+              case '/': out += '/'; break;
+              case 'b': out += '\b'; break;
+              case 'f': out += '\f'; break;
+              case 'n': out += '\n'; break;
+              case 'r': out += '\r'; break;
+              case 't': out += '\t'; break;
+              case 'u': {
+                uint32_t cp = parse_hex4();
+                if( cp >= 0xd800 && cp < 0xdc00 && _in.substr( _pos, 2 ) == "\\u" ){
+                  _pos += 2;
+                  cp = 0x10000 + ( ( cp - 0xd800 ) << 10 ) + ( parse_hex4() - 0xdc00 );
+                }
+                append_utf8( out, cp );
+                break;
+              }
+              default: fail( "invalid escape" );
+            }
+          }
+        }
+    };
+
+  }
+
+  inline value parse(std::string_view input){ return detail::parser(input).parse_document(); }
+
+  inline value parse_file(const std::string& path){
+    std::unique_ptr<FILE, int(*)(FILE*)> f( std::fopen( path.c_str(), "rb" ), &std::fclose );
+    if( !f ) throw error( "could not open " + path );
+
+    std::string contents;
+    char buffer[65536];
+    std::size_t n;
+    while( ( n = std::fread( buffer, 1, sizeof(buffer), f.get() ) ) > 0 ) contents.append( buffer, n );
+
+    try {
+      return parse( contents );
+    } catch( const error& e ){
+      throw error( path + ": " + e.what() );
+    }
+  }
+
+  /* s as a quoted json string */
+  inline std::string quote(std::string_view s){
+    std::string out = "\"";
+    for( const char c : s ){
+      switch( c ){
+        case '"': out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\t': out += "\\t"; break;
+        default:
+          if( (unsigned char)(c) < 0x20 ){
+            char escaped[8];
+            std::snprintf( escaped, sizeof(escaped), "\\u%04x", (unsigned)(unsigned char)(c) );
+            out += escaped;
+          } else {
+            out += c;
+          }
+      }
+    }
+    return out + "\"";
+  }
+
+  /* v as compact json, numbers are written as they were read */
+  inline std::string write(const value& v){
+    switch( v.type ){
+      case value::kind::null: return "null";
+      case value::kind::boolean: return v.boolean ? "true" : "false";
+      case value::kind::number: return v.text;
+      case value::kind::string: return quote( v.text );
+      case value::kind::array: {
+        std::string out = "[";
+        for( std::size_t i = 0; i < v.items.size(); i++ ){
+          if( i > 0 ) out += ',';
+          out += write( v.items[i] );
+        }
+        return out + "]";
+      }
+      case value::kind::object: {
+        std::string out = "{";
+        for( std::size_t i = 0; i < v.members.size(); i++ ){
+          if( i > 0 ) out += ',';
+          out += quote( v.members[i].first );
+          out += ':';
+          out += write( v.members[i].second );
+        }
+        return out + "}";
+      }
+    }
+    return "null";
+  }
+
+}
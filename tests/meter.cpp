@@ -0,0 +1,105 @@
+#include "meter.hpp"
+
+#include <chrono>
+#include <tuple>
+
+namespace meter {
+
+  db_counts& db_counts::operator+=(const db_counts& other){
+    db_reads += other.db_reads;
+    db_writes += other.db_writes;
+    inline_actions += other.inline_actions;
+    rows_emplaced += other.rows_emplaced;
+    rows_erased += other.rows_erased;
+    snapshots_iterated += other.snapshots_iterated;
+    return *this;
+  }
+
+  std::map<eosio::name, db_counts> action_stats(const ::host::chain& chain){
+    std::map<eosio::name, db_counts> stats;
+
+    for( const auto& [action_name, row] : chain.rows( FUSION, FUSION.value, "actionstats"_n ) ){
+      const actionstats a = eosio::unpack<actionstats>( row.data );
+      stats[a.action] = db_counts{ a.db_reads, a.db_writes, a.inline_actions, a.rows_emplaced, a.rows_erased, a.snapshots_iterated };
+    }
+
+    return stats;
+  }
+
+  namespace {
+
+    db_counts difference(const db_counts& after, const db_counts& before){
+      return db_counts{ after.db_reads - before.db_reads, after.db_writes - before.db_writes, after.inline_actions - before.inline_actions,
+        after.rows_emplaced - before.rows_emplaced, after.rows_erased - before.rows_erased, after.snapshots_iterated - before.snapshots_iterated };
+    }
+
+    int64_t billed_bytes(const eosio::host::db_row& row){ return int64_t( row.data.size() ) + ::host::chain::ROW_OVERHEAD_BYTES; }
+
+    /* RAM per dapp.fusion table, from the first value each written row had and the value it has now */
+    void add_ram(const ::host::chain& chain, cost& c){
+      std::map<std::tuple<uint64_t, uint64_t, uint64_t>, const ::host::row_change*> first_writes;
+      for( const ::host::row_change& change : chain.changes() ){
+        c.rows_written ++;
+        if( change.code != FUSION || change.table == "actionstats"_n ) continue;
+        first_writes.emplace( std::make_tuple( change.scope, change.table.value, change.primary_key ), &change );
+      }
+
+      for( const auto& [key, change] : first_writes ){
+        const auto& rows = chain.rows( FUSION, change->scope, change->table );
+        const auto now = rows.find( change->primary_key );
+
+        const int64_t before = change->before.has_value() ? billed_bytes( *change->before ) : 0;
+        const int64_t after = now == rows.end() ? 0 : billed_bytes( now->second );
+        if( after == before ) continue;
+
+        c.table_ram_bytes[change->table] += after - before;
+        c.ram_bytes += after - before;
+      }
+    }
+
+  }
+
+  cost push(::host::chain& chain, std::vector<eosio::action> actions){
+    cost c;
+    for( const eosio::action& act : actions ){
+      c.action_bytes += eosio::pack( std::make_tuple( act.account, act.name, act.authorization, act.data ) ).size();
+    }
+
+    const std::map<eosio::name, db_counts> stats_before = action_stats(chain);
+    const std::size_t pushed = actions.size();
+    std::vector<::host::action_trace> traces;
+
+    const uint64_t allocations_before = allocations();
+    const uint64_t allocated_bytes_before = allocated_bytes();
+    const auto start = std::chrono::steady_clock::now();
+
+    try {
+      traces = chain.push_transaction( std::move(actions) );
+      c.succeeded = true;
+    } catch( const eosio::check_failure& e ){
+      c.error = e.what();
+    }
+
+    const auto finish = std::chrono::steady_clock::now();
+    c.wall_us = std::chrono::duration<double, std::micro>( finish - start ).count();
+    c.allocations = allocations() - allocations_before;
+    c.allocated_bytes = allocated_bytes() - allocated_bytes_before;
+
+    if( !c.succeeded ) return c;
+
+    for( const ::host::action_trace& trace : traces ){
+      if( trace.notification ) c.notifications ++;
+      else c.inline_actions ++;
+    }
+    c.inline_actions -= pushed;
+
+    for( const auto& [action_name, after] : action_stats(chain) ){
+      const auto before = stats_before.find(action_name);
+      c.counts += before == stats_before.end() ? after : difference( after, before->second );
+    }
+
+    add_ram( chain, c );
+    return c;
+  }
+
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+/**
+* meter measures what a transaction costs on the host chain, for the simulator, the benchmark and the replay tool
+* - wall time, and the heap allocations made while it ran (allocations.cpp replaces operator new)
+* - packed bytes of the pushed actions, and the inline actions and notifications that followed
+* - RAM billed for dapp.fusion rows, from the rows the transaction wrote
+* - the counts dapp.fusion added to actionstats, summed over every action and notification it ran
+*
+* host wall time and allocations stand in for billed CPU, which needs a node
+* link fusion_meter, the counts need the contract built with INSTRUMENT (fusion_host_instrument)
+*/
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "tester.hpp"
+
+namespace meter {
+
+  struct db_counts {
+    uint64_t      db_reads = 0;
+    uint64_t      db_writes = 0;
+    uint64_t      inline_actions = 0;
+    uint64_t      rows_emplaced = 0;
+    uint64_t      rows_erased = 0;
+    uint64_t      snapshots_iterated = 0;
+
+    db_counts& operator+=(const db_counts& other);
+  };
+
+  struct cost {
+    bool                              succeeded = false;
+    std::string                       error;
+    double                            wall_us = 0;
+    uint64_t                          allocations = 0;
+    uint64_t                          allocated_bytes = 0;
+    uint64_t                          action_bytes = 0;
+    uint64_t                          inline_actions = 0;
+    uint64_t                          notifications = 0;
+    uint64_t                          rows_written = 0;
+    int64_t                           ram_bytes = 0;
+    std::map<eosio::name, int64_t>    table_ram_bytes;
+    db_counts                         counts;
+  };
+
+  /* pushes one transaction and measures it, a failed check is returned in cost.error instead of thrown */
+  cost push(::host::chain& chain, std::vector<eosio::action> actions);
+
+  template<typename... Args>
+  cost push(::host::chain& chain, eosio::name actor, eosio::name contract, eosio::name action_name, Args&&... args){
+    return push( chain, { eosio::action( eosio::permission_level{ actor, "active"_n }, contract, action_name,
+      std::make_tuple( std::forward<Args>(args)... ) ) } );
+  }
+
+  inline cost transfer(::host::chain& chain, eosio::name token_contract, eosio::name from, eosio::name to, const eosio::asset& quantity, const std::string& memo){
+    return push( chain, from, token_contract, "transfer"_n, from, to, quantity, memo );
+  }
+
+  /* the actionstats rows, by action name */
+  std::map<eosio::name, db_counts> action_stats(const ::host::chain& chain);
+
+  /* heap allocations made by this process so far */
+  uint64_t allocations();
+  uint64_t allocated_bytes();
+
+}
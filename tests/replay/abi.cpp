@@ -0,0 +1,708 @@
+#include "abi.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+
+namespace abi {
+
+  namespace {
+
+    enum class builtin {
+      boolean, int8, uint8, int16, uint16, int32, uint32, int64, uint64, int128, uint128, varint32, varuint32,
+      float32, float64, name, string, bytes, symbol, symbol_code, asset, extended_asset,
+      time_point, time_point_sec, block_timestamp, checksum160, checksum256, checksum512, public_key, signature
+    };
+
+    const std::map<std::string, builtin, std::less<>>& builtins(){
+      static const std::map<std::string, builtin, std::less<>> types = {
+        { "bool", builtin::boolean }, { "int8", builtin::int8 }, { "uint8", builtin::uint8 }, { "int16", builtin::int16 },
+        { "uint16", builtin::uint16 }, { "int32", builtin::int32 }, { "uint32", builtin::uint32 }, { "int64", builtin::int64 },
+        { "uint64", builtin::uint64 }, { "int128", builtin::int128 }, { "uint128", builtin::uint128 },
+        { "varint32", builtin::varint32 }, { "varuint32", builtin::varuint32 }, { "float32", builtin::float32 },
+        { "float64", builtin::float64 }, { "name", builtin::name }, { "string", builtin::string }, { "bytes", builtin::bytes },
+        { "symbol", builtin::symbol }, { "symbol_code", builtin::symbol_code }, { "asset", builtin::asset },
+        { "extended_asset", builtin::extended_asset }, { "time_point", builtin::time_point },
+        { "time_point_sec", builtin::time_point_sec }, { "block_timestamp_type", builtin::block_timestamp },
+        { "checksum160", builtin::checksum160 }, { "checksum256", builtin::checksum256 }, { "checksum512", builtin::checksum512 },
+        { "public_key", builtin::public_key }, { "signature", builtin::signature }
+      };
+      return types;
+    }
+
+    /* milliseconds from 2000-01-01, the block_timestamp_type epoch, in half second slots */
+    constexpr int64_t BLOCK_TIMESTAMP_EPOCH_MS = 946684800000ll;
+    constexpr int64_t BLOCK_INTERVAL_MS = 500;
+
+    [[noreturn]] void fail(const std::string& path, const std::string& message){
+      throw error( ( path.empty() ? "" : path + ": " ) + message );
+    }
+
+    bool ends_with(const std::string& s, std::string_view suffix){
+      return s.size() >= suffix.size() && s.compare( s.size() - suffix.size(), suffix.size(), suffix ) == 0;
+    }
+
+    json::value make_number(std::string text){
+      json::value v;
+      v.type = json::value::kind::number;
+      v.text = std::move(text);
+      return v;
+    }
+
+    json::value make_string(std::string text){
+      json::value v;
+      v.type = json::value::kind::string;
+      v.text = std::move(text);
+      return v;
+    }
+
+    template<typename T>
+    void append(std::vector<char>& out, const T& v){
+      const char* p = reinterpret_cast<const char*>( &v );
+      out.insert( out.end(), p, p + sizeof(T) );
+    }
+
+    void append_varuint32(std::vector<char>& out, uint32_t v){
+      do {
+        uint8_t b = uint8_t( v & 0x7f );
+        v >>= 7;
+        if( v > 0 ) b |= 0x80;
+        out.push_back( char(b) );
+      } while( v > 0 );
+    }
+
+    /* the text of a number or a string holding one */
+    const std::string& integer_text(const json::value& v, const std::string& path){
+      if( v.type != json::value::kind::number && v.type != json::value::kind::string ) fail( path, "expected an integer" );
+      return v.text;
+    }
+
+    int128_t parse_integer(const std::string& text, bool is_signed, const std::string& path){
+      std::size_t i = 0;
+      const bool negative = !text.empty() && text[0] == '-';
+      if( negative ){
+        if( !is_signed ) fail( path, "expected an unsigned integer, got " + text );
+        i = 1;
+      }
+      if( i == text.size() ) fail( path, "expected an integer, got \"" + text + "\"" );
+
+      uint128_t magnitude = 0;
+      for( ; i < text.size(); i++ ){
+        if( text[i] < '0' || text[i] > '9' ) fail( path, "expected an integer, got " + text );
+        const uint128_t next = magnitude * 10 + unsigned( text[i] - '0' );
+        if( next / 10 != magnitude ) fail( path, text + " is out of range" );
+        magnitude = next;
+      }
+
+      if( is_signed ){
+        const uint128_t limit = uint128_t(1) << 127;
+        if( magnitude > ( negative ? limit : limit - 1 ) ) fail( path, text + " is out of range" );
+        return negative ? -int128_t( magnitude - 1 ) - 1 : int128_t( magnitude );
+      }
+      return int128_t( magnitude );
+    }
+
+    uint128_t parse_uint128(const std::string& text, const std::string& path){
+      if( !text.empty() && text[0] == '-' ) fail( path, "expected an unsigned integer, got " + text );
+
+      uint128_t v = 0;
+      if( text.empty() ) fail( path, "expected an integer" );
+      for( const char c : text ){
+        if( c < '0' || c > '9' ) fail( path, "expected an integer, got " + text );
+        const uint128_t next = v * 10 + unsigned( c - '0' );
+        if( next / 10 != v ) fail( path, text + " is out of range" );
+        v = next;
+      }
+      return v;
+    }
+
+    std::string uint128_text(uint128_t v){
+      std::string s;
+      do { s.insert( s.begin(), char( '0' + int( v % 10 ) ) ); v /= 10; } while( v > 0 );
+      return s;
+    }
+
+    std::string int128_text(int128_t v){
+      if( v >= 0 ) return uint128_text( uint128_t(v) );
+      std::string s = uint128_text( uint128_t( -( v + 1 ) ) + 1 );
+      s.insert( s.begin(), '-' );
+      return s;
+    }
+
+    template<typename T>
+    T checked_integer(const json::value& v, const std::string& path){
+      const int128_t i = parse_integer( integer_text( v, path ), std::is_signed_v<T>, path );
+      if( i < int128_t( std::numeric_limits<T>::min() ) || i > int128_t( std::numeric_limits<T>::max() ) ) fail( path, v.text + " is out of range" );
+      return T(i);
+    }
+
+    eosio::name parse_name(const json::value& v, const std::string& path){
+      if( !v.is_string() ) fail( path, "expected a name" );
+      try {
+        const eosio::name n( v.text );
+        if( n.to_string() != v.text ) fail( path, "\"" + v.text + "\" is not a valid name" );
+        return n;
+      } catch( const eosio::check_failure& e ){
+        fail( path, "\"" + v.text + "\" is not a valid name: " + e.what() );
+      }
+    }
+
+    eosio::symbol_code parse_symbol_code(std::string_view text, const std::string& path){
+      if( text.empty() || text.size() > 7 ) fail( path, "\"" + std::string(text) + "\" is not a valid symbol code" );
+      for( const char c : text ) if( c < 'A' || c > 'Z' ) fail( path, "\"" + std::string(text) + "\" is not a valid symbol code" );
+      return eosio::symbol_code( text );
+    }
+
+    std::string symbol_code_text(uint64_t raw){
+      std::string s;
+      for( ; raw > 0; raw >>= 8 ) s += char( raw & 0xff );
+      return s;
+    }
+
+    /* "8,WAX" */
+    eosio::symbol parse_symbol(const std::string& text, const std::string& path){
+      const std::size_t comma = text.find(',');
+      if( comma == std::string::npos || comma == 0 ) fail( path, "expected a symbol like \"8,WAX\", got \"" + text + "\"" );
+      const uint64_t precision = uint64_t( parse_integer( text.substr( 0, comma ), false, path ) );
+      if( precision > 18 ) fail( path, "symbol precision " + std::to_string(precision) + " is over 18" );
+      return eosio::symbol( parse_symbol_code( std::string_view(text).substr( comma + 1 ), path ), uint8_t(precision) );
+    }
+
+    /* "1.00000000 WAX", the precision is the number of decimals */
+    eosio::asset parse_asset(const std::string& text, const std::string& path){
+      const std::size_t space = text.find(' ');
+      if( space == std::string::npos ) fail( path, "expected an asset like \"1.00000000 WAX\", got \"" + text + "\"" );
+
+      const std::string amount = text.substr( 0, space );
+      const std::size_t dot = amount.find('.');
+      const std::size_t precision = dot == std::string::npos ? 0 : amount.size() - dot - 1;
+      if( precision > 18 ) fail( path, "asset precision " + std::to_string(precision) + " is over 18" );
+
+      std::string digits = amount;
+      if( dot != std::string::npos ) digits.erase( dot, 1 );
+      const int128_t units = parse_integer( digits, true, path );
+      if( units < -int128_t( eosio::asset::max_amount ) || units > int128_t( eosio::asset::max_amount ) ) fail( path, "asset amount " + amount + " is out of range" );
+
+      return eosio::asset( int64_t(units), eosio::symbol( parse_symbol_code( std::string_view(text).substr( space + 1 ), path ), uint8_t(precision) ) );
+    }
+
+    std::string asset_text(int64_t amount, uint64_t symbol_raw){
+      const unsigned precision = unsigned( symbol_raw & 0xff );
+      const bool negative = amount < 0;
+      std::string digits = uint128_text( negative ? uint128_t( -( int128_t(amount) ) ) : uint128_t(amount) );
+      if( precision > 0 ){
+        if( digits.size() <= precision ) digits.insert( 0, precision + 1 - digits.size(), '0' );
+        digits.insert( digits.end() - precision, '.' );
+      }
+      if( negative ) digits.insert( digits.begin(), '-' );
+      return digits + " " + symbol_code_text( symbol_raw >> 8 );
+    }
+
+    /* days since 1970-01-01 of a civil date, and back (Howard Hinnant's algorithms) */
+    int64_t days_from_civil(int64_t y, unsigned m, unsigned d){
+      y -= m <= 2;
+      const int64_t era = ( y >= 0 ? y : y - 399 ) / 400;
+      const unsigned yoe = unsigned( y - era * 400 );
+      const unsigned doy = ( 153 * ( m > 2 ? m - 3 : m + 9 ) + 2 ) / 5 + d - 1;
+      const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+      return era * 146097 + int64_t(doe) - 719468;
+    }
+
+    void civil_from_days(int64_t z, int64_t& y, unsigned& m, unsigned& d){
+      z += 719468;
+      const int64_t era = ( z >= 0 ? z : z - 146096 ) / 146097;
+      const unsigned doe = unsigned( z - era * 146097 );
+      const unsigned yoe = ( doe - doe / 1460 + doe / 36524 - doe / 146096 ) / 365;
+      const unsigned doy = doe - ( 365 * yoe + yoe / 4 - yoe / 100 );
+      const unsigned mp = ( 5 * doy + 2 ) / 153;
+      d = doy - ( 153 * mp + 2 ) / 5 + 1;
+      m = mp < 10 ? mp + 3 : mp - 9;
+      y = int64_t(yoe) + era * 400 + ( m <= 2 );
+    }
+
+    /* microseconds since 1970 of "2024-05-01T12:00:00[.000][Z]", numbers are taken as they are */
+    int64_t parse_time_us(const json::value& v, int64_t unit_us, const std::string& path){
+      if( v.is_number() ) return int64_t( parse_integer( v.text, true, path ) ) * unit_us;
+      if( !v.is_string() ) fail( path, "expected a time" );
+
+      int year = 0, month = 0, day = 0, hour = 0, minute = 0, second = 0, consumed = 0;
+      if( std::sscanf( v.text.c_str(), "%4d-%2d-%2dT%2d:%2d:%2d%n", &year, &month, &day, &hour, &minute, &second, &consumed ) != 6
+          || month < 1 || month > 12 || day < 1 || day > 31 || hour > 23 || minute > 59 || second > 59 ){
+        fail( path, "expected a time like \"2024-05-01T12:00:00.000\", got \"" + v.text + "\"" );
+      }
+
+      int64_t fraction_us = 0;
+      std::size_t i = std::size_t(consumed);
+      if( i < v.text.size() && v.text[i] == '.' ){
+        int64_t scale = 100000;
+        for( i++; i < v.text.size() && v.text[i] >= '0' && v.text[i] <= '9'; i++ ){
+          fraction_us += ( v.text[i] - '0' ) * scale;
+          scale /= 10;
+        }
+      }
+      if( i < v.text.size() && v.text[i] == 'Z' ) i++;
+      if( i != v.text.size() ) fail( path, "expected a time like \"2024-05-01T12:00:00.000\", got \"" + v.text + "\"" );
+
+      const int64_t seconds = days_from_civil( year, unsigned(month), unsigned(day) ) * 86400 + hour * 3600 + minute * 60 + second;
+      return seconds * 1000000 + fraction_us;
+    }
+
+    std::string time_text(int64_t us, bool with_milliseconds){
+      const int64_t seconds = us >= 0 ? us / 1000000 : -( ( -us + 999999 ) / 1000000 );
+      const int64_t days = seconds >= 0 ? seconds / 86400 : -( ( -seconds + 86399 ) / 86400 );
+      const int64_t in_day = seconds - days * 86400;
+
+      int64_t year;
+      unsigned month, day;
+      civil_from_days( days, year, month, day );
+
+      char buffer[64];
+      if( with_milliseconds ){
+        std::snprintf( buffer, sizeof(buffer), "%04lld-%02u-%02uT%02lld:%02lld:%02lld.%03lld", (long long) year, month, day,
+          (long long)( in_day / 3600 ), (long long)( in_day / 60 % 60 ), (long long)( in_day % 60 ), (long long)( ( us - seconds * 1000000 ) / 1000 ) );
+      } else {
+        std::snprintf( buffer, sizeof(buffer), "%04lld-%02u-%02uT%02lld:%02lld:%02lld", (long long) year, month, day,
+          (long long)( in_day / 3600 ), (long long)( in_day / 60 % 60 ), (long long)( in_day % 60 ) );
+      }
+      return buffer;
+    }
+
+    std::string double_text(double d){
+      if( !std::isfinite(d) ) return d != d ? "nan" : d > 0 ? "inf" : "-inf";
+      char buffer[32];
+      std::snprintf( buffer, sizeof(buffer), "%.17g", d );
+      return buffer;
+    }
+
+    double parse_double(const json::value& v, const std::string& path){
+      if( v.is_number() ) return v.as_double();
+      if( v.is_string() ){
+        char* end = nullptr;
+        const double d = std::strtod( v.text.c_str(), &end );
+        if( !v.text.empty() && *end == '\0' ) return d;
+      }
+      fail( path, "expected a number" );
+    }
+
+    void pack_hex(const json::value& v, std::size_t size, std::vector<char>& out, const std::string& path){
+      if( !v.is_string() ) fail( path, "expected a hex string" );
+      std::vector<char> bytes;
+      try {
+        bytes = from_hex( v.text );
+      } catch( const error& e ){
+        fail( path, e.what() );
+      }
+      if( size > 0 && bytes.size() != size ) fail( path, "expected " + std::to_string(size) + " bytes, got " + std::to_string( bytes.size() ) );
+      out.insert( out.end(), bytes.begin(), bytes.end() );
+    }
+
+  }
+
+  std::vector<char> from_hex(std::string_view hex){
+    if( hex.size() % 2 != 0 ) throw error( "hex string has an odd length" );
+
+    auto nibble = [](char c) -> int {
+      if( c >= '0' && c <= '9' ) return c - '0';
+      if( c >= 'a' && c <= 'f' ) return c - 'a' + 10;
+      if( c >= 'A' && c <= 'F' ) return c - 'A' + 10;
+      throw error( std::string("invalid hex character '") + c + "'" );
+    };
+
+    std::vector<char> out;
+    out.reserve( hex.size() / 2 );
+    for( std::size_t i = 0; i < hex.size(); i += 2 ) out.push_back( char( nibble( hex[i] ) << 4 | nibble( hex[i + 1] ) ) );
+    return out;
+  }
+
+  std::string to_hex(const std::vector<char>& data){
+    static constexpr char digits[] = "0123456789abcdef";
+    std::string out;
+    out.reserve( data.size() * 2 );
+    for( const char c : data ){
+      out += digits[ ( (unsigned char)(c) ) >> 4 ];
+      out += digits[ ( (unsigned char)(c) ) & 0xf ];
+    }
+    return out;
+  }
+
+  uint32_t seconds(const json::value& time){
+    const int64_t us = parse_time_us( time, 1000000, "time" );
+    if( us < 0 || us / 1000000 > int64_t( UINT32_MAX ) ) fail( "time", "is out of range" );
+    return uint32_t( us / 1000000 );
+  }
+
+  std::string time_string(uint32_t seconds){ return time_text( int64_t(seconds) * 1000000, false ); }
+
+  struct serializer::reader {
+    const std::vector<char>&  data;
+    std::size_t               pos = 0;
+
+    bool at_end() const { return pos == data.size(); }
+
+    const char* take(std::size_t n, const std::string& path){
+      if( data.size() - pos < n ) fail( path, "unexpected end of data" );
+      const char* p = data.data() + pos;
+      pos += n;
+      return p;
+    }
+
+    template<typename T>
+    T read(const std::string& path){
+      T v;
+      std::memcpy( &v, take( sizeof(T), path ), sizeof(T) );
+      return v;
+    }
+
+    uint32_t read_varuint32(const std::string& path){
+      uint64_t v = 0;
+      for( int shift = 0; shift < 35; shift += 7 ){
+        const uint8_t b = read<uint8_t>( path );
+        v |= uint64_t( b & 0x7f ) << shift;
+        if( ( b & 0x80 ) == 0 ){
+          if( v > UINT32_MAX ) fail( path, "varuint32 is out of range" );
+          return uint32_t(v);
+        }
+      }
+      fail( path, "varuint32 is too long" );
+    }
+
+    std::vector<char> read_bytes(std::size_t n, const std::string& path){
+      const char* p = take( n, path );
+      return std::vector<char>( p, p + n );
+    }
+  };
+
+  serializer::serializer(const json::value& abi){
+    if( const json::value* types = abi.find("types") ){
+      for( const json::value& t : types->items ) _typedefs[ t.at("new_type_name").as_string() ] = t.at("type").as_string();
+    }
+
+    for( const json::value& s : abi.at("structs").items ){
+      struct_def def;
+      if( const json::value* base = s.find("base") ) def.base = base->as_string();
+      for( const json::value& f : s.at("fields").items ) def.fields.push_back( field{ f.at("name").as_string(), f.at("type").as_string() } );
+      _structs[ s.at("name").as_string() ] = std::move(def);
+    }
+
+    if( const json::value* variants = abi.find("variants") ){
+      for( const json::value& v : variants->items ){
+        std::vector<std::string> types;
+        for( const json::value& t : v.at("types").items ) types.push_back( t.as_string() );
+        _variants[ v.at("name").as_string() ] = std::move(types);
+      }
+    }
+
+    if( const json::value* actions = abi.find("actions") ){
+      for( const json::value& a : actions->items ) _actions[ eosio::name( a.at("name").as_string() ).value ] = a.at("type").as_string();
+    }
+
+    if( const json::value* tables = abi.find("tables") ){
+      for( const json::value& t : tables->items ) _tables[ eosio::name( t.at("name").as_string() ).value ] = t.at("type").as_string();
+    }
+  }
+
+  std::string serializer::action_type(eosio::name action) const {
+    const auto itr = _actions.find( action.value );
+    return itr == _actions.end() ? std::string() : itr->second;
+  }
+
+  std::string serializer::table_type(eosio::name table) const {
+    const auto itr = _tables.find( table.value );
+    return itr == _tables.end() ? std::string() : itr->second;
+  }
+
+  const std::string& serializer::resolve(const std::string& type) const {
+    const std::string* t = &type;
+    for( std::size_t depth = 0; depth < 32; depth++ ){
+      const auto itr = _typedefs.find( *t );
+      if( itr == _typedefs.end() ) return *t;
+      t = &itr->second;
+    }
+    throw error( "typedef loop at " + type );
+  }
+
+  std::vector<char> serializer::pack(const std::string& type, const json::value& v, std::vector<eosio::name>* names) const {
+    std::vector<char> out;
+    pack_value( type, v, out, "", names );
+    return out;
+  }
+
+  json::value serializer::unpack(const std::string& type, const std::vector<char>& data) const {
+    reader r{ data };
+    json::value v = unpack_value( type, r, "" );
+    if( !r.at_end() ) throw error( type + " has " + std::to_string( data.size() - r.pos ) + " trailing bytes" );
+    return v;
+  }
+
+  void serializer::pack_value(const std::string& type_name, const json::value& v, std::vector<char>& out, const std::string& path, std::vector<eosio::name>* names) const {
+    const std::string& type = resolve( type_name );
+
+    if( ends_with( type, "$" ) ){
+      pack_value( type.substr( 0, type.size() - 1 ), v, out, path, names );
+      return;
+    }
+
+    if( ends_with( type, "?" ) ){
+      out.push_back( v.is_null() ? 0 : 1 );
+      if( !v.is_null() ) pack_value( type.substr( 0, type.size() - 1 ), v, out, path, names );
+      return;
+    }
+
+    if( ends_with( type, "[]" ) ){
+      if( !v.is_array() ) fail( path, "expected an array" );
+      const std::string element = type.substr( 0, type.size() - 2 );
+      append_varuint32( out, uint32_t( v.items.size() ) );
+      for( std::size_t i = 0; i < v.items.size(); i++ ) pack_value( element, v.items[i], out, path + "[" + std::to_string(i) + "]", names );
+      return;
+    }
+
+    if( const auto s = _structs.find( type ); s != _structs.end() ){
+      pack_struct( s->second, v, out, path, names );
+      return;
+    }
+
+    if( const auto variant = _variants.find( type ); variant != _variants.end() ){
+      if( !v.is_array() || v.items.size() != 2 || !v.items[0].is_string() ) fail( path, "expected a variant as [\"type\", value]" );
+      const auto& types = variant->second;
+      for( std::size_t i = 0; i < types.size(); i++ ){
+        if( types[i] != v.items[0].text ) continue;
+        append_varuint32( out, uint32_t(i) );
+        pack_value( types[i], v.items[1], out, path, names );
+        return;
+      }
+      fail( path, v.items[0].text + " is not one of the types of " + type );
+    }
+
+    const auto b = builtins().find( type );
+    if( b == builtins().end() ) fail( path, "unknown type " + type );
+
+    switch( b->second ){
+      case builtin::boolean:
+        if( v.type == json::value::kind::boolean ) out.push_back( v.boolean ? 1 : 0 );
+        else out.push_back( checked_integer<uint8_t>( v, path ) != 0 ? 1 : 0 );
+        break;
+      case builtin::int8: append( out, checked_integer<int8_t>( v, path ) ); break;
+      case builtin::uint8: append( out, checked_integer<uint8_t>( v, path ) ); break;
+      case builtin::int16: append( out, checked_integer<int16_t>( v, path ) ); break;
+      case builtin::uint16: append( out, checked_integer<uint16_t>( v, path ) ); break;
+      case builtin::int32: append( out, checked_integer<int32_t>( v, path ) ); break;
+      case builtin::uint32: append( out, checked_integer<uint32_t>( v, path ) ); break;
+      case builtin::int64: append( out, checked_integer<int64_t>( v, path ) ); break;
+      case builtin::uint64: append( out, checked_integer<uint64_t>( v, path ) ); break;
+      case builtin::int128: append( out, parse_integer( integer_text( v, path ), true, path ) ); break;
+      case builtin::uint128: append( out, parse_uint128( integer_text( v, path ), path ) ); break;
+      case builtin::varint32: {
+        const int32_t i = checked_integer<int32_t>( v, path );
+        append_varuint32( out, ( uint32_t(i) << 1 ) ^ uint32_t( i >> 31 ) );
+        break;
+      }
+      case builtin::varuint32: append_varuint32( out, checked_integer<uint32_t>( v, path ) ); break;
+      case builtin::float32: append( out, float( parse_double( v, path ) ) ); break;
+      case builtin::float64: append( out, parse_double( v, path ) ); break;
+      case builtin::name: {
+        const eosio::name n = parse_name( v, path );
+        if( names != nullptr ) names->push_back(n);
+        append( out, n.value );
+        break;
+      }
+      case builtin::string:
+        if( !v.is_string() ) fail( path, "expected a string" );
+        append_varuint32( out, uint32_t( v.text.size() ) );
+        out.insert( out.end(), v.text.begin(), v.text.end() );
+        break;
+      case builtin::bytes: {
+        std::vector<char> bytes;
+        pack_hex( v, 0, bytes, path );
+        append_varuint32( out, uint32_t( bytes.size() ) );
+        out.insert( out.end(), bytes.begin(), bytes.end() );
+        break;
+      }
+      case builtin::symbol:
+        if( !v.is_string() ) fail( path, "expected a symbol" );
+        append( out, parse_symbol( v.text, path ).raw() );
+        break;
+      case builtin::symbol_code:
+        if( !v.is_string() ) fail( path, "expected a symbol code" );
+        append( out, parse_symbol_code( v.text, path ).raw() );
+        break;
+      case builtin::asset: {
+        if( !v.is_string() ) fail( path, "expected an asset" );
+        const eosio::asset a = parse_asset( v.text, path );
+        append( out, a.amount );
+        append( out, a.symbol.raw() );
+        break;
+      }
+      case builtin::extended_asset:
+        if( !v.is_object() ) fail( path, "expected an extended_asset as {\"quantity\", \"contract\"}" );
+        pack_value( "asset", v.at("quantity"), out, path + ".quantity", names );
+        pack_value( "name", v.at("contract"), out, path + ".contract", names );
+        break;
+      case builtin::time_point: append( out, parse_time_us( v, 1, path ) ); break;
+      case builtin::time_point_sec: append( out, uint32_t( parse_time_us( v, 1000000, path ) / 1000000 ) ); break;
+      case builtin::block_timestamp: {
+        if( v.is_number() ){
+          append( out, checked_integer<uint32_t>( v, path ) );
+        } else {
+          const int64_t ms = parse_time_us( v, 1, path ) / 1000;
+          append( out, uint32_t( ( ms - BLOCK_TIMESTAMP_EPOCH_MS ) / BLOCK_INTERVAL_MS ) );
+        }
+        break;
+      }
+      case builtin::checksum160: pack_hex( v, 20, out, path ); break;
+      case builtin::checksum256: pack_hex( v, 32, out, path ); break;
+      case builtin::checksum512: pack_hex( v, 64, out, path ); break;
+      case builtin::public_key:
+      case builtin::signature: pack_hex( v, 0, out, path ); break;
+    }
+  }
+
+  void serializer::pack_struct(const struct_def& s, const json::value& v, std::vector<char>& out, const std::string& path, std::vector<eosio::name>* names) const {
+    if( !v.is_object() ) fail( path, "expected an object" );
+
+    if( !s.base.empty() ){
+      const auto base = _structs.find( resolve( s.base ) );
+      if( base == _structs.end() ) fail( path, "unknown base " + s.base );
+      pack_struct( base->second, v, out, path, names );
+    }
+
+    bool extensions_ended = false;
+    for( const field& f : s.fields ){
+      const json::value* member = v.find( f.name );
+      const std::string member_path = path.empty() ? f.name : path + "." + f.name;
+
+      //binary extensions can be left off the end of a row
+      if( member == nullptr || ( ends_with( f.type, "$" ) && member->is_null() ) ){
+        if( !ends_with( f.type, "$" ) ) fail( member_path, "missing" );
+        extensions_ended = true;
+        continue;
+      }
+      if( extensions_ended ) fail( member_path, "follows a binary extension that was left off" );
+
+      pack_value( f.type, *member, out, member_path, names );
+    }
+  }
+
+  json::value serializer::unpack_value(const std::string& type_name, reader& r, const std::string& path) const {
+    const std::string& type = resolve( type_name );
+
+    if( ends_with( type, "$" ) ) return unpack_value( type.substr( 0, type.size() - 1 ), r, path );
+
+    if( ends_with( type, "?" ) ){
+      if( r.read<uint8_t>( path ) == 0 ) return json::value{};
+      return unpack_value( type.substr( 0, type.size() - 1 ), r, path );
+    }
+
+    if( ends_with( type, "[]" ) ){
+      json::value v;
+      v.type = json::value::kind::array;
+      const std::string element = type.substr( 0, type.size() - 2 );
+      const uint32_t size = r.read_varuint32( path );
+      for( uint32_t i = 0; i < size; i++ ) v.items.push_back( unpack_value( element, r, path + "[" + std::to_string(i) + "]" ) );
+      return v;
+    }
+
+    if( const auto s = _structs.find( type ); s != _structs.end() ){
+      json::value v;
+      v.type = json::value::kind::object;
+      unpack_struct( s->second, r, v, path );
+      return v;
+    }
+
+    if( const auto variant = _variants.find( type ); variant != _variants.end() ){
+      const uint32_t index = r.read_varuint32( path );
+      if( index >= variant->second.size() ) fail( path, "variant index " + std::to_string(index) + " is out of range for " + type );
+      json::value v;
+      v.type = json::value::kind::array;
+      v.items.push_back( make_string( variant->second[index] ) );
+      v.items.push_back( unpack_value( variant->second[index], r, path ) );
+      return v;
+    }
+
+    const auto b = builtins().find( type );
+    if( b == builtins().end() ) fail( path, "unknown type " + type );
+
+    switch( b->second ){
+      case builtin::boolean: {
+        json::value v;
+        v.type = json::value::kind::boolean;
+        v.boolean = r.read<uint8_t>( path ) != 0;
+        return v;
+      }
+      case builtin::int8: return make_number( std::to_string( r.read<int8_t>( path ) ) );
+      case builtin::uint8: return make_number( std::to_string( r.read<uint8_t>( path ) ) );
+      case builtin::int16: return make_number( std::to_string( r.read<int16_t>( path ) ) );
+      case builtin::uint16: return make_number( std::to_string( r.read<uint16_t>( path ) ) );
+      case builtin::int32: return make_number( std::to_string( r.read<int32_t>( path ) ) );
+      case builtin::uint32: return make_number( std::to_string( r.read<uint32_t>( path ) ) );
+      case builtin::int64: return make_number( std::to_string( r.read<int64_t>( path ) ) );
+      case builtin::uint64: return make_number( std::to_string( r.read<uint64_t>( path ) ) );
+      case builtin::int128: return make_string( int128_text( r.read<int128_t>( path ) ) );
+      case builtin::uint128: return make_string( uint128_text( r.read<uint128_t>( path ) ) );
+      case builtin::varint32: {
+        const uint32_t zigzag = r.read_varuint32( path );
+        return make_number( std::to_string( int32_t( zigzag >> 1 ) ^ -int32_t( zigzag & 1 ) ) );
+      }
+      case builtin::varuint32: return make_number( std::to_string( r.read_varuint32( path ) ) );
+      case builtin::float32: return make_number( double_text( r.read<float>( path ) ) );
+      case builtin::float64: return make_number( double_text( r.read<double>( path ) ) );
+      case builtin::name: return make_string( eosio::name( r.read<uint64_t>( path ) ).to_string() );
+      case builtin::string: {
+        const std::vector<char> bytes = r.read_bytes( r.read_varuint32( path ), path );
+        return make_string( std::string( bytes.begin(), bytes.end() ) );
+      }
+      case builtin::bytes: return make_string( to_hex( r.read_bytes( r.read_varuint32( path ), path ) ) );
+      case builtin::symbol: {
+        const uint64_t raw = r.read<uint64_t>( path );
+        return make_string( std::to_string( raw & 0xff ) + "," + symbol_code_text( raw >> 8 ) );
+      }
+      case builtin::symbol_code: return make_string( symbol_code_text( r.read<uint64_t>( path ) ) );
+      case builtin::asset: {
+        const int64_t amount = r.read<int64_t>( path );
+        return make_string( asset_text( amount, r.read<uint64_t>( path ) ) );
+      }
+      case builtin::extended_asset: {
+        json::value v;
+        v.type = json::value::kind::object;
+        v.members.emplace_back( "quantity", unpack_value( "asset", r, path + ".quantity" ) );
+        v.members.emplace_back( "contract", unpack_value( "name", r, path + ".contract" ) );
+        return v;
+      }
+      case builtin::time_point: return make_string( time_text( r.read<int64_t>( path ), true ) );
+      case builtin::time_point_sec: return make_string( time_text( int64_t( r.read<uint32_t>( path ) ) * 1000000, false ) );
+      case builtin::block_timestamp: {
+        const int64_t ms = int64_t( r.read<uint32_t>( path ) ) * BLOCK_INTERVAL_MS + BLOCK_TIMESTAMP_EPOCH_MS;
+        return make_string( time_text( ms * 1000, true ) );
+      }
+      case builtin::checksum160: return make_string( to_hex( r.read_bytes( 20, path ) ) );
+      case builtin::checksum256: return make_string( to_hex( r.read_bytes( 32, path ) ) );
+      case builtin::checksum512: return make_string( to_hex( r.read_bytes( 64, path ) ) );
+      case builtin::public_key:
+      case builtin::signature: {
+        //k1 and r1 only, a webauthn key has a variable length
+        const std::size_t start = r.pos;
+        const uint8_t key_type = r.read<uint8_t>( path );
+        if( key_type > 1 ) fail( path, "only k1 and r1 keys and signatures are supported" );
+        r.take( b->second == builtin::public_key ? 33 : 65, path );
+        return make_string( to_hex( std::vector<char>( r.data.begin() + std::ptrdiff_t(start), r.data.begin() + std::ptrdiff_t(r.pos) ) ) );
+      }
+    }
+
+    fail( path, "unknown type " + type );
+  }
+
+  void serializer::unpack_struct(const struct_def& s, reader& r, json::value& out, const std::string& path) const {
+    if( !s.base.empty() ){
+      const auto base = _structs.find( resolve( s.base ) );
+      if( base == _structs.end() ) fail( path, "unknown base " + s.base );
+      unpack_struct( base->second, r, out, path );
+    }
+
+    for( const field& f : s.fields ){
+      //a row written before a binary extension was added ends before it
+      if( ends_with( f.type, "$" ) && r.at_end() ) break;
+      out.members.emplace_back( f.name, unpack_value( f.type, r, path.empty() ? f.name : path + "." + f.name ) );
+    }
+  }
+
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+/**
+* abi packs json into action data and table rows and unpacks them again, from an abi as get_abi returns it
+* - builtin types: bool, the integer types up to 128 bits, varint32/varuint32, float32/float64, name, string, bytes,
+*   symbol, symbol_code, asset, extended_asset, time_point, time_point_sec, block_timestamp_type, checksum160/256/512
+* - public_key and signature are written as the hex of their packed bytes, there is no base58 support
+* - typedefs, structs with a base, variants (as ["type", value]) and the [] ? $ suffixes
+* - 64 and 128 bit integers are read from numbers or strings, 128 bit integers are written as strings
+* - a value that doesn't fit its type throws abi::error with the path to it, e.g. "stakers.swax_balance"
+*/
+
+#include <cstdint>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <eosio/eosio.hpp>
+
+#include "json.hpp"
+
+namespace abi {
+
+  struct error : std::runtime_error {
+    using std::runtime_error::runtime_error;
+  };
+
+  std::vector<char> from_hex(std::string_view hex);
+  std::string to_hex(const std::vector<char>& data);
+
+  /* seconds since 1970 of a time as get_actions writes it ("2024-05-01T12:00:00.000"), or of a number of seconds */
+  uint32_t seconds(const json::value& time);
+
+  /* seconds since 1970 as "2024-05-01T12:00:00" */
+  std::string time_string(uint32_t seconds);
+
+  class serializer {
+    public:
+      serializer() = default;
+      explicit serializer(const json::value& abi);
+
+      /* the type of an action's data or a table's rows, empty when the abi doesn't have it */
+      std::string action_type(eosio::name action) const;
+      std::string table_type(eosio::name table) const;
+
+      /* names collects every name value that was packed, so the accounts an action mentions can be created */
+      std::vector<char> pack(const std::string& type, const json::value& v, std::vector<eosio::name>* names = nullptr) const;
+      json::value unpack(const std::string& type, const std::vector<char>& data) const;
+
+    private:
+      struct field {
+        std::string   name;
+        std::string   type;
+      };
+
+      struct struct_def {
+        std::string           base;
+        std::vector<field>    fields;
+      };
+
+      struct reader;
+
+      std::map<std::string, std::string>                _typedefs;
+      std::map<std::string, struct_def>                 _structs;
+      std::map<std::string, std::vector<std::string>>   _variants;
+      std::map<uint64_t, std::string>                   _actions;
+      std::map<uint64_t, std::string>                   _tables;
+
+      const std::string& resolve(const std::string& type) const;
+      void pack_value(const std::string& type, const json::value& v, std::vector<char>& out, const std::string& path, std::vector<eosio::name>* names) const;
+      void pack_struct(const struct_def& s, const json::value& v, std::vector<char>& out, const std::string& path, std::vector<eosio::name>* names) const;
+      json::value unpack_value(const std::string& type, reader& r, const std::string& path) const;
+      void unpack_struct(const struct_def& s, reader& r, json::value& out, const std::string& path) const;
+  };
+
+}
@@ -0,0 +1,534 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <optional>
+#include <set>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "abi.hpp"
+#include "json.hpp"
+#include "meter.hpp"
+
+/**
+* replay runs an exported mainnet workload through the host build and reports what each transaction cost and changed, e.g.
+*   ./build/tests/replay/replay workload.json --output replay.json
+*
+* the input is one json object, see example.json
+* - "time": where the clock starts, as get_actions writes times or in seconds
+* - "abis": abis by account, as get_abi returns them. with an account's abi its rows and action data can be
+*   written as json and the state diffs of its tables are unpacked, without it they are hex
+* - "accounts": accounts to create besides the ones named by authorizations, row payers and name fields
+* - "tables": each {"code", "scope", "table", "rows"} replaces that table. a row has "payer", "data" (hex or json)
+*   and "primary_key" (a number or a name), which can be left out for the singletons and the rows of the
+*   dapp.fusion, token, system and alcor tables the host build has the types of
+* - "actions": in the shape get_actions and hyperion export them, {"account", "name", "authorization", "data"
+*   or "hex_data"}, optionally wrapped in "act" next to a "timestamp" (or "@timestamp", "block_time"). actions that
+*   share a "trx_id" are pushed as one transaction, inline actions (a "creator_action_ordinal" above 0) are left out
+*   because the replayed actions send them again, and repeats of a "global_sequence" are left out
+*
+* - the replay starts from a fusion_tester (tokens, stand-ins, an initialized dapp.fusion), so a snapshot only needs
+*   the tables that differ from a fresh deployment
+* - the clock moves to each transaction's time, it never goes back
+* - --fund issues WAX to the sender of an eosio.token transfer who doesn't have enough, for exports without token balances
+* - each transaction is measured once with meter::push, so wall times carry the noise of a single run. the other
+*   columns are deterministic
+* - the report has the costs and every row each transaction changed, before and after, with --output it's written as json.
+*   actionstats rows (the INSTRUMENT counts) are left out of the changes
+* - replay exits with 1 when a transaction failed, 2 when the input can't be read
+*/
+
+namespace {
+
+  struct options {
+    std::string   input;
+    std::string   output;
+    bool          fund = false;
+  };
+
+  struct transaction {
+    std::string                   label;
+    std::optional<uint32_t>       time;
+    std::vector<eosio::action>    actions;
+  };
+
+  struct row_diff {
+    eosio::name                           code;
+    uint64_t                              scope = 0;
+    eosio::name                           table;
+    uint64_t                              primary_key = 0;
+    std::optional<eosio::host::db_row>    before;
+    std::optional<eosio::host::db_row>    after;
+  };
+
+  struct outcome {
+    std::string               label;
+    uint32_t                  time = 0;
+    meter::cost               cost;
+    std::vector<row_diff>     changes;
+  };
+
+  struct workload {
+    std::optional<uint32_t>             start;
+    std::map<uint64_t, abi::serializer> abis;
+    std::set<uint64_t>                  accounts;
+    std::vector<transaction>            transactions;
+  };
+
+  using key_function = uint64_t (*)(const std::vector<char>&);
+
+  template<typename Row>
+  uint64_t row_key(const std::vector<char>& data){ return eosio::unpack<Row>( data ).primary_key(); }
+
+  template<uint64_t Table>
+  uint64_t singleton_key(const std::vector<char>&){ return Table; }
+
+  /* how to find the primary key of a row of the tables the host build has the types of */
+  key_function find_key_function(eosio::name code, eosio::name table){
+    static const std::map<std::pair<uint64_t, uint64_t>, key_function> keys = {
+      { { FUSION.value, "actionstats"_n.value }, row_key<actionstats> },
+      { { FUSION.value, "audit"_n.value }, singleton_key<"audit"_n.value> },
+      { { FUSION.value, "config3"_n.value }, singleton_key<"config3"_n.value> },
+      { { FUSION.value, "debug"_n.value }, row_key<debug> },
+      { { FUSION.value, "epochs"_n.value }, row_key<epochs> },
+      { { FUSION.value, "lpfarms"_n.value }, row_key<lpfarms> },
+      { { FUSION.value, "prunestate"_n.value }, singleton_key<"prunestate"_n.value> },
+      { { FUSION.value, "ratering"_n.value }, row_key<ratering> },
+      { { FUSION.value, "rdmrequests"_n.value }, row_key<redeem_requests> },
+      { { FUSION.value, "renters"_n.value }, row_key<renters> },
+      { { FUSION.value, "rewards"_n.value }, singleton_key<"rewards"_n.value> },
+      { { FUSION.value, "routepayouts"_n.value }, row_key<routepayouts> },
+      { { FUSION.value, "settlements"_n.value }, singleton_key<"settlements"_n.value> },
+      { { FUSION.value, "snappages"_n.value }, row_key<snappages> },
+      { { FUSION.value, "snapshots"_n.value }, row_key<snapshots> },
+      { { FUSION.value, "snaptiers"_n.value }, singleton_key<"snaptiers"_n.value> },
+      { { FUSION.value, "stakers"_n.value }, row_key<stakers> },
+      { { FUSION.value, "state"_n.value }, singleton_key<"state"_n.value> },
+      { { FUSION.value, "state2"_n.value }, singleton_key<"state2"_n.value> },
+      { { FUSION.value, "state3"_n.value }, singleton_key<"state3"_n.value> },
+      { { FUSION.value, "statering"_n.value }, row_key<statering> },
+      { { FUSION.value, "statesnaps"_n.value }, row_key<statesnaps> },
+      { { FUSION.value, "top21"_n.value }, singleton_key<"top21"_n.value> },
+      { { WAX_CONTRACT.value, "accounts"_n.value }, row_key<::host::token::account> },
+      { { WAX_CONTRACT.value, "stat"_n.value }, row_key<::host::token::currency_stats> },
+      { { TOKEN_CONTRACT.value, "accounts"_n.value }, row_key<::host::token::account> },
+      { { TOKEN_CONTRACT.value, "stat"_n.value }, row_key<::host::token::currency_stats> },
+      { { SYSTEM_CONTRACT.value, "delband"_n.value }, row_key<delegated_bandwidth> },
+      { { SYSTEM_CONTRACT.value, "producers"_n.value }, row_key<producer_info> },
+      { { SYSTEM_CONTRACT.value, "refunds"_n.value }, row_key<refund_request> },
+      { { ALCOR_CONTRACT.value, "incentives"_n.value }, row_key<alcor_contract::incentives> },
+      { { ALCOR_CONTRACT.value, "pools"_n.value }, row_key<alcor_contract::pools_struct> },
+      { { POL_CONTRACT.value, "state2"_n.value }, singleton_key<"state2"_n.value> }
+    };
+
+    const auto itr = keys.find( { code.value, table.value } );
+    return itr == keys.end() ? nullptr : itr->second;
+  }
+
+  [[noreturn]] void fail(const std::string& message){ throw abi::error( message ); }
+
+  eosio::name parse_name(const json::value& v, const char* what){
+    const std::string& s = v.as_string();
+    const eosio::name n( s );
+    if( n.to_string() != s ) fail( std::string(what) + " \"" + s + "\" is not a valid name" );
+    return n;
+  }
+
+  /* a number, or a name for scopes and keys that are accounts */
+  uint64_t parse_key(const json::value& v, const char* what){
+    if( v.is_number() ) return v.as_uint64();
+    return parse_name( v, what ).value;
+  }
+
+  const abi::serializer* find_abi(const workload& w, eosio::name account){
+    const auto itr = w.abis.find( account.value );
+    return itr == w.abis.end() ? nullptr : &itr->second;
+  }
+
+  /* "stake" for an action, "memo: rent_cpu" for a transfer to dapp.fusion like the simulator and the benchmark */
+  std::string action_label(const eosio::action& a){
+    if( a.name == "transfer"_n ){
+      try {
+        const auto [from, to, quantity, memo] = eosio::unpack<std::tuple<eosio::name, eosio::name, eosio::asset, std::string>>( a.data );
+        if( to == FUSION ) return "memo: " + memo.substr( 0, memo.find('|') );
+      } catch( const eosio::check_failure& ){
+        //not a token transfer, labelled by its name
+      }
+    }
+    return a.account == FUSION ? a.name.to_string() : a.account.to_string() + "::" + a.name.to_string();
+  }
+
+  std::vector<char> action_data(const workload& w, const json::value& act, eosio::name account, eosio::name action_name, std::vector<eosio::name>& names){
+    if( const json::value* hex = act.find("hex_data") ) return abi::from_hex( hex->as_string() );
+
+    const json::value& data = act.at("data");
+    if( data.is_string() ) return abi::from_hex( data.text );
+
+    const std::string where = account.to_string() + "::" + action_name.to_string();
+    const abi::serializer* a = find_abi( w, account );
+    if( a == nullptr ) fail( where + " has json data but there is no abi for " + account.to_string() + ", add it to \"abis\" or give \"hex_data\"" );
+
+    const std::string type = a->action_type( action_name );
+    if( type.empty() ) fail( where + " is not in the abi of " + account.to_string() );
+
+    try {
+      return a->pack( type, data, &names );
+    } catch( const abi::error& e ){
+      fail( where + ": " + e.what() );
+    }
+  }
+
+  void read_actions(const json::value& input, workload& w){
+    const json::value* actions = input.find("actions");
+    if( actions == nullptr ) return;
+
+    std::set<std::string> sequences;
+    std::string last_trx_id;
+
+    for( const json::value& entry : actions->items ){
+      const json::value& act = entry.find("act") != nullptr ? entry.at("act") : entry;
+
+      if( const json::value* ordinal = entry.find("creator_action_ordinal"); ordinal != nullptr && ordinal->as_uint64() > 0 ) continue;
+
+      bool repeated = false;
+      for( const char* key : { "global_sequence", "global_action_seq" } ){
+        if( const json::value* seq = entry.find(key) ) repeated = repeated || !sequences.insert( seq->text ).second;
+      }
+      if( repeated ) continue;
+
+      const eosio::name account = parse_name( act.at("account"), "account" );
+      const eosio::name action_name = parse_name( act.at("name"), "action name" );
+
+      std::vector<eosio::permission_level> authorization;
+      if( const json::value* auths = act.find("authorization") ){
+        for( const json::value& auth : auths->items ){
+          authorization.emplace_back( parse_name( auth.at("actor"), "actor" ), parse_name( auth.at("permission"), "permission" ) );
+          w.accounts.insert( authorization.back().actor.value );
+        }
+      }
+
+      std::vector<eosio::name> names;
+      eosio::action a( authorization, account, action_name, std::make_tuple() );
+      a.data = action_data( w, act, account, action_name, names );
+      for( const eosio::name n : names ) w.accounts.insert( n.value );
+
+      std::optional<uint32_t> time;
+      for( const char* key : { "timestamp", "@timestamp", "block_time", "time" } ){
+        if( const json::value* t = entry.find(key) ){
+          time = abi::seconds( *t );
+          break;
+        }
+      }
+
+      std::string trx_id;
+      if( const json::value* id = entry.find("trx_id") ) trx_id = id->as_string();
+
+      if( !trx_id.empty() && trx_id == last_trx_id && !w.transactions.empty() ){
+        w.transactions.back().label += ", " + action_label(a);
+        w.transactions.back().actions.push_back( std::move(a) );
+      } else {
+        w.transactions.push_back( transaction{ action_label(a), time, { std::move(a) } } );
+      }
+      last_trx_id = trx_id;
+    }
+  }
+
+  workload read_workload(const json::value& input){
+    workload w;
+
+    if( const json::value* t = input.find("time") ) w.start = abi::seconds( *t );
+
+    if( const json::value* abis = input.find("abis") ){
+      for( const auto& [account, a] : abis->members ){
+        try {
+          w.abis.emplace( eosio::name( account ).value, abi::serializer( a ) );
+        } catch( const json::error& e ){
+          fail( "abi of " + account + ": " + e.what() );
+        }
+      }
+    }
+
+    if( const json::value* accounts = input.find("accounts") ){
+      for( const json::value& a : accounts->items ) w.accounts.insert( parse_name( a, "account" ).value );
+    }
+
+    read_actions( input, w );
+    return w;
+  }
+
+  /* replaces each table in the snapshot with its rows */
+  void load_tables(fusion_tester& t, const workload& w, const json::value& input){
+    const json::value* tables = input.find("tables");
+    if( tables == nullptr ) return;
+
+    for( const json::value& entry : tables->items ){
+      const eosio::name code = parse_name( entry.at("code"), "code" );
+      const uint64_t scope = parse_key( entry.at("scope"), "scope" );
+      const eosio::name table = parse_name( entry.at("table"), "table" );
+      const std::string where = code.to_string() + " " + table.to_string() + " (scope " + eosio::name(scope).to_string() + ")";
+
+      const abi::serializer* a = find_abi( w, code );
+      const key_function key_of = find_key_function( code, table );
+
+      std::vector<std::tuple<uint64_t, eosio::name, std::vector<char>>> rows;
+      for( const json::value& row : entry.at("rows").items ){
+        const eosio::name payer = parse_name( row.at("payer"), "payer" );
+        if( !t.chain.account_exists(payer) ) t.chain.create_account(payer);
+
+        std::vector<char> data;
+        const json::value& d = row.at("data");
+        if( d.is_string() ){
+          data = abi::from_hex( d.text );
+        } else {
+          const std::string type = a == nullptr ? std::string() : a->table_type( table );
+          if( type.empty() ) fail( where + " has json rows but the abi of " + code.to_string() + " doesn't have the table, give the rows as hex" );
+          try {
+            data = a->pack( type, d );
+          } catch( const abi::error& e ){
+            fail( where + ": " + e.what() );
+          }
+        }
+
+        uint64_t primary_key = 0;
+        if( const json::value* pk = row.find("primary_key") ){
+          primary_key = parse_key( *pk, "primary_key" );
+        } else if( key_of != nullptr ){
+          try {
+            primary_key = key_of( data );
+          } catch( const eosio::check_failure& e ){
+            fail( where + ": a row doesn't unpack as the host build's row type (" + e.what() + "), give its primary_key" );
+          }
+        } else {
+          fail( where + ": rows of this table need a primary_key" );
+        }
+
+        rows.emplace_back( primary_key, payer, std::move(data) );
+      }
+
+      t.chain.as( code, [&]{
+        std::vector<uint64_t> existing;
+        for( const auto& [primary_key, row] : t.chain.rows( code, scope, table ) ) existing.push_back( primary_key );
+        for( const uint64_t primary_key : existing ) eosio::host::remove( scope, table, primary_key );
+
+        for( auto& [primary_key, payer, data] : rows ){
+          const auto& current = t.chain.rows( code, scope, table );
+          if( current.find( primary_key ) != current.end() ) fail( where + ": primary_key " + std::to_string(primary_key) + " is there twice" );
+          eosio::host::store( scope, table, payer, primary_key, data );
+        }
+      });
+    }
+  }
+
+  /* tops up the sender of an eosio.token WAX transfer, unmetered */
+  void fund_transfers(fusion_tester& t, const transaction& tx){
+    for( const eosio::action& a : tx.actions ){
+      if( a.account != WAX_CONTRACT || a.name != "transfer"_n ) continue;
+
+      const auto [from, to, quantity, memo] = eosio::unpack<std::tuple<eosio::name, eosio::name, eosio::asset, std::string>>( a.data );
+      if( quantity.symbol != WAX_SYMBOL ) continue;
+
+      const eosio::asset balance = t.balance( WAX_CONTRACT, from, WAX_SYMBOL );
+      if( balance < quantity ) t.fund( from, quantity - balance );
+    }
+  }
+
+  /* the rows the last transaction changed, once each with its value before and after, without actionstats */
+  std::vector<row_diff> changed_rows(const ::host::chain& chain){
+    std::vector<row_diff> diffs;
+    std::set<std::tuple<uint64_t, uint64_t, uint64_t, uint64_t>> seen;
+
+    for( const ::host::row_change& change : chain.changes() ){
+      if( change.code == FUSION && change.table == "actionstats"_n ) continue;
+      if( !seen.insert( std::make_tuple( change.code.value, change.scope, change.table.value, change.primary_key ) ).second ) continue;
+
+      std::optional<eosio::host::db_row> after;
+      const auto& rows = chain.rows( change.code, change.scope, change.table );
+      if( const auto now = rows.find( change.primary_key ); now != rows.end() ) after = now->second;
+
+      const bool unchanged = change.before.has_value() && after.has_value() && change.before->data == after->data && change.before->payer == after->payer;
+      if( !unchanged ) diffs.push_back( row_diff{ change.code, change.scope, change.table, change.primary_key, change.before, std::move(after) } );
+    }
+
+    return diffs;
+  }
+
+  std::vector<outcome> replay(fusion_tester& t, const workload& w, const options& o){
+    std::vector<outcome> outcomes;
+
+    for( const transaction& tx : w.transactions ){
+      if( tx.time.has_value() && *tx.time > t.chain.now() ) t.chain.set_time( *tx.time );
+      if( o.fund ) fund_transfers( t, tx );
+
+      outcome out{ tx.label, t.chain.now() };
+      out.cost = meter::push( t.chain, tx.actions );
+      if( out.cost.succeeded ) out.changes = changed_rows( t.chain );
+      outcomes.push_back( std::move(out) );
+    }
+
+    return outcomes;
+  }
+
+  void print_outcomes(const std::vector<outcome>& outcomes){
+    std::printf( "%5s %-19s %-30s %9s %7s %7s %7s %7s %6s %6s %8s\n", "#", "time", "transaction", "us", "allocs",
+      "inlines", "reads", "writes", "snaps", "rows", "ram" );
+
+    for( std::size_t i = 0; i < outcomes.size(); i++ ){
+      const outcome& o = outcomes[i];
+      const meter::cost& c = o.cost;
+      std::printf( "%5zu %-19s %-30s %9.1f %7llu %7llu %7llu %7llu %6llu %6zu %8lld%s%s\n", i, abi::time_string( o.time ).c_str(), o.label.c_str(),
+        c.wall_us, (unsigned long long) c.allocations, (unsigned long long) c.inline_actions, (unsigned long long) c.counts.db_reads,
+        (unsigned long long) c.counts.db_writes, (unsigned long long) c.counts.snapshots_iterated, o.changes.size(), (long long) c.ram_bytes,
+        c.succeeded ? "" : "  FAILED: ", c.succeeded ? "" : c.error.c_str() );
+    }
+    std::printf( "(rows are the rows each transaction changed, without actionstats)\n" );
+  }
+
+  /* successful calls per transaction label, for a cost profile of the whole workload */
+  void print_profile(const std::vector<outcome>& outcomes){
+    struct totals {
+      uint64_t              calls = 0;
+      uint64_t              failed = 0;
+      std::vector<double>   wall_us;
+      uint64_t              allocations = 0;
+      meter::db_counts      counts;
+      int64_t               ram_bytes = 0;
+    };
+
+    std::map<std::string, totals> by_label;
+    for( const outcome& o : outcomes ){
+      totals& t = by_label[o.label];
+      t.calls ++;
+      if( !o.cost.succeeded ){ t.failed ++; continue; }
+      t.wall_us.push_back( o.cost.wall_us );
+      t.allocations += o.cost.allocations;
+      t.counts += o.cost.counts;
+      t.ram_bytes += o.cost.ram_bytes;
+    }
+
+    std::printf( "\n%-30s %7s %7s %9s %9s %8s %7s %7s %9s\n", "transaction", "calls", "failed", "us p50", "us max", "allocs", "reads", "writes", "ram" );
+    for( auto& [label, t] : by_label ){
+      const double n = double( t.wall_us.size() );
+      std::sort( t.wall_us.begin(), t.wall_us.end() );
+      std::printf( "%-30s %7llu %7llu %9.1f %9.1f %8.1f %7.1f %7.1f %9lld\n", label.c_str(), (unsigned long long) t.calls, (unsigned long long) t.failed,
+        t.wall_us.empty() ? 0.0 : t.wall_us[ t.wall_us.size() / 2 ], t.wall_us.empty() ? 0.0 : t.wall_us.back(),
+        n == 0 ? 0.0 : double( t.allocations ) / n, n == 0 ? 0.0 : double( t.counts.db_reads ) / n,
+        n == 0 ? 0.0 : double( t.counts.db_writes ) / n, (long long) t.ram_bytes );
+    }
+    std::printf( "(per successful call, ram is the total)\n" );
+  }
+
+  /* a row as json through its contract's abi, or as hex */
+  std::string row_json(const workload& w, const row_diff& d, const std::optional<eosio::host::db_row>& row){
+    if( !row.has_value() ) return "null";
+
+    if( const abi::serializer* a = find_abi( w, d.code ) ){
+      const std::string type = a->table_type( d.table );
+      if( !type.empty() ){
+        try {
+          return json::write( a->unpack( type, row->data ) );
+        } catch( const abi::error& ){
+          //the abi doesn't match what the contract wrote, the hex still shows the change
+        }
+      }
+    }
+    return json::quote( abi::to_hex( row->data ) );
+  }
+
+  void write_report(FILE* f, const workload& w, const std::vector<outcome>& outcomes){
+    std::fprintf( f, "{\n  \"format\": \"fusion-replay-1\",\n  \"transactions\": [" );
+
+    for( std::size_t i = 0; i < outcomes.size(); i++ ){
+      const outcome& o = outcomes[i];
+      const meter::cost& c = o.cost;
+
+      std::fprintf( f, "%s\n    {\"index\": %zu, \"time\": %s, \"transaction\": %s, \"succeeded\": %s, \"error\": %s, \"wall_us\": %.2f,",
+        i == 0 ? "" : ",", i, json::quote( abi::time_string( o.time ) ).c_str(), json::quote( o.label ).c_str(),
+        c.succeeded ? "true" : "false", json::quote( c.error ).c_str(), c.wall_us );
+      std::fprintf( f, " \"allocations\": %llu, \"allocated_bytes\": %llu, \"action_bytes\": %llu, \"inline_actions\": %llu,"
+        " \"notifications\": %llu, \"rows_written\": %llu, \"ram_bytes\": %lld,",
+        (unsigned long long) c.allocations, (unsigned long long) c.allocated_bytes, (unsigned long long) c.action_bytes,
+        (unsigned long long) c.inline_actions, (unsigned long long) c.notifications, (unsigned long long) c.rows_written, (long long) c.ram_bytes );
+      std::fprintf( f, " \"db_reads\": %llu, \"db_writes\": %llu, \"rows_emplaced\": %llu, \"rows_erased\": %llu, \"snapshots_iterated\": %llu,",
+        (unsigned long long) c.counts.db_reads, (unsigned long long) c.counts.db_writes, (unsigned long long) c.counts.rows_emplaced,
+        (unsigned long long) c.counts.rows_erased, (unsigned long long) c.counts.snapshots_iterated );
+
+      std::fprintf( f, " \"table_ram_bytes\": {" );
+      bool first = true;
+      for( const auto& [table, bytes] : c.table_ram_bytes ){
+        std::fprintf( f, "%s%s: %lld", first ? "" : ", ", json::quote( table.to_string() ).c_str(), (long long) bytes );
+        first = false;
+      }
+      std::fprintf( f, "},\n     \"changes\": [" );
+
+      for( std::size_t j = 0; j < o.changes.size(); j++ ){
+        const row_diff& d = o.changes[j];
+        const eosio::name payer = d.after.has_value() ? d.after->payer : d.before->payer;
+        std::fprintf( f, "%s\n       {\"code\": %s, \"scope\": %s, \"table\": %s, \"primary_key\": %llu, \"payer\": %s, \"before\": %s, \"after\": %s}",
+          j == 0 ? "" : ",", json::quote( d.code.to_string() ).c_str(), json::quote( eosio::name( d.scope ).to_string() ).c_str(),
+          json::quote( d.table.to_string() ).c_str(), (unsigned long long) d.primary_key, json::quote( payer.to_string() ).c_str(),
+          row_json( w, d, d.before ).c_str(), row_json( w, d, d.after ).c_str() );
+      }
+      std::fprintf( f, "%s]}", o.changes.empty() ? "" : "\n     " );
+    }
+
+    std::fprintf( f, "\n  ]\n}\n" );
+  }
+
+  bool parse(int argc, char** argv, options& o){
+    for( int i = 1; i < argc; i++ ){
+      const bool has_value = i + 1 < argc;
+
+      if( std::strcmp( argv[i], "--output" ) == 0 && has_value ) o.output = argv[++i];
+      else if( std::strcmp( argv[i], "--fund" ) == 0 ) o.fund = true;
+      else if( argv[i][0] != '-' && o.input.empty() ) o.input = argv[i];
+      else return false;
+    }
+    return !o.input.empty();
+  }
+
+}
+
+int main(int argc, char** argv){
+  options o;
+  if( !parse( argc, argv, o ) ){
+    std::fprintf( stderr, "usage: %s workload.json [--fund] [--output report.json]\n", argv[0] );
+    return 2;
+  }
+
+  fusion_tester t;
+  workload w;
+
+  try {
+    const json::value input = json::parse_file( o.input );
+    w = read_workload( input );
+
+    if( w.start.has_value() ) t.chain.set_time( *w.start );
+    for( const uint64_t account : w.accounts ){
+      if( !t.chain.account_exists( eosio::name(account) ) ) t.chain.create_account( eosio::name(account) );
+    }
+    load_tables( t, w, input );
+  } catch( const std::exception& e ){
+    //json::error, abi::error and a check_failure from the stand-ins
+    std::fprintf( stderr, "%s: %s\n", o.input.c_str(), e.what() );
+    return 2;
+  }
+
+  const std::vector<outcome> outcomes = replay( t, w, o );
+  print_outcomes( outcomes );
+  print_profile( outcomes );
+
+  if( !o.output.empty() ){
+    FILE* f = std::fopen( o.output.c_str(), "w" );
+    if( f == nullptr ){
+      std::fprintf( stderr, "could not write %s\n", o.output.c_str() );
+      return 2;
+    }
+    write_report( f, w, outcomes );
+    std::fclose( f );
+  }
+
+  const bool all_succeeded = std::all_of( outcomes.begin(), outcomes.end(), [](const outcome& out){ return out.cost.succeeded; } );
+  return all_succeeded ? 0 : 1;
+}
@@ -0,0 +1,136 @@
+#include "tester.hpp"
+
+#include "abi.hpp"
+
+/**
+* the abi serializer the replay tool packs its input with, checked against the host build's own serialization
+*/
+
+namespace {
+
+  const char* const FUSION_ABI = R"({
+    "version": "eosio::abi/1.2",
+    "types": [ { "new_type_name": "account_name", "type": "name" } ],
+    "structs": [
+      { "name": "stakers", "base": "", "fields": [
+        { "name": "wallet", "type": "account_name" },
+        { "name": "swax_balance", "type": "asset" },
+        { "name": "claimable_wax", "type": "asset" },
+        { "name": "last_update", "type": "uint64" },
+        { "name": "reward_per_swax_paid_1e12", "type": "uint128$" },
+        { "name": "reward_route", "type": "uint8$" } ] },
+      { "name": "snapshot_tier", "base": "", "fields": [
+        { "name": "resolution_seconds", "type": "uint64" },
+        { "name": "capacity", "type": "uint64" } ] },
+      { "name": "setsnaptiers", "base": "", "fields": [ { "name": "tiers", "type": "snapshot_tier[]" } ] },
+      { "name": "clearsnaps", "base": "", "fields": [
+        { "name": "resolution_seconds", "type": "uint64" },
+        { "name": "limit", "type": "int32" } ] },
+      { "name": "times", "base": "", "fields": [
+        { "name": "tp", "type": "time_point" },
+        { "name": "tps", "type": "time_point_sec" },
+        { "name": "bt", "type": "block_timestamp_type" },
+        { "name": "sym", "type": "symbol" },
+        { "name": "maybe", "type": "uint32?" },
+        { "name": "either", "type": "choice" } ] }
+    ],
+    "variants": [ { "name": "choice", "types": [ "uint8", "string" ] } ],
+    "actions": [
+      { "name": "setsnaptiers", "type": "setsnaptiers", "ricardian_contract": "" },
+      { "name": "clearsnaps", "type": "clearsnaps", "ricardian_contract": "" }
+    ],
+    "tables": [ { "name": "stakers", "index_type": "i64", "key_names": [], "key_types": [], "type": "stakers" } ]
+  })";
+
+  const abi::serializer& fusion_abi(){
+    static const abi::serializer a( json::parse( FUSION_ABI ) );
+    return a;
+  }
+
+  /* the error packing v as type throws, empty if it doesn't */
+  std::string pack_error(const std::string& type, const char* v){
+    try {
+      fusion_abi().pack( type, json::parse(v) );
+    } catch( const abi::error& e ){
+      return e.what();
+    }
+    return "";
+  }
+
+}
+
+TEST_CASE(staker_rows_pack_like_the_contract){
+  const abi::serializer& a = fusion_abi();
+  REQUIRE_EQ( a.table_type( "stakers"_n ), std::string("stakers") );
+
+  //a row written before the binary extensions existed
+  const std::vector<char> legacy = eosio::pack( std::make_tuple( "alice"_n, swax(12.5), eosio::asset( 1, WAX_SYMBOL ), uint64_t(1700000000) ) );
+  REQUIRE( !eosio::unpack<stakers>( legacy ).reward_route.has_value() );
+  const json::value legacy_json = json::parse( R"({"wallet": "alice", "swax_balance": "12.50000000 SWAX", "claimable_wax": "0.00000001 WAX", "last_update": 1700000000})" );
+  REQUIRE( a.pack( "stakers", legacy_json ) == legacy );
+  REQUIRE_EQ( json::write( a.unpack( "stakers", legacy ) ),
+    std::string(R"({"wallet":"alice","swax_balance":"12.50000000 SWAX","claimable_wax":"0.00000001 WAX","last_update":1700000000})") );
+
+  const stakers current{ "bob"_n, swax(3), ZERO_WAX, 5, uint128_t(1) << 100, uint8_t(2) };
+  const json::value current_json = json::parse( R"({"wallet": "bob", "swax_balance": "3.00000000 SWAX", "claimable_wax": "0.00000000 WAX",
+    "last_update": "5", "reward_per_swax_paid_1e12": "1267650600228229401496703205376", "reward_route": 2})" );
+  REQUIRE( a.pack( "stakers", current_json ) == eosio::pack( current ) );
+  REQUIRE_EQ( json::write( a.unpack( "stakers", eosio::pack( current ) ) ),
+    std::string(R"({"wallet":"bob","swax_balance":"3.00000000 SWAX","claimable_wax":"0.00000000 WAX","last_update":5,)"
+                R"("reward_per_swax_paid_1e12":"1267650600228229401496703205376","reward_route":2})") );
+}
+
+TEST_CASE(action_data_packs_like_the_dispatcher_reads_it){
+  const abi::serializer& a = fusion_abi();
+
+  const std::vector<snapshot_tier> tiers = { { 3600, 24 }, { 86400, 30 } };
+  REQUIRE( a.pack( a.action_type( "setsnaptiers"_n ), json::parse( R"({"tiers": [{"resolution_seconds": 3600, "capacity": 24},
+    {"resolution_seconds": 86400, "capacity": 30}]})" ) ) == eosio::pack( std::make_tuple( tiers ) ) );
+
+  REQUIRE( a.pack( "clearsnaps", json::parse( R"({"resolution_seconds": 3600, "limit": -1})" ) ) == eosio::pack( std::make_tuple( uint64_t(3600), int(-1) ) ) );
+  REQUIRE( a.action_type( "stake"_n ).empty() );
+}
+
+TEST_CASE(names_are_collected){
+  std::vector<eosio::name> names;
+  fusion_abi().pack( "stakers", json::parse( R"({"wallet": "carol", "swax_balance": "0.00000000 SWAX", "claimable_wax": "0.00000000 WAX", "last_update": 0})" ), &names );
+  REQUIRE( names == std::vector<eosio::name>{ "carol"_n } );
+}
+
+TEST_CASE(times_symbols_optionals_and_variants_round_trip){
+  const char* row = R"({"tp":"2024-05-01T12:00:00.500","tps":"2024-05-01T12:00:00","bt":"2024-05-01T12:00:01.500","sym":"4,LSWAX","maybe":null,"either":["string","x"]})";
+  const std::vector<char> packed = fusion_abi().pack( "times", json::parse(row) );
+  REQUIRE_EQ( json::write( fusion_abi().unpack( "times", packed ) ), std::string(row) );
+
+  REQUIRE_EQ( abi::seconds( json::parse( R"("2024-05-01T12:00:00.000")" ) ), uint32_t(1714564800) );
+  REQUIRE_EQ( abi::seconds( json::parse( "1714564800" ) ), uint32_t(1714564800) );
+  REQUIRE_EQ( abi::time_string( 1714564800 ), std::string("2024-05-01T12:00:00") );
+}
+
+TEST_CASE(negative_and_small_assets){
+  REQUIRE( fusion_abi().pack( "asset", json::parse( R"("-0.00000005 WAX")" ) ) == eosio::pack( eosio::asset( -5, WAX_SYMBOL ) ) );
+  REQUIRE_EQ( json::write( fusion_abi().unpack( "asset", eosio::pack( eosio::asset( -5, WAX_SYMBOL ) ) ) ), std::string(R"("-0.00000005 WAX")") );
+  REQUIRE_EQ( json::write( fusion_abi().unpack( "asset", eosio::pack( eosio::asset( 7, eosio::symbol( "EOS", 0 ) ) ) ) ), std::string(R"("7 EOS")") );
+}
+
+TEST_CASE(bad_values_name_their_field){
+  REQUIRE_EQ( pack_error( "stakers", R"({"wallet": "alice", "swax_balance": "1.0 SWAX", "claimable_wax": "0 WAX", "last_update": -1})" ),
+    std::string("last_update: expected an unsigned integer, got -1") );
+  REQUIRE_EQ( pack_error( "stakers", R"({"wallet": "Alice", "swax_balance": "1.0 SWAX", "claimable_wax": "0 WAX", "last_update": 1})" ).substr( 0, 28 ),
+    std::string("wallet: \"Alice\" is not a val") );
+  REQUIRE_EQ( pack_error( "stakers", R"({"wallet": "alice", "swax_balance": "1.0 SWAX", "last_update": 1})" ), std::string("claimable_wax: missing") );
+  REQUIRE_EQ( pack_error( "setsnaptiers", R"({"tiers": [{"resolution_seconds": 1}]})" ), std::string("tiers[0].capacity: missing") );
+  REQUIRE_EQ( pack_error( "stakers", R"({"wallet": "alice", "swax_balance": "1.0 SWAX", "claimable_wax": "0 WAX", "last_update": 1, "reward_route": 1})" ),
+    std::string("reward_route: follows a binary extension that was left off") );
+  REQUIRE_EQ( pack_error( "clearsnaps", R"({"resolution_seconds": 1, "limit": 2147483648})" ), std::string("limit: 2147483648 is out of range") );
+
+  bool threw = false;
+  try {
+    fusion_abi().unpack( "stakers", std::vector<char>( 10 ) );
+  } catch( const abi::error& e ){
+    threw = std::string( e.what() ) == "swax_balance: unexpected end of data";
+  }
+  REQUIRE( threw );
+}
+
+int main(){ return test::run_all(); }
@@ -0,0 +1,39 @@
+#pragma once
+
+/**
+* the checked multiplication safe.cpp did before safe_math.hpp, kept as the reference
+* fuzz_math and bench_math compare safe_math against
+* - safeMulUInt128 had its own range and overflow checks, and callers divided the result themselves
+* - calculate_asset_share divided by safeMulUInt128( 100, SCALE_FACTOR_1E6 ) on every call
+*/
+
+#include "fusion.hpp"
+
+namespace reference {
+
+  inline uint128_t safe_mul_u128(const uint128_t& a, const uint128_t& b){
+    if( a == 0 || b == 0 ) return 0;
+
+    if( a > (uint128_t) MAX_ASSET_AMOUNT_U64 || b > (uint128_t) MAX_ASSET_AMOUNT_U64 ){
+      eosio::check( false, "uint128_t multiplication input is outside of range" );
+    }
+
+    eosio::check( a <= MAX_U128_VALUE / b, "uint128_t multiplication would result in overflow" );
+
+    uint128_t result = a * b;
+
+    eosio::check( result <= MAX_U128_VALUE, "uint128_t multiplication result is outside of the acceptable range" );
+
+    return result;
+  }
+
+  inline uint128_t muldiv(const uint128_t& a, const uint128_t& b, const uint128_t& c){
+    return safe_mul_u128( a, b ) / c;
+  }
+
+  inline int64_t asset_share(const int64_t& quantity, const uint64_t& percentage){
+    if( quantity == 0 ) return 0;
+    return (int64_t) ( safe_mul_u128( (uint128_t) quantity, (uint128_t) percentage ) / safe_mul_u128( (uint128_t) 100, SCALE_FACTOR_1E6 ) );
+  }
+
+}
@@ -0,0 +1,419 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "meter.hpp"
+
+/**
+* simulate drives dapp.fusion on the host chain with a seeded workload, e.g.
+*   ./build/tests/sim/simulate --stakers 100000 --days 365 --ops 2000 --seed 1
+*
+* - stakers join over the first --join-days days, then --ops user operations run each day:
+*   syncs (the stake action on an existing row), more stake, liquify, unliquify, reqredeem,
+*   instaredeem, claimrewards, setroute and rent_cpu, and redeem for stakers with a request
+* - keepers run whatever is due at the start of each day: revenue, distribute, settle, stakeallcpu,
+*   unstakecpu and payroutes, a weekly scanstakers pass and prunesnaps, and the cpu contracts send
+*   staked WAX back with "cpu rental return" once an epoch's redemption period starts
+* - most user operations come from a small active group of stakers, the rest go dormant for
+*   days to months, which is what the sync cost report is broken down by
+*
+* the same options always produce the same workload and the same counts, only wall times differ
+* failed actions are part of the workload (e.g. a redeem outside the window), they are counted and reverted
+* simulate_invariants is the same workload on the INVARIANTS=true build, it fails if any action violated an invariant
+*
+* reports
+* - cost per action type: calls, failures, wall time, db reads/writes, inline actions, rows and RAM
+* - RAM per dapp.fusion table every 30 days and at the end
+* - the cost of a sync by how long the staker had been dormant
+* - the most common failure messages per action type
+*/
+
+namespace {
+
+  constexpr uint32_t DAY = 60 * 60 * 24;
+  constexpr eosio::name KEEPER = "keeper"_n;
+
+  struct options {
+    uint64_t    seed = 1;
+    uint64_t    stakers = 100000;
+    uint64_t    days = 365;
+    uint64_t    ops = 2000;
+    uint64_t    join_days = 30;
+  };
+
+  struct action_report {
+    uint64_t                      calls = 0;
+    uint64_t                      failures = 0;
+    std::vector<double>           wall_us;
+    meter::db_counts              counts;
+    uint64_t                      inline_actions = 0;
+    uint64_t                      action_bytes = 0;
+    uint64_t                      rows_written = 0;
+    int64_t                       ram_bytes = 0;
+    std::map<std::string, uint64_t> errors;
+  };
+
+  struct dormancy_bucket {
+    const char*                   label;
+    uint32_t                      max_days;
+    uint64_t                      syncs = 0;
+    std::vector<double>           wall_us;
+    meter::db_counts              counts;
+    int64_t                       ram_bytes = 0;
+  };
+
+  double percentile(std::vector<double> values, double p){
+    if( values.empty() ) return 0;
+    const std::size_t n = std::min( values.size() - 1, std::size_t( p * values.size() ) );
+    std::nth_element( values.begin(), values.begin() + n, values.end() );
+    return values[n];
+  }
+
+  double mean(uint64_t total, uint64_t n){ return n == 0 ? 0 : double(total) / double(n); }
+
+  /* prefix + 5 letters, enough for 11M accounts */
+  eosio::name account_name(const char* prefix, uint64_t index){
+    std::string s(prefix);
+    char letters[5];
+    for( int i = 4; i >= 0; i-- ){
+      letters[i] = char( 'a' + index % 26 );
+      index /= 26;
+    }
+    s.append( letters, 5 );
+    return eosio::name(s);
+  }
+
+  class simulation {
+    public:
+      explicit simulation(const options& o) : _o(o), _rng(o.seed) {
+        for( uint64_t i = 0; i < _o.stakers; i++ ) _stakers.push_back( account_name( "stk", i ) );
+        for( uint64_t i = 0; i < std::max<uint64_t>( 10, _o.stakers / 100 ); i++ ) _renters.push_back( account_name( "rnt", i ) );
+        for( const eosio::name renter : _renters ) _t.chain.create_account(renter);
+        _t.chain.create_account(KEEPER);
+
+        //the system contract's delband rows unstakecpu looks for
+        _t.chain.as( SYSTEM_CONTRACT, [&]{
+          for( const eosio::name cpu : { "cpu1.fusion"_n, "cpu2.fusion"_n, "cpu3.fusion"_n } ){
+            del_bandwidth_table del_t( SYSTEM_CONTRACT, cpu.value );
+            del_t.emplace( SYSTEM_CONTRACT, [&](auto &_d){
+              _d.from = cpu;
+              _d.to = cpu;
+              _d.net_weight = wax(0);
+              _d.cpu_weight = wax(1);
+            });
+          }
+        });
+
+        for( const auto& [label, max_days] : { std::pair{ "< 1 day", 1u }, std::pair{ "1-7 days", 7u }, std::pair{ "7-30 days", 30u },
+                                               std::pair{ "30-90 days", 90u }, std::pair{ "90-180 days", 180u }, std::pair{ "180+ days", UINT32_MAX } } ){
+          _dormancy.push_back( dormancy_bucket{ label, max_days } );
+        }
+      }
+
+      void run(){
+        const uint32_t start = _t.chain.now();
+        const uint64_t join_days = std::max<uint64_t>( 1, std::min( _o.join_days, _o.days ) );
+
+        for( uint64_t day = 0; day < _o.days; day++ ){
+          _t.chain.set_time( uint32_t( start + day * DAY ) );
+          run_keepers();
+
+          const uint64_t joining = day < join_days ? ( _o.stakers * ( day + 1 ) ) / join_days - _joined : 0;
+          const uint64_t ops = joining + _o.ops;
+
+          for( uint64_t i = 0; i < ops; i++ ){
+            _t.chain.set_time( uint32_t( start + day * DAY + ( DAY * i ) / ops ) );
+            if( i < joining ) join();
+            else user_operation();
+          }
+
+          if( ( day + 1 ) % 30 == 0 ) ram_checkpoint( day + 1 );
+        }
+
+        if( _o.days % 30 != 0 ) ram_checkpoint( _o.days );
+      }
+
+      /* failures from check_invariants, only possible in the simulate_invariants build */
+      uint64_t invariant_violations() const { return _invariant_violations; }
+
+      void report(double seconds) const {
+        std::printf( "simulated %llu days, %llu stakers, %llu ops/day, seed %llu, in %.1fs\n\n",
+          (unsigned long long) _o.days, (unsigned long long) _o.stakers, (unsigned long long) _o.ops, (unsigned long long) _o.seed, seconds );
+
+        std::printf( "%-26s %9s %8s %9s %9s %9s %8s %8s %7s %7s %8s %9s\n", "action", "calls", "failed", "us p50", "us p99",
+          "reads", "writes", "inlines", "snaps", "rows", "bytes", "ram" );
+        for( const auto& [label, r] : _actions ){
+          const uint64_t ok = r.calls - r.failures;
+          std::printf( "%-26s %9llu %8llu %9.1f %9.1f %9.1f %8.1f %8.1f %7.1f %7.1f %8.1f %9.1f\n", label.c_str(),
+            (unsigned long long) r.calls, (unsigned long long) r.failures, percentile( r.wall_us, 0.5 ), percentile( r.wall_us, 0.99 ),
+            mean( r.counts.db_reads, ok ), mean( r.counts.db_writes, ok ), mean( r.inline_actions, ok ), mean( r.counts.snapshots_iterated, ok ),
+            mean( r.rows_written, ok ), mean( r.action_bytes, r.calls ), ok == 0 ? 0.0 : double( r.ram_bytes ) / double( ok ) );
+        }
+        std::printf( "(per successful call: db reads/writes and snapshots iterated from INSTRUMENT, inline actions, rows written,\n"
+          " RAM bytes; bytes is the packed size of the pushed action)\n\n" );
+
+        std::printf( "RAM per dapp.fusion table, bytes by day\n%-14s %8s", "table", "rows" );
+        for( const auto& [day, sizes] : _ram ) std::printf( " %10llu", (unsigned long long) day );
+        std::printf( "\n" );
+        for( const auto& [table, last] : _ram.back().second ){
+          std::printf( "%-14s %8llu", table.to_string().c_str(), (unsigned long long) last.rows );
+          for( const auto& [day, sizes] : _ram ){
+            const auto size = sizes.find(table);
+            std::printf( " %10lld", size == sizes.end() ? 0LL : (long long) size->second.bytes );
+          }
+          std::printf( "\n" );
+        }
+        std::printf( "(rows at the end, bytes include %lld bytes of overhead per row)\n\n", (long long) ::host::chain::ROW_OVERHEAD_BYTES );
+
+        std::printf( "sync cost by dormancy (the stake action on an existing row)\n" );
+        std::printf( "%-12s %9s %9s %9s %9s %9s %9s %9s\n", "dormant", "syncs", "us p50", "us p99", "reads", "writes", "snaps", "ram" );
+        for( const dormancy_bucket& b : _dormancy ){
+          std::printf( "%-12s %9llu %9.1f %9.1f %9.1f %9.1f %9.1f %9.1f\n", b.label, (unsigned long long) b.syncs,
+            percentile( b.wall_us, 0.5 ), percentile( b.wall_us, 0.99 ), mean( b.counts.db_reads, b.syncs ), mean( b.counts.db_writes, b.syncs ),
+            mean( b.counts.snapshots_iterated, b.syncs ), b.syncs == 0 ? 0.0 : double( b.ram_bytes ) / double( b.syncs ) );
+        }
+
+        std::printf( "\nmost common failures\n" );
+        for( const auto& [label, r] : _actions ){
+          std::vector<std::pair<uint64_t, std::string>> errors;
+          for( const auto& [message, count] : r.errors ) errors.emplace_back( count, message );
+          std::sort( errors.rbegin(), errors.rend() );
+          for( std::size_t i = 0; i < std::min<std::size_t>( 3, errors.size() ); i++ ){
+            std::printf( "%-26s %9llu  %s\n", label.c_str(), (unsigned long long) errors[i].first, errors[i].second.c_str() );
+          }
+        }
+      }
+
+    private:
+      uint64_t below(uint64_t n){ return n == 0 ? 0 : _rng() % n; }
+
+      /* 70% of operations come from the first 5% of stakers, 25% from the next 20%, the rest from everyone else */
+      eosio::name pick_staker(){
+        const uint64_t roll = below(100);
+        const uint64_t active = std::max<uint64_t>( 1, _joined / 20 );
+        const uint64_t occasional = std::max<uint64_t>( 1, _joined / 4 );
+
+        if( roll < 70 ) return _stakers[ below(active) ];
+        if( roll < 95 ) return _stakers[ below(occasional) ];
+        return _stakers[ below(_joined) ];
+      }
+
+      meter::cost record(const std::string& label, const meter::cost& c){
+        action_report& r = _actions[label];
+        r.calls ++;
+        r.wall_us.push_back( c.wall_us );
+        r.action_bytes += c.action_bytes;
+
+        if( !c.succeeded ){
+          r.failures ++;
+          r.errors[c.error] ++;
+          if( c.error.find( "invariant violated" ) != std::string::npos ) _invariant_violations ++;
+          return c;
+        }
+
+        r.counts += c.counts;
+        r.inline_actions += c.inline_actions;
+        r.rows_written += c.rows_written;
+        r.ram_bytes += c.ram_bytes;
+        return c;
+      }
+
+      void join(){
+        const eosio::name user = _stakers[_joined++];
+        const eosio::asset quantity = wax( double( 10 + below(10000) ) );
+
+        _t.fund( user, quantity );
+        record( "stake (new row)", meter::push( _t.chain, user, FUSION, "stake"_n, user ) );
+        record( "memo: stake", meter::transfer( _t.chain, WAX_CONTRACT, user, FUSION, quantity, "stake" ) );
+      }
+
+      void user_operation(){
+        const uint64_t roll = below(100);
+
+        if( roll < 12 ){
+          rent_cpu();
+          return;
+        }
+
+        const eosio::name user = pick_staker();
+        const std::optional<stakers> staker = _t.get_staker(user);
+        if( !staker.has_value() ) return;
+
+        const int64_t swax_balance = staker->swax_balance.amount;
+        const eosio::asset some_swax( std::max<int64_t>( 1, swax_balance / int64_t( 2 + below(8) ) ), SWAX_SYMBOL );
+
+        if( roll < 42 ){
+          sync( user, *staker );
+        } else if( roll < 54 ){
+          const eosio::asset quantity = wax( double( 1 + below(2000) ) );
+          _t.fund( user, quantity );
+          record( "memo: stake", meter::transfer( _t.chain, WAX_CONTRACT, user, FUSION, quantity, "stake" ) );
+        } else if( roll < 66 ){
+          record( "liquify", meter::push( _t.chain, user, FUSION, "liquify"_n, user, some_swax ) );
+        } else if( roll < 71 ){
+          const eosio::asset lswax_balance = _t.balance( TOKEN_CONTRACT, user, LSWAX_SYMBOL );
+          if( lswax_balance.amount == 0 ) return;
+          record( "memo: unliquify", meter::transfer( _t.chain, TOKEN_CONTRACT, user, FUSION, lswax_balance, "unliquify" ) );
+        } else if( roll < 79 ){
+          if( record( "reqredeem", meter::push( _t.chain, user, FUSION, "reqredeem"_n, user, some_swax, true ) ).succeeded ) _requested[user] = _t.chain.now();
+        } else if( roll < 84 ){
+          record( "instaredeem", meter::push( _t.chain, user, FUSION, "instaredeem"_n, user, some_swax ) );
+        } else if( roll < 98 ){
+          record( "claimrewards", meter::push( _t.chain, user, FUSION, "claimrewards"_n, user ) );
+        } else {
+          record( "setroute", meter::push( _t.chain, user, FUSION, "setroute"_n, user, uint8_t( below(3) ) ) );
+        }
+      }
+
+      void sync(eosio::name user, const stakers& staker){
+        const meter::cost c = record( "stake (sync)", meter::push( _t.chain, user, FUSION, "stake"_n, user ) );
+        if( !c.succeeded ) return;
+
+        const uint64_t dormant_days = ( _t.chain.now() - staker.last_update ) / DAY;
+        for( dormancy_bucket& b : _dormancy ){
+          if( dormant_days >= b.max_days ) continue;
+          b.syncs ++;
+          b.wall_us.push_back( c.wall_us );
+          b.counts += c.counts;
+          b.ram_bytes += c.ram_bytes;
+          return;
+        }
+      }
+
+      /* rents from the next epoch, overpaying so the contract refunds the difference */
+      void rent_cpu(){
+        const eosio::name renter = _renters[ below( _renters.size() ) ];
+        const state s = _t.get_state();
+        const config3 c = config_singleton_3( FUSION, FUSION.value ).get();
+
+        const uint64_t wax_to_rent = 10 + below(5000);
+        const eosio::asset payment = wax( double(wax_to_rent) * 0.2 );
+        const std::string memo = "|rent_cpu|" + renter.to_string() + "|" + std::to_string(wax_to_rent) + "|"
+          + std::to_string( s.last_epoch_start_time + c.seconds_between_epochs ) + "|";
+
+        _t.fund( renter, payment );
+        record( "memo: rent_cpu", meter::transfer( _t.chain, WAX_CONTRACT, renter, FUSION, payment, memo ) );
+      }
+
+      void run_keepers(){
+        const uint32_t now = _t.chain.now();
+
+        const eosio::asset revenue = wax( double( 1 + _joined / 1000 + below(100) ) );
+        _t.fund( fusion_tester::REVENUE, revenue );
+        record( "memo: waxfusion_revenue", meter::transfer( _t.chain, WAX_CONTRACT, fusion_tester::REVENUE, FUSION, revenue, "waxfusion_revenue" ) );
+
+        if( now >= _t.get_state().next_distribution ) record( "distribute", meter::push( _t.chain, KEEPER, FUSION, "distribute"_n ) );
+        if( now >= _t.get_settlements().next_settlement ) record( "settle", meter::push( _t.chain, KEEPER, FUSION, "settle"_n ) );
+        if( now >= _t.get_state().next_stakeall_time ) record( "stakeallcpu", meter::push( _t.chain, KEEPER, FUSION, "stakeallcpu"_n ) );
+
+        if( _t.get_settlements().route_lswax_pending.value_or( lswax(0) ).amount > 0 ){
+          while( record( "payroutes", meter::push( _t.chain, KEEPER, FUSION, "payroutes"_n, 50 ) ).succeeded
+            && _t.get_settlements().route_lswax_pending->amount > 0 ){}
+        }
+
+        epochs_table epochs_t( FUSION, FUSION.value );
+        for( auto itr = epochs_t.begin(); itr != epochs_t.end(); ++itr ){
+          if( itr->time_to_unstake <= now && _unstaked.insert( itr->start_time ).second ){
+            renters_table renters_t( FUSION, itr->start_time );
+            do {
+              if( !record( "unstakecpu", meter::push( _t.chain, KEEPER, FUSION, "unstakecpu"_n, itr->start_time, 0 ) ).succeeded ) break;
+            } while( renters_t.begin() != renters_t.end() );
+          }
+
+          //the cpu contract's unstaked WAX comes back when the epoch's redemption period starts
+          if( itr->redemption_period_start_time <= now && itr->wax_bucket.amount > 0 && _returned.insert( itr->start_time ).second ){
+            const eosio::asset held = _t.balance( WAX_CONTRACT, itr->cpu_wallet, WAX_SYMBOL );
+            const eosio::asset returned( std::min( held.amount, itr->wax_bucket.amount ), WAX_SYMBOL );
+            if( returned.amount > 0 ){
+              record( "memo: cpu rental return", meter::transfer( _t.chain, WAX_CONTRACT, itr->cpu_wallet, FUSION, returned, "cpu rental return" ) );
+            }
+          }
+        }
+
+        const state s = _t.get_state();
+        const config3 c = config_singleton_3( FUSION, FUSION.value ).get();
+        //stakers with a request try to redeem once per redemption window, and give up on it after three windows
+        if( now < s.last_epoch_start_time + c.redemption_period_length_seconds && s.last_epoch_start_time != _redeem_window ){
+          _redeem_window = s.last_epoch_start_time;
+          for( auto request = _requested.begin(); request != _requested.end(); ){
+            const eosio::name user = request->first;
+            const bool redeemed = record( "redeem", meter::push( _t.chain, user, FUSION, "redeem"_n, user ) ).succeeded;
+            if( redeemed || now - request->second > 3 * c.seconds_between_epochs ) request = _requested.erase(request);
+            else ++request;
+          }
+        }
+
+        //a weekly scanstakers pass, then prune what every staker has been paid for
+        if( ( now - INITIAL_EPOCH_START_TIMESTAMP ) / DAY % 7 == 0 ){
+          while( record( "scanstakers", meter::push( _t.chain, KEEPER, FUSION, "scanstakers"_n, 500 ) ).succeeded
+            && prunestate_singleton( FUSION, FUSION.value ).get().next_staker != 0 ){}
+          while( record( "prunesnaps", meter::push( _t.chain, KEEPER, FUSION, "prunesnaps"_n, 500 ) ).succeeded ){}
+        }
+      }
+
+      void ram_checkpoint(uint64_t day){
+        _ram.emplace_back( day, _t.chain.table_sizes(FUSION) );
+      }
+
+      options                                 _o;
+      std::mt19937_64                         _rng;
+      fusion_tester                           _t;
+      std::vector<eosio::name>                _stakers;
+      std::vector<eosio::name>                _renters;
+      uint64_t                                _joined = 0;
+      std::map<eosio::name, uint32_t>         _requested;
+      uint64_t                                _redeem_window = 0;
+      uint64_t                                _invariant_violations = 0;
+      std::set<uint64_t>                      _unstaked;
+      std::set<uint64_t>                      _returned;
+      std::map<std::string, action_report>    _actions;
+      std::vector<dormancy_bucket>            _dormancy;
+      std::vector<std::pair<uint64_t, std::map<eosio::name, ::host::table_size>>> _ram;
+  };
+
+  bool parse(int argc, char** argv, options& o){
+    for( int i = 1; i + 1 < argc; i += 2 ){
+      const uint64_t value = std::strtoull( argv[i + 1], nullptr, 10 );
+      if( std::strcmp( argv[i], "--seed" ) == 0 ) o.seed = value;
+      else if( std::strcmp( argv[i], "--stakers" ) == 0 ) o.stakers = value;
+      else if( std::strcmp( argv[i], "--days" ) == 0 ) o.days = value;
+      else if( std::strcmp( argv[i], "--ops" ) == 0 ) o.ops = value;
+      else if( std::strcmp( argv[i], "--join-days" ) == 0 ) o.join_days = value;
+      else return false;
+    }
+    return argc % 2 == 1 && o.stakers > 0 && o.days > 0;
+  }
+
+}
+
+int main(int argc, char** argv){
+  options o;
+  if( !parse( argc, argv, o ) ){
+    std::fprintf( stderr, "usage: %s [--seed n] [--stakers n] [--days n] [--ops n] [--join-days n]\n", argv[0] );
+    return 2;
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  simulation sim(o);
+
+  try {
+    sim.run();
+  } catch( const std::exception& e ){
+    std::fprintf( stderr, "simulation stopped: %s\n", e.what() );
+    return 1;
+  }
+
+  sim.report( std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count() );
+
+  if( sim.invariant_violations() > 0 ){
+    std::fprintf( stderr, "%llu actions violated an invariant\n", (unsigned long long) sim.invariant_violations() );
+    return 1;
+  }
+  return 0;
+}
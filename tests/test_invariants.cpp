@@ -0,0 +1,150 @@
+#include "tester.hpp"
+
+/**
+* built with INVARIANTS=true, so every action and notification below runs check_invariants
+* and any violation fails the push
+*/
+
+static constexpr uint32_t DAY = 60 * 60 * 24;
+
+TEST_CASE(distribute_and_settle_keep_the_invariants){
+  fusion_tester t;
+  t.stake( "alice"_n, wax(100) );
+  t.stake( "bob"_n, wax(300) );
+  t.chain.push( "bob"_n, FUSION, "liquify"_n, "bob"_n, swax(100) );
+
+  t.add_revenue( wax(1000) );
+  t.distribute();
+
+  t.chain.set_time( uint32_t( t.get_settlements().next_settlement ) );
+  t.settle();
+
+  //distribute issued sWAX for the earning share too, which nobody has claimed yet
+  const state s = t.get_state();
+  REQUIRE_EQ( t.supply( TOKEN_CONTRACT, SWAX_SYMBOL ).amount, s.swax_currently_earning.amount + s.swax_currently_backing_lswax.amount
+    + s.user_funds_bucket.amount + t.get_state3().total_claimable_wax.amount );
+  REQUIRE_EQ( t.supply( TOKEN_CONTRACT, LSWAX_SYMBOL ), s.liquified_swax );
+}
+
+TEST_CASE(claims_and_routes_keep_the_invariants){
+  fusion_tester t;
+  t.stake( "alice"_n, wax(100) );
+  t.stake( "bob"_n, wax(100) );
+  t.stake( "carol"_n, wax(100) );
+  t.chain.push( "bob"_n, FUSION, "setroute"_n, "bob"_n, REWARD_ROUTE_COMPOUND_SWAX );
+  t.chain.push( "carol"_n, FUSION, "setroute"_n, "carol"_n, REWARD_ROUTE_CONVERT_LSWAX );
+
+  t.add_revenue( wax(1000) );
+  t.distribute();
+  t.advance( DAY );
+
+  t.chain.push( "alice"_n, FUSION, "claimswax"_n, "alice"_n );
+  t.chain.push( "bob"_n, FUSION, "stake"_n, "bob"_n );
+  t.chain.push( "carol"_n, FUSION, "stake"_n, "carol"_n );
+  t.chain.push( "carol"_n, FUSION, "payroutes"_n, 10 );
+
+  t.add_revenue( wax(500) );
+  t.distribute();
+  t.advance( DAY );
+  t.chain.push( "alice"_n, FUSION, "claimrewards"_n, "alice"_n );
+
+  t.fund( "sponsor"_n, wax(50) );
+  t.transfer( WAX_CONTRACT, "sponsor"_n, FUSION, wax(50), "lp_incentives" );
+
+  t.chain.set_time( uint32_t( t.get_settlements().next_settlement ) );
+  t.settle();
+
+  REQUIRE( t.supply( TOKEN_CONTRACT, SWAX_SYMBOL ).amount >= t.get_state().swax_currently_earning.amount + t.get_state().swax_currently_backing_lswax.amount );
+  REQUIRE_EQ( t.supply( TOKEN_CONTRACT, LSWAX_SYMBOL ), t.get_state().liquified_swax );
+}
+
+namespace {
+
+  /* the rental pool staked to the next epoch, which is where redemption requests are placed */
+  void stake_rental_pool(fusion_tester& t){
+    const uint64_t next_stakeall = t.get_state().next_stakeall_time;
+    if( t.chain.now() < next_stakeall ) t.chain.set_time( uint32_t( next_stakeall ) );
+    t.chain.push( "alice"_n, FUSION, "stakeallcpu"_n );
+  }
+
+  epochs get_epoch(uint64_t start_time){ return epochs_table( FUSION, FUSION.value ).get( start_time ); }
+
+}
+
+TEST_CASE(redemptions_keep_the_invariants){
+  fusion_tester t;
+  t.stake( "alice"_n, wax(1000) );
+  t.stake( "bob"_n, wax(1000) );
+  t.add_revenue( wax(100) );
+  t.distribute();
+
+  //instaredeem is paid from the rental pool, so before it is staked
+  t.chain.push( "bob"_n, FUSION, "instaredeem"_n, "bob"_n, swax(10) );
+
+  //a request for the current redemption window, with its WAX already returned by the cpu contract
+  t.chain.push( FUSION, FUSION, "sync"_n, FUSION );
+  const uint64_t epoch_to_claim_from = t.get_state().last_epoch_start_time - config_singleton_3( FUSION, FUSION.value ).get().seconds_between_epochs;
+  t.seed( [&]{
+    requests_tbl requests_t( FUSION, "alice"_n.value );
+    requests_t.emplace( "alice"_n, [&](auto &_r){
+      _r.epoch_id = epoch_to_claim_from;
+      _r.wax_amount_requested = wax(100);
+    });
+
+    state_singleton states( FUSION, FUSION.value );
+    state s = states.get();
+    s.wax_for_redemption = wax(100);
+    s.wax_available_for_rentals.amount -= units(100);
+    states.set( s, FUSION );
+  });
+
+  const state before = t.get_state();
+  const int64_t owed_before = t.get_state3().total_wax_owed.amount;
+  const eosio::asset alice_wax = t.balance( WAX_CONTRACT, "alice"_n, WAX_SYMBOL );
+  t.chain.push( "alice"_n, FUSION, "redeem"_n, "alice"_n );
+
+  //redeem saves the state it changed
+  const state after = t.get_state();
+  REQUIRE_EQ( after.wax_for_redemption, wax(0) );
+  REQUIRE_EQ( after.swax_currently_earning.amount, before.swax_currently_earning.amount - units(100) );
+  REQUIRE_EQ( t.get_state3().total_wax_owed.amount, owed_before - units(100) );
+  REQUIRE_EQ( t.balance( WAX_CONTRACT, "alice"_n, WAX_SYMBOL ), alice_wax + wax(100) );
+  REQUIRE_EQ( t.get_staker( "alice"_n )->swax_balance, swax(900) );
+
+  //a new request against the epoch the rental pool is staked to
+  stake_rental_pool(t);
+  t.chain.push( "bob"_n, FUSION, "reqredeem"_n, "bob"_n, swax(100), true );
+  const uint64_t next_epoch = t.get_state().last_epoch_start_time + config_singleton_3( FUSION, FUSION.value ).get().seconds_between_epochs;
+  REQUIRE_EQ( get_epoch( next_epoch ).wax_to_refund, wax(100) );
+}
+
+TEST_CASE(unstaking_rentals_keeps_the_invariants){
+  fusion_tester t;
+  t.stake( "alice"_n, wax(1000) );
+
+  //the delband row unstakecpu looks for before it sends unstakebatch
+  t.chain.as( SYSTEM_CONTRACT, [&]{
+    del_bandwidth_table del_t( SYSTEM_CONTRACT, "cpu1.fusion"_n.value );
+    del_t.emplace( SYSTEM_CONTRACT, [&](auto &_d){
+      _d.from = "cpu1.fusion"_n;
+      _d.to = "cpu1.fusion"_n;
+      _d.net_weight = wax(0);
+      _d.cpu_weight = wax(1);
+    });
+  });
+
+  renters_table renters_t( FUSION, INITIAL_EPOCH_START_TIMESTAMP );
+  for( const eosio::name renter : { "renter1"_n, "renter2"_n } ){
+    t.fund( renter, wax(20) );
+    t.transfer( WAX_CONTRACT, renter, FUSION, wax(20), "|rent_cpu|" + renter.to_string() + "|100|" + std::to_string( INITIAL_EPOCH_START_TIMESTAMP ) + "|" );
+  }
+
+  REQUIRE( renters_t.begin() != renters_t.end() );
+
+  t.chain.set_time( uint32_t( get_epoch( INITIAL_EPOCH_START_TIMESTAMP ).time_to_unstake ) );
+  t.chain.push( "alice"_n, FUSION, "unstakecpu"_n, uint64_t( INITIAL_EPOCH_START_TIMESTAMP ), 0 );
+
+  REQUIRE( renters_t.begin() == renters_t.end() );
+}
+
+int main(){ return test::run_all(); }
@@ -0,0 +1,157 @@
+#include "tester.hpp"
+
+/**
+* rewards are routed by sync_user according to the staker's reward_route
+* 0 = claimable WAX, 1 = compound into sWAX, 2 = convert to lsWAX
+*/
+
+static constexpr uint32_t DAY = 60 * 60 * 24;
+
+/* alice has 100 sWAX earning and a full period of 850 WAX has streamed to her */
+static void earn_one_period(fusion_tester& t, uint8_t route){
+  t.stake( "alice"_n, wax(100) );
+  if( route != REWARD_ROUTE_CLAIMABLE_WAX ) t.chain.push( "alice"_n, FUSION, "setroute"_n, "alice"_n, route );
+
+  t.add_revenue( wax(1000) );
+  t.distribute();
+  t.advance( DAY );
+}
+
+TEST_CASE(new_stakers_default_to_claimable){
+  fusion_tester t;
+  earn_one_period( t, REWARD_ROUTE_CLAIMABLE_WAX );
+
+  REQUIRE_EQ( *t.get_staker( "alice"_n )->reward_route, REWARD_ROUTE_CLAIMABLE_WAX );
+
+  const int64_t pending = t.position( "alice"_n ).pending_rewards.amount;
+  t.chain.push( "alice"_n, FUSION, "stake"_n, "alice"_n );
+
+  const stakers staker = *t.get_staker( "alice"_n );
+  REQUIRE_EQ( staker.claimable_wax.amount, pending );
+  REQUIRE_EQ( staker.swax_balance, swax(100) );
+  REQUIRE_EQ( t.get_state3().total_claimable_wax.amount, pending );
+  REQUIRE_EQ( t.get_state().user_funds_bucket.amount, units(850) - pending );
+}
+
+TEST_CASE(compound_route_adds_to_swax_balance){
+  fusion_tester t;
+  earn_one_period( t, REWARD_ROUTE_COMPOUND_SWAX );
+
+  const staker_position p = t.position( "alice"_n );
+  REQUIRE_EQ( p.reward_route, REWARD_ROUTE_COMPOUND_SWAX );
+  REQUIRE_EQ( p.swax_balance.amount, units(100) + p.pending_rewards.amount );
+
+  const state before = t.get_state();
+  t.chain.push( "alice"_n, FUSION, "stake"_n, "alice"_n );
+  const state after = t.get_state();
+
+  const stakers staker = *t.get_staker( "alice"_n );
+  REQUIRE_EQ( staker.swax_balance.amount, units(100) + p.pending_rewards.amount );
+  REQUIRE_EQ( staker.claimable_wax, wax(0) );
+  REQUIRE_EQ( after.swax_currently_earning.amount, before.swax_currently_earning.amount + p.pending_rewards.amount );
+  REQUIRE_EQ( after.wax_available_for_rentals.amount, before.wax_available_for_rentals.amount + p.pending_rewards.amount );
+  REQUIRE_EQ( after.user_funds_bucket.amount, before.user_funds_bucket.amount - p.pending_rewards.amount );
+}
+
+TEST_CASE(convert_route_issues_lswax){
+  fusion_tester t;
+  earn_one_period( t, REWARD_ROUTE_CONVERT_LSWAX );
+
+  const int64_t pending = t.position( "alice"_n ).pending_rewards.amount;
+  const state before = t.get_state();
+  t.chain.push( "alice"_n, FUSION, "stake"_n, "alice"_n );
+  const state after = t.get_state();
+
+  //converted at sync, but only issued by payroutes
+  const int64_t lswax_owed = t.position( "alice"_n ).lswax_awaiting_payout.amount;
+  REQUIRE( lswax_owed > 0 );
+  REQUIRE_EQ( t.balance( TOKEN_CONTRACT, "alice"_n, LSWAX_SYMBOL ), lswax(0) );
+  REQUIRE_EQ( after.liquified_swax.amount, before.liquified_swax.amount + lswax_owed );
+  REQUIRE_EQ( after.swax_currently_backing_lswax.amount, before.swax_currently_backing_lswax.amount + pending );
+  REQUIRE_EQ( t.get_settlements().route_lswax_pending->amount, lswax_owed );
+
+  const stakers staker = *t.get_staker( "alice"_n );
+  REQUIRE_EQ( staker.swax_balance, swax(100) );
+  REQUIRE_EQ( staker.claimable_wax, wax(0) );
+
+  t.chain.push( "alice"_n, FUSION, "payroutes"_n, 10 );
+  REQUIRE_EQ( t.balance( TOKEN_CONTRACT, "alice"_n, LSWAX_SYMBOL ).amount, lswax_owed );
+  REQUIRE_EQ( t.position( "alice"_n ).lswax_awaiting_payout, lswax(0) );
+  REQUIRE_EQ( *t.get_settlements().route_lswax_pending, lswax(0) );
+  REQUIRE_THROWS_WITH( t.chain.push( "alice"_n, FUSION, "payroutes"_n, 10 ), "there are no route payouts to send" );
+}
+
+TEST_CASE(convert_route_syncs_are_paid_in_one_issue){
+  fusion_tester t;
+  t.stake( "alice"_n, wax(100) );
+  t.chain.push( "alice"_n, FUSION, "setroute"_n, "alice"_n, REWARD_ROUTE_CONVERT_LSWAX );
+  t.add_revenue( wax(1000) );
+  t.distribute();
+
+  t.advance( DAY / 2 );
+  t.chain.push( "alice"_n, FUSION, "stake"_n, "alice"_n );
+  const int64_t first = t.position( "alice"_n ).lswax_awaiting_payout.amount;
+  t.advance( DAY / 2 );
+  t.chain.push( "alice"_n, FUSION, "stake"_n, "alice"_n );
+  const int64_t both = t.position( "alice"_n ).lswax_awaiting_payout.amount;
+  REQUIRE( first > 0 );
+  REQUIRE( both > first );
+
+  //anyone can send the payouts
+  t.chain.create_account( "bob"_n );
+  t.chain.push( "bob"_n, FUSION, "payroutes"_n, 10 );
+  REQUIRE_EQ( t.balance( TOKEN_CONTRACT, "alice"_n, LSWAX_SYMBOL ).amount, both );
+}
+
+TEST_CASE(convert_route_dust_stays_claimable){
+  fusion_tester t;
+  t.stake( "alice"_n, wax(100) );
+  t.chain.push( "alice"_n, FUSION, "setroute"_n, "alice"_n, REWARD_ROUTE_CONVERT_LSWAX );
+
+  //1 unit of WAX is owed to alice, at a rate where it converts to 0 lsWAX
+  t.seed( [&]{
+    rewards_singleton rewards_s( FUSION, FUSION.value );
+    rewards rw = rewards_s.get();
+    rw.reward_per_swax_1e12 += 100;
+    rewards_s.set( rw, FUSION );
+
+    state_singleton states( FUSION, FUSION.value );
+    state s = states.get();
+    s.user_funds_bucket.amount += 1;
+    s.swax_currently_backing_lswax = swax(1000);
+    s.liquified_swax = lswax(1);
+    states.set( s, FUSION );
+  });
+
+  REQUIRE_EQ( t.position( "alice"_n ).pending_rewards.amount, int64_t(1) );
+  t.chain.push( "alice"_n, FUSION, "stake"_n, "alice"_n );
+
+  REQUIRE_EQ( t.get_staker( "alice"_n )->claimable_wax.amount, int64_t(1) );
+  REQUIRE_EQ( t.position( "alice"_n ).lswax_awaiting_payout, lswax(0) );
+  REQUIRE_EQ( t.get_state().liquified_swax, lswax(1) );
+}
+
+TEST_CASE(setroute_settles_with_the_previous_route){
+  fusion_tester t;
+  earn_one_period( t, REWARD_ROUTE_CLAIMABLE_WAX );
+
+  const int64_t pending = t.position( "alice"_n ).pending_rewards.amount;
+  t.chain.push( "alice"_n, FUSION, "setroute"_n, "alice"_n, REWARD_ROUTE_COMPOUND_SWAX );
+
+  const stakers staker = *t.get_staker( "alice"_n );
+  REQUIRE_EQ( staker.claimable_wax.amount, pending );
+  REQUIRE_EQ( staker.swax_balance, swax(100) );
+  REQUIRE_EQ( *staker.reward_route, REWARD_ROUTE_COMPOUND_SWAX );
+}
+
+TEST_CASE(setroute_rejects_unknown_routes){
+  fusion_tester t;
+  t.stake( "alice"_n, wax(100) );
+
+  REQUIRE_THROWS_WITH( t.chain.push( "alice"_n, FUSION, "setroute"_n, "alice"_n, uint8_t(3) ), "invalid reward route" );
+
+  t.chain.create_account( "bob"_n );
+  REQUIRE_THROWS_WITH( t.chain.push( "bob"_n, FUSION, "setroute"_n, "bob"_n, REWARD_ROUTE_CLAIMABLE_WAX ), "you need to use the stake action first" );
+}
+
+int main(){ return test::run_all(); }
@@ -0,0 +1,126 @@
+#include "tester.hpp"
+
+/**
+* sWAX earning rewards are streamed linearly over the distribution interval
+* and paid out pro rata to the sWAX that was earning while they streamed
+*/
+
+static constexpr uint32_t DAY = 60 * 60 * 24;
+
+TEST_CASE(distribution_streams_over_the_interval){
+  fusion_tester t;
+  t.stake( "alice"_n, wax(100) );
+  t.stake( "bob"_n, wax(300) );
+
+  t.add_revenue( wax(1000) );
+  t.distribute();
+
+  //all sWAX is earning, so the whole user share (85%) is streamed
+  REQUIRE_EQ( t.get_rewards().rewards_remaining, wax(850) );
+  REQUIRE_EQ( t.get_state().user_funds_bucket, wax(850) );
+  REQUIRE_EQ( t.position( "alice"_n ).pending_rewards, wax(0) );
+
+  t.advance( DAY / 2 );
+  REQUIRE_NEAR( t.position( "alice"_n ).pending_rewards.amount, units(106.25), 1 );
+  REQUIRE_NEAR( t.position( "bob"_n ).pending_rewards.amount, units(318.75), 1 );
+
+  //nothing streams past period_finish
+  t.advance( DAY );
+  REQUIRE_NEAR( t.position( "alice"_n ).pending_rewards.amount, units(212.5), 1 );
+  REQUIRE_NEAR( t.position( "bob"_n ).pending_rewards.amount, units(637.5), 1 );
+}
+
+TEST_CASE(late_staker_only_earns_from_when_they_staked){
+  fusion_tester t;
+  t.stake( "alice"_n, wax(100) );
+
+  t.add_revenue( wax(1000) );
+  t.distribute();
+
+  t.advance( DAY / 2 );
+  t.stake( "bob"_n, wax(100) );
+  t.advance( DAY / 2 );
+
+  //alice had the first half to herself and shares the second half
+  REQUIRE_NEAR( t.position( "alice"_n ).pending_rewards.amount, units(637.5), 1 );
+  REQUIRE_NEAR( t.position( "bob"_n ).pending_rewards.amount, units(212.5), 1 );
+}
+
+TEST_CASE(leftover_rewards_carry_into_the_next_period){
+  fusion_tester t;
+  t.stake( "alice"_n, wax(100) );
+
+  //distributing half an interval late means the period ends half an interval after the next distribution
+  t.add_revenue( wax(1000) );
+  t.advance( DAY / 2 );
+  t.distribute();
+
+  //the next distribution has no revenue, and restarts the stream with what is left
+  t.distribute();
+
+  const rewards rw = t.get_rewards();
+  REQUIRE_NEAR( rw.rewards_remaining.amount, units(425), 1 );
+  REQUIRE_EQ( rw.period_finish, uint64_t( t.chain.now() + DAY ) );
+
+  t.advance( DAY );
+  REQUIRE_NEAR( t.position( "alice"_n ).pending_rewards.amount, units(850), 1 );
+}
+
+TEST_CASE(claimrewards_pays_streamed_wax){
+  fusion_tester t;
+  t.stake( "alice"_n, wax(100) );
+
+  t.add_revenue( wax(1000) );
+  t.distribute();
+  t.advance( DAY );
+
+  const int64_t pending = t.position( "alice"_n ).pending_rewards.amount;
+  REQUIRE_NEAR( pending, units(850), 1 );
+
+  t.chain.push( "alice"_n, FUSION, "claimrewards"_n, "alice"_n );
+
+  REQUIRE_EQ( t.balance( WAX_CONTRACT, "alice"_n, WAX_SYMBOL ).amount, pending );
+  REQUIRE_EQ( t.get_staker( "alice"_n )->claimable_wax, wax(0) );
+  REQUIRE_EQ( t.get_state().user_funds_bucket.amount, units(850) - pending );
+  REQUIRE_EQ( t.get_state3().total_claimable_wax, wax(0) );
+
+  REQUIRE_THROWS_WITH( t.chain.push( "alice"_n, FUSION, "claimrewards"_n, "alice"_n ), "you have nothing to claim" );
+}
+
+TEST_CASE(claimswax_compounds_streamed_wax){
+  fusion_tester t;
+  t.stake( "alice"_n, wax(100) );
+
+  t.add_revenue( wax(1000) );
+  t.distribute();
+  t.advance( DAY );
+
+  const int64_t pending = t.position( "alice"_n ).pending_rewards.amount;
+  t.chain.push( "alice"_n, FUSION, "claimswax"_n, "alice"_n );
+
+  REQUIRE_EQ( t.get_staker( "alice"_n )->swax_balance.amount, units(100) + pending );
+  REQUIRE_EQ( t.get_state().swax_currently_earning.amount, units(100) + pending );
+}
+
+TEST_CASE(distribution_writes_the_state_rings){
+  fusion_tester t;
+  t.stake( "alice"_n, wax(100) );
+  t.add_revenue( wax(1000) );
+  t.advance( DAY );
+  t.distribute();
+
+  //no synctvl since the fixture's, the distribution alone records the current totals
+  for( const snapshot_tier& tier : DEFAULT_SNAPSHOT_TIERS ){
+    state_ring_table ring_t( FUSION, tier.resolution_seconds );
+    auto itr = ring_t.find( ( t.chain.now() / tier.resolution_seconds ) % tier.capacity );
+    REQUIRE( itr != ring_t.end() );
+    REQUIRE_EQ( itr->timestamp / tier.resolution_seconds, uint64_t( t.chain.now() / tier.resolution_seconds ) );
+  }
+
+  state_ring_table half_hourly( FUSION, DEFAULT_SNAPSHOT_TIERS[0].resolution_seconds );
+  const auto latest = half_hourly.find( ( t.chain.now() / DEFAULT_SNAPSHOT_TIERS[0].resolution_seconds ) % DEFAULT_SNAPSHOT_TIERS[0].capacity );
+  REQUIRE_EQ( latest->timestamp, uint64_t( t.chain.now() ) );
+  REQUIRE_EQ( latest->total_wax_owed, t.get_state3().total_wax_owed );
+}
+
+int main(){ return test::run_all(); }
@@ -0,0 +1,40 @@
+#include "tester.hpp"
+
+/**
+* safe_math edge cases that can't be static_asserts because they fail a check
+*/
+
+TEST_CASE(mul_short_circuits_zero){
+  REQUIRE( safe_math::mul( 0, MAX_U128_VALUE ) == 0 );
+  REQUIRE( safe_math::mul( MAX_U128_VALUE, 0 ) == 0 );
+  REQUIRE( safe_math::muldiv( 0, MAX_U128_VALUE, 1 ) == 0 );
+}
+
+TEST_CASE(mul_checks_input_range){
+  REQUIRE( safe_math::mul( MAX_ASSET_AMOUNT_U64, MAX_ASSET_AMOUNT_U64 ) == (uint128_t) MAX_ASSET_AMOUNT_U64 * MAX_ASSET_AMOUNT_U64 );
+  REQUIRE_THROWS_WITH( safe_math::mul( MAX_ASSET_AMOUNT_U64 + 1, 1 ), "uint128_t multiplication input is outside of range" );
+  REQUIRE_THROWS_WITH( safe_math::mul( 1, MAX_ASSET_AMOUNT_U64 + 1 ), "uint128_t multiplication input is outside of range" );
+}
+
+TEST_CASE(muldiv_rejects_zero_divisor){
+  REQUIRE_THROWS_WITH( safe_math::muldiv( 1, 1, 0 ), "muldiv divisor can not be 0" );
+}
+
+TEST_CASE(muldiv_rounding){
+  REQUIRE( safe_math::muldiv( 10, 1, 3 ) == 3 );
+  REQUIRE( safe_math::muldiv( 10, 1, 3, safe_math::rounding::up ) == 4 );
+  REQUIRE( safe_math::muldiv( 9, 1, 3, safe_math::rounding::up ) == 3 );
+}
+
+TEST_CASE(narrowing_is_range_checked){
+  REQUIRE_EQ( safe_math::to_int64( MAX_ASSET_AMOUNT_U64 ), MAX_ASSET_AMOUNT );
+  REQUIRE_THROWS_WITH( safe_math::to_int64( (uint128_t) MAX_ASSET_AMOUNT_U64 + 1 ), "result is outside of the acceptable range" );
+
+  REQUIRE_EQ( safe_math::to_uint64( UINT64_MAX ), UINT64_MAX );
+  REQUIRE_THROWS_WITH( safe_math::to_uint64( (uint128_t) UINT64_MAX + 1 ), "result does not fit in uint64_t" );
+
+  //a product that doesn't fit an asset after dividing fails instead of wrapping
+  REQUIRE_THROWS_WITH( safe_math::to_int64( safe_math::muldiv( MAX_ASSET_AMOUNT_U64, MAX_ASSET_AMOUNT_U64, 2 ) ), "result is outside of the acceptable range" );
+}
+
+int main(){ return test::run_all(); }
@@ -0,0 +1,276 @@
+#include "tester.hpp"
+
+/**
+* POL WAX, incentives WAX and the sWAX supply are recorded in the settlements ledger
+* and only sent/issued to other contracts when settle runs
+* the running totals those and every other WAX movement update have to match the synctvl audit
+*/
+
+TEST_CASE(distribution_is_held_until_settle){
+  fusion_tester t;
+  t.stake( "alice"_n, wax(100) );
+  t.add_revenue( wax(1000) );
+  t.distribute();
+
+  const settlements st = t.get_settlements();
+  REQUIRE_EQ( st.pol_wax_pending, wax(70) );
+  REQUIRE_EQ( *st.incentives_wax_pending, wax(70) );
+  REQUIRE_EQ( st.lswax_pending_issue, lswax(0) );
+  REQUIRE_EQ( *st.swax_pending_issue, swax(100 + 850) );
+  REQUIRE_EQ( *st.swax_pending_retire, swax(0) );
+
+  //incentives aren't counted as lsWAX until they are liquified
+  REQUIRE_EQ( t.get_state().liquified_swax, lswax(0) );
+  REQUIRE_EQ( t.get_state2().incentives_bucket, lswax(0) );
+
+  //nothing has reached the other contracts yet
+  REQUIRE_EQ( t.balance( WAX_CONTRACT, POL_CONTRACT, WAX_SYMBOL ), wax(0) );
+  REQUIRE_EQ( t.supply( TOKEN_CONTRACT, SWAX_SYMBOL ), swax(0) );
+  REQUIRE_EQ( t.supply( TOKEN_CONTRACT, LSWAX_SYMBOL ), lswax(0) );
+
+  //pending pol WAX is still owed
+  REQUIRE_EQ( t.get_state3().total_wax_owed.amount, t.get_state().wax_available_for_rentals.amount
+    + t.get_state().user_funds_bucket.amount + st.pol_wax_pending.amount );
+}
+
+TEST_CASE(settle_sends_everything_in_the_ledger){
+  fusion_tester t;
+  t.stake( "alice"_n, wax(100) );
+  t.add_revenue( wax(1000) );
+  t.distribute();
+
+  REQUIRE_THROWS_WITH( t.settle(), "next settlement is not until" );
+
+  const settlements before = t.get_settlements();
+  const int64_t owed_before = t.get_state3().total_wax_owed.amount;
+
+  t.chain.set_time( uint32_t( before.next_settlement ) );
+  t.settle();
+
+  REQUIRE_EQ( t.balance( WAX_CONTRACT, POL_CONTRACT, WAX_SYMBOL ), wax(70) );
+  REQUIRE_EQ( t.supply( TOKEN_CONTRACT, SWAX_SYMBOL ).amount, before.swax_pending_issue->amount + before.incentives_wax_pending->amount );
+  REQUIRE_EQ( t.balance( TOKEN_CONTRACT, FUSION, SWAX_SYMBOL ), t.supply( TOKEN_CONTRACT, SWAX_SYMBOL ) );
+  REQUIRE_EQ( t.get_state3().total_wax_owed.amount, owed_before - units(70) );
+
+  //incentives were liquified at the settle rate
+  const state s = t.get_state();
+  const int64_t incentives_lswax = t.get_state2().incentives_bucket.amount;
+  REQUIRE( incentives_lswax > 0 );
+  REQUIRE_EQ( t.balance( TOKEN_CONTRACT, FUSION, LSWAX_SYMBOL ).amount, incentives_lswax );
+  REQUIRE_EQ( s.liquified_swax.amount, incentives_lswax );
+
+  const settlements after = t.get_settlements();
+  REQUIRE_EQ( after.pol_wax_pending, wax(0) );
+  REQUIRE_EQ( after.lswax_pending_issue, lswax(0) );
+  REQUIRE_EQ( *after.incentives_wax_pending, wax(0) );
+  REQUIRE_EQ( *after.swax_pending_issue, swax(0) );
+  REQUIRE_EQ( *after.swax_pending_retire, swax(0) );
+  REQUIRE_EQ( after.next_settlement, uint64_t( t.chain.now() + after.seconds_between_settlements ) );
+}
+
+TEST_CASE(settle_with_an_empty_ledger_sends_nothing){
+  fusion_tester t;
+
+  t.chain.set_time( uint32_t( t.get_settlements().next_settlement ) );
+  t.settle();
+
+  REQUIRE_EQ( t.supply( TOKEN_CONTRACT, SWAX_SYMBOL ), swax(0) );
+  REQUIRE_EQ( t.supply( TOKEN_CONTRACT, LSWAX_SYMBOL ), lswax(0) );
+  REQUIRE_EQ( t.balance( WAX_CONTRACT, POL_CONTRACT, WAX_SYMBOL ), wax(0) );
+}
+
+TEST_CASE(setsettleint_shortens_the_interval){
+  fusion_tester t;
+
+  REQUIRE_THROWS_WITH( t.chain.push( FUSION, FUSION, "setsettleint"_n, uint64_t(0) ), "settlement interval must be between" );
+
+  t.chain.push( FUSION, FUSION, "setsettleint"_n, uint64_t(60 * 60) );
+  REQUIRE_EQ( t.get_settlements().next_settlement, uint64_t( t.chain.now() + 60 * 60 ) );
+
+  t.stake( "alice"_n, wax(100) );
+  t.advance( 60 * 60 );
+  t.settle();
+
+  REQUIRE_EQ( t.supply( TOKEN_CONTRACT, SWAX_SYMBOL ), swax(100) );
+}
+
+/* the settlements row as initsettle wrote it before sWAX supply was tracked there */
+struct settlements_v0 {
+  eosio::asset      pol_wax_pending;
+  eosio::asset      lswax_pending_issue;
+  uint64_t          seconds_between_settlements;
+  uint64_t          next_settlement;
+};
+using settlements_singleton_v0 = eosio::singleton<"settlements"_n, settlements_v0>;
+
+TEST_CASE(legacy_settlements_row_is_extended){
+  fusion_tester t;
+
+  t.seed( [&]{
+    settlements_singleton_v0 settlements_s( FUSION, FUSION.value );
+    settlements_s.set( settlements_v0{ wax(0), lswax(0), 60 * 60, t.chain.now() + 60 * 60 }, FUSION );
+  });
+
+  const settlements legacy = t.get_settlements();
+  REQUIRE( !legacy.swax_pending_issue.has_value() );
+
+  //staking and unstaking record sWAX against the empty extensions
+  t.stake( "alice"_n, wax(100) );
+  REQUIRE_EQ( *t.get_settlements().swax_pending_issue, swax(100) );
+  REQUIRE_EQ( *t.get_settlements().swax_pending_retire, swax(0) );
+
+  t.advance( 60 * 60 );
+  t.settle();
+  REQUIRE_EQ( t.supply( TOKEN_CONTRACT, SWAX_SYMBOL ), swax(100) );
+}
+
+TEST_CASE(dashboard_shows_what_is_waiting_for_settle){
+  fusion_tester t;
+  t.stake( "alice"_n, wax(100) );
+  t.add_revenue( wax(1000) );
+  t.distribute();
+
+  const dashboard d = t.chain.read_only<dashboard>( FUSION, "getdashboard"_n );
+  const settlements st = t.get_settlements();
+
+  REQUIRE_EQ( d.version, DASHBOARD_VERSION );
+  REQUIRE_EQ( d.pol_wax_pending, wax(70) );
+  REQUIRE_EQ( d.lswax_pending_issue, st.lswax_pending_issue );
+  REQUIRE_EQ( d.incentives_wax_pending, wax(70) );
+  REQUIRE_EQ( d.swax_pending_issue, *st.swax_pending_issue );
+  REQUIRE_EQ( d.swax_pending_retire, swax(0) );
+  REQUIRE_EQ( d.next_settlement, st.next_settlement );
+
+  //token.fusion only catches up at the next settlement
+  REQUIRE_EQ( t.supply( TOKEN_CONTRACT, SWAX_SYMBOL ), swax(0) );
+  t.chain.set_time( uint32_t( d.next_settlement ) );
+  t.settle();
+  REQUIRE_EQ( t.supply( TOKEN_CONTRACT, SWAX_SYMBOL ).amount, d.swax_pending_issue.amount + d.incentives_wax_pending.amount );
+}
+
+TEST_CASE(lp_incentives_are_liquified_at_settle){
+  fusion_tester t;
+  t.stake( "alice"_n, wax(100) );
+  t.chain.push( "alice"_n, FUSION, "liquify"_n, "alice"_n, swax(100) );
+
+  t.fund( "sponsor"_n, wax(50) );
+  t.transfer( WAX_CONTRACT, "sponsor"_n, FUSION, wax(50), "lp_incentives" );
+
+  REQUIRE_EQ( *t.get_settlements().incentives_wax_pending, wax(50) );
+  REQUIRE_EQ( t.get_state().swax_currently_backing_lswax, swax(100) );
+
+  t.chain.set_time( uint32_t( t.get_settlements().next_settlement ) );
+  t.settle();
+
+  //1:1 since nothing has been distributed to lsWAX holders
+  REQUIRE_EQ( t.get_state2().incentives_bucket, lswax(50) );
+  REQUIRE_EQ( t.get_state().swax_currently_backing_lswax, swax(150) );
+  REQUIRE_EQ( t.get_state().liquified_swax, lswax(150) );
+  REQUIRE_EQ( t.supply( TOKEN_CONTRACT, LSWAX_SYMBOL ), lswax(150) );
+  REQUIRE_EQ( t.supply( TOKEN_CONTRACT, SWAX_SYMBOL ), swax(150) );
+}
+
+TEST_CASE(running_totals_are_not_floored){
+  fusion_tester t;
+  t.stake( "alice"_n, wax(100) );
+  t.add_revenue( wax(1000) );
+  t.distribute();
+
+  //a total that has drifted below what is owed stops the settle instead of being clamped to 0
+  t.seed( [&]{
+    state_singleton_3 state_s_3( FUSION, FUSION.value );
+    state3 s3 = state_s_3.get();
+    s3.total_wax_owed = wax(10);
+    state_s_3.set( s3, FUSION );
+  });
+
+  t.chain.set_time( uint32_t( t.get_settlements().next_settlement ) );
+  REQUIRE_THROWS_WITH( t.settle(), "subtraction would result in negative number" );
+
+  t.chain.push( FUSION, FUSION, "synctvl"_n, FUSION );
+  t.settle();
+  REQUIRE_EQ( t.balance( WAX_CONTRACT, POL_CONTRACT, WAX_SYMBOL ), wax(70) );
+}
+
+namespace {
+
+  /* runs the synctvl audit, which records how far each running total was from the recalculation and resets it */
+  audit audit_running_totals(fusion_tester& t){
+    t.chain.push( FUSION, FUSION, "synctvl"_n, FUSION );
+    return audit_singleton( FUSION, FUSION.value ).get();
+  }
+
+  /* a request in the current redemption window, with its WAX already moved from the rental pool */
+  void seed_matured_request(fusion_tester& t, eosio::name user, const eosio::asset& amount){
+    const uint64_t epoch_to_claim_from = t.get_state().last_epoch_start_time - config_singleton_3( FUSION, FUSION.value ).get().seconds_between_epochs;
+    t.seed( [&]{
+      requests_tbl requests_t( FUSION, user.value );
+      requests_t.emplace( user, [&](auto &_r){
+        _r.epoch_id = epoch_to_claim_from;
+        _r.wax_amount_requested = amount;
+      });
+
+      state_singleton states( FUSION, FUSION.value );
+      state s = states.get();
+      s.wax_for_redemption += amount;
+      s.wax_available_for_rentals -= amount;
+      states.set( s, FUSION );
+    });
+  }
+
+}
+
+#define REQUIRE_NO_DRIFT(t) do { \
+    const audit _a = audit_running_totals(t); \
+    REQUIRE_EQ( _a.tvl_drift, int64_t(0) ); \
+    REQUIRE_EQ( _a.wax_owed_drift, int64_t(0) ); \
+    REQUIRE_EQ( _a.wax_balance_drift, int64_t(0) ); \
+  } while(0)
+
+TEST_CASE(running_totals_match_the_audit){
+  fusion_tester t;
+  REQUIRE_NO_DRIFT(t);
+
+  t.stake( "alice"_n, wax(1000) );
+  t.stake( "bob"_n, wax(1000) );
+  REQUIRE_NO_DRIFT(t);
+
+  t.add_revenue( wax(100) );
+  t.distribute();
+  REQUIRE_NO_DRIFT(t);
+
+  t.chain.push( "bob"_n, FUSION, "instaredeem"_n, "bob"_n, swax(10) );
+  REQUIRE_NO_DRIFT(t);
+
+  //overpaid, so part of it is refunded
+  t.fund( "renter"_n, wax(20) );
+  t.transfer( WAX_CONTRACT, "renter"_n, FUSION, wax(20), "|rent_cpu|renter|100|" + std::to_string( INITIAL_EPOCH_START_TIMESTAMP ) + "|" );
+  REQUIRE_NO_DRIFT(t);
+
+  t.chain.push( FUSION, FUSION, "sync"_n, FUSION );
+  seed_matured_request( t, "alice"_n, wax(100) );
+  REQUIRE_NO_DRIFT(t);
+  t.chain.push( "alice"_n, FUSION, "redeem"_n, "alice"_n );
+  REQUIRE_NO_DRIFT(t);
+  REQUIRE_EQ( t.get_state().wax_for_redemption, wax(0) );
+
+  //the rented epoch covers 100 of the request, the rest is paid from the rental pool straight away
+  const state before = t.get_state();
+  const int64_t retire_before = t.get_settlements().swax_pending_retire->amount;
+  const eosio::asset bob_wax = t.balance( WAX_CONTRACT, "bob"_n, WAX_SYMBOL );
+  t.chain.push( "bob"_n, FUSION, "reqredeem"_n, "bob"_n, swax(150), true );
+  REQUIRE_NO_DRIFT(t);
+  REQUIRE_EQ( t.balance( WAX_CONTRACT, "bob"_n, WAX_SYMBOL ), bob_wax + wax(50) );
+  REQUIRE_EQ( t.get_state().swax_currently_earning.amount, before.swax_currently_earning.amount - units(50) );
+  REQUIRE_EQ( t.get_settlements().swax_pending_retire->amount, retire_before + units(50) );
+
+  t.advance( 60 * 60 * 24 );
+  t.chain.push( "alice"_n, FUSION, "claimrewards"_n, "alice"_n );
+  REQUIRE_NO_DRIFT(t);
+
+  t.chain.set_time( uint32_t( t.get_settlements().next_settlement ) );
+  t.settle();
+  REQUIRE_NO_DRIFT(t);
+}
+
+int main(){ return test::run_all(); }
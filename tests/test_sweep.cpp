@@ -0,0 +1,123 @@
+#include "tester.hpp"
+
+/**
+* sweepstakers settles the pre-streaming snapshot rewards of stakers who
+* haven't synced since streaming started
+*/
+
+static constexpr uint32_t DAY = 60 * 60 * 24;
+
+/**
+* one legacy snapshot paying 100 WAX to 200 earning sWAX the day before streaming started
+* alice (claimable route) and bob (compound route) each had 100 sWAX earning, carol has nothing staked
+*/
+static uint64_t seed_dormant_stakers(fusion_tester& t){
+  const uint64_t streaming_start_time = t.get_rewards().streaming_start_time;
+  for( const eosio::name user : { "alice"_n, "bob"_n, "carol"_n } ) t.chain.create_account(user);
+
+  t.seed( [&]{
+    snaps_table snaps_t( FUSION, FUSION.value );
+    snaps_t.emplace( FUSION, [&](auto &_snap){
+      _snap.timestamp = streaming_start_time - DAY;
+      _snap.swax_earning_bucket = wax(100);
+      _snap.lswax_autocompounding_bucket = wax(0);
+      _snap.pol_bucket = wax(0);
+      _snap.ecosystem_bucket = wax(0);
+      _snap.total_distributed = wax(100);
+      _snap.total_swax_earning = swax(200);
+    });
+
+    staker_table staker_t( FUSION, FUSION.value );
+    for( const auto& [user, balance, route] : { std::tuple{ "alice"_n, swax(100), REWARD_ROUTE_CLAIMABLE_WAX },
+                                                std::tuple{ "bob"_n, swax(100), REWARD_ROUTE_COMPOUND_SWAX },
+                                                std::tuple{ "carol"_n, swax(0), REWARD_ROUTE_CLAIMABLE_WAX } } ){
+      staker_t.emplace( user, [&](auto &_s){
+        _s.wallet = user;
+        _s.swax_balance = balance;
+        _s.claimable_wax = wax(0);
+        _s.last_update = streaming_start_time - 2 * DAY;
+        _s.reward_per_swax_paid_1e12 = 0;
+        _s.reward_route = route;
+      });
+    }
+
+    state_singleton states( FUSION, FUSION.value );
+    state s = states.get();
+    s.swax_currently_earning = swax(200);
+    s.user_funds_bucket = wax(100);
+    states.set( s, FUSION );
+  });
+
+  //bring the running totals in line with the seeded rows
+  t.chain.push( FUSION, FUSION, "synctvl"_n, FUSION );
+  return streaming_start_time;
+}
+
+static prunestate get_prune_state(fusion_tester& t){
+  return prunestate_singleton( FUSION, FUSION.value ).get();
+}
+
+TEST_CASE(sweep_pays_dormant_claimable_stakers){
+  fusion_tester t;
+  const uint64_t streaming_start_time = seed_dormant_stakers(t);
+
+  t.chain.push( FUSION, FUSION, "sweepstakers"_n, 10 );
+
+  const stakers alice = *t.get_staker( "alice"_n );
+  REQUIRE_EQ( alice.claimable_wax, wax(50) );
+  REQUIRE_EQ( alice.last_update, streaming_start_time );
+
+  //bob's rewards are compounded on his next sync instead
+  const stakers bob = *t.get_staker( "bob"_n );
+  REQUIRE_EQ( bob.claimable_wax, wax(0) );
+  REQUIRE_EQ( bob.last_update, streaming_start_time - 2 * DAY );
+
+  REQUIRE_EQ( t.get_state().user_funds_bucket, wax(50) );
+  REQUIRE_EQ( t.get_state3().total_claimable_wax, wax(50) );
+  REQUIRE_EQ( get_prune_state(t).next_sweep, uint64_t(0) );
+}
+
+TEST_CASE(sweep_resumes_where_it_stopped){
+  fusion_tester t;
+  seed_dormant_stakers(t);
+
+  t.chain.push( FUSION, FUSION, "sweepstakers"_n, 1 );
+  REQUIRE_EQ( t.get_staker( "alice"_n )->claimable_wax, wax(50) );
+  REQUIRE_EQ( get_prune_state(t).next_sweep, "bob"_n.value );
+
+  t.chain.push( FUSION, FUSION, "sweepstakers"_n, 1 );
+  REQUIRE_EQ( get_prune_state(t).next_sweep, "carol"_n.value );
+
+  t.chain.push( FUSION, FUSION, "sweepstakers"_n, 1 );
+  REQUIRE_EQ( get_prune_state(t).next_sweep, uint64_t(0) );
+  REQUIRE_EQ( t.get_staker( "alice"_n )->claimable_wax, wax(50) );
+}
+
+TEST_CASE(swept_rewards_are_not_paid_twice){
+  fusion_tester t;
+  seed_dormant_stakers(t);
+
+  t.chain.push( FUSION, FUSION, "sweepstakers"_n, 10 );
+
+  //swept rows start at streaming_start_time, so they aren't dormant for the second sweep
+  const uint64_t streaming_start_time = t.get_rewards().streaming_start_time;
+  REQUIRE_EQ( t.get_staker( "alice"_n )->last_update, streaming_start_time );
+  t.chain.push( FUSION, FUSION, "sweepstakers"_n, 10 );
+  REQUIRE_EQ( t.get_staker( "alice"_n )->claimable_wax, wax(50) );
+  REQUIRE_EQ( t.get_staker( "alice"_n )->last_update, streaming_start_time );
+
+  //syncing afterwards doesn't pay the snapshot again either
+  REQUIRE_EQ( t.position( "alice"_n ).pending_rewards, wax(0) );
+  t.chain.push( "alice"_n, FUSION, "stake"_n, "alice"_n );
+  REQUIRE_EQ( t.get_staker( "alice"_n )->claimable_wax, wax(50) );
+  REQUIRE_EQ( t.get_state().user_funds_bucket, wax(50) );
+}
+
+TEST_CASE(sweep_limit_is_checked){
+  fusion_tester t;
+
+  REQUIRE_THROWS_WITH( t.chain.push( FUSION, FUSION, "sweepstakers"_n, 0 ), "limit must be between 1 and 50" );
+  REQUIRE_THROWS_WITH( t.chain.push( FUSION, FUSION, "sweepstakers"_n, 51 ), "limit must be between 1 and 50" );
+}
+
+int main(){ return test::run_all(); }
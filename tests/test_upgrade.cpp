@@ -0,0 +1,101 @@
+#include "tester.hpp"
+
+/**
+* rows and singletons written before the streaming rewards upgrade
+* - staker rows without reward_per_swax_paid_1e12/reward_route
+* - no rewards singleton until initrewards is called
+*/
+
+static constexpr uint32_t DAY = 60 * 60 * 24;
+
+/* a staker row as it was written before the binary extensions were added */
+struct stakers_v0 {
+  eosio::name       wallet;
+  eosio::asset      swax_balance;
+  eosio::asset      claimable_wax;
+  uint64_t          last_update;
+
+  uint64_t primary_key() const { return wallet.value; }
+};
+using staker_table_v0 = eosio::multi_index<"stakers"_n, stakers_v0>;
+
+/* alice staked 100 WAX the day before streaming started and paid for her own row */
+static void seed_legacy_staker(fusion_tester& t){
+  const uint64_t streaming_start_time = t.get_rewards().streaming_start_time;
+  t.chain.create_account( "alice"_n );
+
+  t.seed( [&]{
+    staker_table_v0 staker_t( FUSION, FUSION.value );
+    staker_t.emplace( "alice"_n, [&](auto &_s){
+      _s.wallet = "alice"_n;
+      _s.swax_balance = swax(100);
+      _s.claimable_wax = wax(0);
+      _s.last_update = streaming_start_time - DAY;
+    });
+
+    state_singleton states( FUSION, FUSION.value );
+    state s = states.get();
+    s.swax_currently_earning = swax(100);
+    s.wax_available_for_rentals = wax(100);
+    states.set( s, FUSION );
+  });
+
+  t.chain.push( FUSION, FUSION, "synctvl"_n, FUSION );
+}
+
+TEST_CASE(legacy_staker_can_stake_with_a_transfer){
+  fusion_tester t;
+  seed_legacy_staker(t);
+  REQUIRE_EQ( t.staker_payer( "alice"_n ), "alice"_n );
+
+  //the transfer notification syncs alice, which can't bill her for the extensions
+  t.fund( "alice"_n, wax(50) );
+  t.transfer( WAX_CONTRACT, "alice"_n, FUSION, wax(50), "stake" );
+
+  const stakers staker = *t.get_staker( "alice"_n );
+  REQUIRE_EQ( staker.swax_balance, swax(150) );
+  REQUIRE( staker.reward_route.has_value() );
+  REQUIRE_EQ( t.staker_payer( "alice"_n ), FUSION );
+}
+
+TEST_CASE(legacy_staker_is_swept_at_the_contracts_expense){
+  fusion_tester t;
+  seed_legacy_staker(t);
+
+  t.chain.push( FUSION, FUSION, "sweepstakers"_n, 10 );
+  REQUIRE_EQ( t.staker_payer( "alice"_n ), FUSION );
+
+  //rows that already have the extensions keep their payer
+  t.chain.push( "alice"_n, FUSION, "stake"_n, "alice"_n );
+  t.chain.push( FUSION, FUSION, "sweepstakers"_n, 10 );
+  REQUIRE_EQ( t.staker_payer( "alice"_n ), FUSION );
+}
+
+TEST_CASE(new_staker_rows_are_paid_by_the_staker){
+  fusion_tester t;
+  t.stake( "bob"_n, wax(100) );
+  t.stake( "bob"_n, wax(100) );
+
+  REQUIRE_EQ( t.staker_payer( "bob"_n ), "bob"_n );
+}
+
+TEST_CASE(staking_works_before_initrewards){
+  fusion_tester t( false );
+  REQUIRE( !rewards_singleton( FUSION, FUSION.value ).exists() );
+
+  t.stake( "alice"_n, wax(100) );
+  REQUIRE_EQ( t.get_staker( "alice"_n )->swax_balance, swax(100) );
+
+  //the first sync saved the defaults initrewards would have written
+  const rewards rw = t.get_rewards();
+  REQUIRE_EQ( rw.streaming_start_time, t.get_state().next_distribution );
+  REQUIRE_EQ( rw.rewards_remaining, wax(0) );
+  REQUIRE_THROWS_WITH( t.chain.push( FUSION, FUSION, "initrewards"_n ), "Rewards already exists" );
+
+  t.add_revenue( wax(1000) );
+  t.distribute();
+  t.advance( DAY );
+  REQUIRE_NEAR( t.position( "alice"_n ).pending_rewards.amount, units(850), 1 );
+}
+
+int main(){ return test::run_all(); }
@@ -0,0 +1,242 @@
+#pragma once
+
+/**
+* fusion_tester sets up a fresh host chain for each test, with
+* - eosio.token (WAX) and token.fusion (LSWAX, SWAX)
+* - stand-ins for swap.alcor, pol.fusion and the cpu contracts
+* - dapp.fusion, initialized the same way it was on chain, followed by a synctvl
+* and the clock a few hours after INITIAL_EPOCH_START_TIMESTAMP
+*
+* tests are registered with TEST_CASE and run by test::run_all() from each file's main
+*/
+
+#include <cstdio>
+#include <exception>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "fusion.hpp"
+
+#include "chain.hpp"
+#include "standins.hpp"
+#include "host/fusion_contract.hpp"
+
+namespace test {
+
+  struct failure : std::runtime_error {
+    using std::runtime_error::runtime_error;
+  };
+
+  struct test_case {
+    const char*   name;
+    void          (*run)();
+  };
+
+  inline std::vector<test_case>& registry(){
+    static std::vector<test_case> tests;
+    return tests;
+  }
+
+  struct registrar {
+    registrar(const char* name, void (*run)()){ registry().push_back( test_case{ name, run } ); }
+  };
+
+  inline std::string describe(const eosio::asset& a){ return a.to_string(); }
+  inline std::string describe(const eosio::name& n){ return n.to_string(); }
+  inline std::string describe(const std::string& s){ return s; }
+  inline std::string describe(const char* s){ return s; }
+  inline std::string describe(const bool& b){ return b ? "true" : "false"; }
+
+  template<typename T>
+  std::enable_if_t<std::is_integral_v<T>, std::string> describe(const T& v){
+    if constexpr( std::is_same_v<T, uint128_t> || std::is_same_v<T, int128_t> ){
+      std::string s;
+      uint128_t u = v < 0 ? uint128_t( -v ) : uint128_t( v );
+      do { s.insert( s.begin(), char( '0' + int( u % 10 ) ) ); u /= 10; } while( u > 0 );
+      if( v < 0 ) s.insert( s.begin(), '-' );
+      return s;
+    } else {
+      return std::to_string(v);
+    }
+  }
+
+  [[noreturn]] inline void fail(const char* file, int line, const std::string& message){
+    throw failure( std::string(file) + ":" + std::to_string(line) + ": " + message );
+  }
+
+  inline int run_all(){
+    int failed = 0;
+
+    for( const test_case& t : registry() ){
+      try {
+        t.run();
+        std::printf( "ok    %s\n", t.name );
+      } catch( const std::exception& e ){
+        std::printf( "FAIL  %s\n      %s\n", t.name, e.what() );
+        failed ++;
+      }
+    }
+
+    std::printf( "%d/%d passed\n", int( registry().size() ) - failed, int( registry().size() ) );
+    return failed == 0 ? 0 : 1;
+  }
+
+}
+
+#define TEST_CASE(test_name) \
+  static void test_name(); \
+  static const test::registrar test_name##_registrar( #test_name, &test_name ); \
+  static void test_name()
+
+#define REQUIRE(condition) \
+  do { if( !( condition ) ) test::fail( __FILE__, __LINE__, "REQUIRE( " #condition " ) failed" ); } while(0)
+
+/* both sides are copied, so a member of a temporary (get_staker( ... )->swax_balance) outlives the statement */
+#define REQUIRE_EQ(actual, expected) \
+  do { \
+    const auto _actual = ( actual ); \
+    const auto _expected = ( expected ); \
+    if( !( _actual == _expected ) ) \
+      test::fail( __FILE__, __LINE__, "REQUIRE_EQ( " #actual ", " #expected " ) failed: " + test::describe(_actual) + " != " + test::describe(_expected) ); \
+  } while(0)
+
+/* integer amounts that are allowed to be off by rounding */
+#define REQUIRE_NEAR(actual, expected, tolerance) \
+  do { \
+    const int64_t _actual = ( actual ); \
+    const int64_t _expected = ( expected ); \
+    if( _actual > _expected + ( tolerance ) || _actual < _expected - ( tolerance ) ) \
+      test::fail( __FILE__, __LINE__, "REQUIRE_NEAR( " #actual ", " #expected " ) failed: " + std::to_string(_actual) + " != " + std::to_string(_expected) ); \
+  } while(0)
+
+#define REQUIRE_THROWS_WITH(expression, message) \
+  do { \
+    bool _threw = false; \
+    try { expression; } catch( const eosio::check_failure& e ){ \
+      _threw = true; \
+      if( std::string( e.what() ).find( message ) == std::string::npos ) \
+        test::fail( __FILE__, __LINE__, #expression " threw \"" + std::string( e.what() ) + "\", expected \"" + std::string( message ) + "\"" ); \
+    } \
+    if( !_threw ) test::fail( __FILE__, __LINE__, #expression " did not throw" ); \
+  } while(0)
+
+static constexpr eosio::name FUSION = "dapp.fusion"_n;
+
+/* 1 WAX/sWAX/lsWAX in token units */
+constexpr int64_t units(double whole){ return int64_t( whole * ONE_SWAX_AMOUNT ); }
+
+inline eosio::asset wax(double whole){ return eosio::asset( units(whole), WAX_SYMBOL ); }
+inline eosio::asset swax(double whole){ return eosio::asset( units(whole), SWAX_SYMBOL ); }
+inline eosio::asset lswax(double whole){ return eosio::asset( units(whole), LSWAX_SYMBOL ); }
+
+class fusion_tester {
+  public:
+    ::host::chain chain;
+
+    /* init_rewards = false leaves the contract as it was before the rewards singleton existed */
+    explicit fusion_tester(bool init_rewards = true){
+      chain.set_time( INITIAL_EPOCH_START_TIMESTAMP + 60 * 60 * 6 );
+
+      ::host::deploy_token( chain, WAX_CONTRACT, ::host::token::flavour::eosio_token );
+      ::host::deploy_token( chain, TOKEN_CONTRACT, ::host::token::flavour::fusion_token );
+      ::host::deploy_alcor( chain, ALCOR_CONTRACT );
+
+      for( const eosio::name account : { POL_CONTRACT, "cpu1.fusion"_n, "cpu2.fusion"_n, "cpu3.fusion"_n } ){
+        ::host::deploy_passive( chain, account );
+      }
+
+      ::host::deploy_fusion( chain, FUSION );
+      chain.create_account( REVENUE );
+
+      chain.push( WAX_CONTRACT, WAX_CONTRACT, "create"_n, SYSTEM_CONTRACT, eosio::asset( MAX_ASSET_AMOUNT, WAX_SYMBOL ) );
+      chain.push( TOKEN_CONTRACT, TOKEN_CONTRACT, "create"_n, FUSION, eosio::asset( MAX_ASSET_AMOUNT, LSWAX_SYMBOL ) );
+      chain.push( TOKEN_CONTRACT, TOKEN_CONTRACT, "create"_n, FUSION, eosio::asset( MAX_ASSET_AMOUNT, SWAX_SYMBOL ) );
+
+      chain.as( POL_CONTRACT, []{
+        pol_contract::state_singleton_2 pol_state( POL_CONTRACT, POL_CONTRACT.value );
+        pol_state.set( pol_contract::state2{ ZERO_WAX, ZERO_WAX }, POL_CONTRACT );
+      });
+
+      for( const eosio::name init : { "initconfig"_n, "initconfig3"_n, "initstate2"_n, "initstate3"_n, "initsettle"_n } ){
+        chain.push( FUSION, FUSION, init );
+      }
+      if( init_rewards ) chain.push( FUSION, FUSION, "initrewards"_n );
+
+      chain.push( FUSION, FUSION, "synctvl"_n, FUSION );
+    }
+
+    static constexpr eosio::name REVENUE = "revenue"_n;
+
+    /* gives user WAX from the system account, creating the account if needed */
+    void fund(eosio::name user, const eosio::asset& quantity){
+      if( !chain.account_exists(user) ) chain.create_account(user);
+      chain.push( SYSTEM_CONTRACT, WAX_CONTRACT, "issue"_n, SYSTEM_CONTRACT, quantity, std::string("") );
+      chain.push( SYSTEM_CONTRACT, WAX_CONTRACT, "transfer"_n, SYSTEM_CONTRACT, user, quantity, std::string("") );
+    }
+
+    void transfer(eosio::name token_contract, eosio::name from, eosio::name to, const eosio::asset& quantity, const std::string& memo){
+      chain.push( from, token_contract, "transfer"_n, from, to, quantity, memo );
+    }
+
+    /* opens a staker row if needed and stakes quantity of WAX */
+    void stake(eosio::name user, const eosio::asset& quantity){
+      fund( user, quantity );
+      chain.push( user, FUSION, "stake"_n, user );
+      transfer( WAX_CONTRACT, user, FUSION, quantity, "stake" );
+    }
+
+    void add_revenue(const eosio::asset& quantity){
+      fund( REVENUE, quantity );
+      transfer( WAX_CONTRACT, REVENUE, FUSION, quantity, "waxfusion_revenue" );
+    }
+
+    /* moves to the next distribution time and distributes */
+    void distribute(){
+      const uint64_t next = get_state().next_distribution;
+      if( chain.now() < next ) chain.set_time( uint32_t( next ) );
+      chain.push( REVENUE, FUSION, "distribute"_n );
+    }
+
+    void settle(){
+      chain.push( REVENUE, FUSION, "settle"_n );
+    }
+
+    void advance(uint32_t seconds){ chain.advance(seconds); }
+
+    state get_state() const { return state_singleton( FUSION, FUSION.value ).get(); }
+    state2 get_state2() const { return state_singleton_2( FUSION, FUSION.value ).get(); }
+    state3 get_state3() const { return state_singleton_3( FUSION, FUSION.value ).get(); }
+    rewards get_rewards() const { return rewards_singleton( FUSION, FUSION.value ).get(); }
+    settlements get_settlements() const { return settlements_singleton( FUSION, FUSION.value ).get(); }
+
+    /* the account paying for user's staker row */
+    eosio::name staker_payer(eosio::name user) const {
+      return chain.rows( FUSION, FUSION.value, "stakers"_n ).at( user.value ).payer;
+    }
+
+    std::optional<stakers> get_staker(eosio::name user) const {
+      staker_table staker_t( FUSION, FUSION.value );
+      auto itr = staker_t.find( user.value );
+      if( itr == staker_t.end() ) return std::nullopt;
+      return *itr;
+    }
+
+    staker_position position(eosio::name user){
+      return chain.read_only<staker_position>( FUSION, "getposition"_n, user );
+    }
+
+    eosio::asset balance(eosio::name token_contract, eosio::name owner, eosio::symbol sym) const {
+      return ::host::token::balance( token_contract, owner, sym );
+    }
+
+    eosio::asset supply(eosio::name token_contract, eosio::symbol sym) const {
+      return ::host::token::supply( token_contract, sym );
+    }
+
+    /* runs f as code in dapp.fusion, for seeding rows that can't be created through actions anymore */
+    template<typename F>
+    void seed(F&& f){ chain.as( FUSION, std::forward<F>(f) ); }
+};